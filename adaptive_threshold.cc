@@ -9,6 +9,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>
 
 /******************************************************************************/
@@ -28,6 +31,10 @@
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img;  			 		// input image object
   IplImage* grayImg = NULL;  		// tmp image object
   IplImage* thresholdedImg = NULL;  // output image object
@@ -57,23 +64,23 @@ int main( int argc, char** argv )
     {
       // create window objects
 
-      cvNamedWindow(windowName1, 1 );
-      cvNamedWindow(windowName2, 1 );
+      ipcv_named_window(windowName1, 1 );
+      ipcv_named_window(windowName2, 1 );
 
 	  // add adjustable trackbar for threshold parameter
 
-      cvCreateTrackbar("Neighbourhood (N)", windowName1, &windowSize, 255, NULL);
-	  cvCreateTrackbar("Constant (C)", windowName1, &constant, 50, NULL);
+      ipcv_create_trackbar("Neighbourhood (N)", windowName1, &windowSize, 255, NULL);
+	  ipcv_create_trackbar("Constant (C)", windowName1, &constant, 50, NULL);
 
 	  // if capture object in use (i.e. video/camera)
 	  // get initial image from capture object
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -103,10 +110,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -121,6 +128,7 @@ int main( int argc, char** argv )
 		  // if input is not already grayscale, convert to grayscale
 
 		  if (img->nChannels > 1){
+			 IpcvScopedTimer timer(IPCV_TIMING_CONVERT);
 			 cvCvtColor(img, grayImg, CV_BGR2GRAY);
 	      } else {
 			grayImg = img;
@@ -128,7 +136,7 @@ int main( int argc, char** argv )
 
 		  // display image in window
 
-		  cvShowImage( windowName2, grayImg );
+		  ipcv_show_image( windowName2, grayImg );
 
 		  // check that the window size is always odd and > 3
 
@@ -140,18 +148,22 @@ int main( int argc, char** argv )
 
 		  // threshold the image
 
+		  int64 processStart = ipcv_timing_start(); // (timing of thresholding)
+
 		  cvAdaptiveThreshold(grayImg, thresholdedImg, 255,
 		  						CV_ADAPTIVE_THRESH_MEAN_C, CV_THRESH_BINARY,
 		  						windowSize, constant);
 
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 		  // display image in window
 
-		  cvShowImage( windowName1, thresholdedImg );
+		  ipcv_show_image( windowName1, thresholdedImg );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 40ms per frame
 
-		  key = cvWaitKey(EVENT_LOOP_DELAY);
+		  key = ipcv_wait_key(EVENT_LOOP_DELAY);
 
 		  if (key == 'x'){
 
@@ -165,7 +177,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
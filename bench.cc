@@ -0,0 +1,1116 @@
+// Example : benchmark of the core operations of the examples on fixed inputs
+// usage: prog [--min-time <ms>] [--ops <op>[,<op> ...]]
+//             [--resolutions <res>[,<res> ...]] {<image_name> | <video_name>}
+// e.g.   prog --ops canny,sobel --resolutions vga,1080p video.avi
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: each operation is run (with the default parameters of its example)
+// on a fixed synthetic scene and, if one is given, on the first frame of a
+// recorded image / video, at each resolution (vga, 720p, 1080p, 4k) - without
+// any GUI or camera. Each is repeated for at least --min-time ms (default
+// 500) and the time per frame is reported as ms, ns/pixel and frames/sec
+// (one CSV line per operation / input / resolution) so that runs can be
+// compared for regressions and between alternative implementations (e.g. the
+// real input and complex DFT paths of butterworth_lowpass{_complex})
+
+#include "cv.h"       // open cv general include file
+#include "highgui.h"  // open cv GUI include file
+
+#include "ipcv_interface.h" // shared command line options
+#include "ipcv_frame_source.h" // frame source (image, video)
+#include "ipcv_stage.h" // uniform processing stages
+#include "ipcv_dft.h" // shared DFT functions
+#include "ipcv_template.h" // template matcher (spatial / FFT)
+#include "ipcv_camshift.h" // region restricted hue / CAMSHIFT functions
+#include "ipcv_gallery.h" // gallery of normalised histograms
+#include "ipcv_histogram.h" // joint colour histogram
+#include "ipcv_ann.h" // nearest neighbour index of histograms
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm> // contains max() function (amongst others)
+using namespace cv; // use c++ namespace so the timing stuff works consistently
+
+/******************************************************************************/
+
+// resolutions benchmarked
+
+struct Resolution
+{
+	const char* name;
+	int width, height;
+};
+
+static const Resolution resolutions[] =
+{
+	{ "vga",   640,  480  },
+	{ "720p",  1280, 720  },
+	{ "1080p", 1920, 1080 },
+	{ "4k",    3840, 2160 }
+};
+
+#define N_RESOLUTIONS ((int) (sizeof(resolutions) / sizeof(resolutions[0])))
+
+/******************************************************************************/
+
+// a fixed (seeded) synthetic BGR scene - gradient background, filled shapes
+// and lines (giving edges, circles, lines and coloured regions to find) and
+// mild noise
+
+static IplImage* create_synthetic_frame(CvSize size)
+{
+	IplImage* img = cvCreateImage(size, IPL_DEPTH_8U, 3);
+	CvRNG rng = cvRNG(0x1234);
+
+	for (int y = 0; y < size.height; y++)
+	{
+		uchar* row = (uchar*) (img->imageData + (y * img->widthStep));
+		for (int x = 0; x < size.width; x++)
+		{
+			row[(x * 3)] = (uchar) ((255 * x) / size.width);
+			row[(x * 3) + 1] = (uchar) ((255 * y) / size.height);
+			row[(x * 3) + 2] = (uchar) (128 + ((x - y) % 64));
+		}
+	}
+
+	// shapes scaled with the image (so each resolution is the same scene)
+
+	double s = size.width / 640.0;
+
+	for (int i = 0; i < 12; i++)
+	{
+		CvPoint centre = cvPoint(cvRandInt(&rng) % size.width,
+								 cvRandInt(&rng) % size.height);
+		int radius = cvRound((25 + (cvRandInt(&rng) % 60)) * s);
+		cvCircle(img, centre, radius, CV_RGB(cvRandInt(&rng) % 256,
+				 cvRandInt(&rng) % 256, cvRandInt(&rng) % 256), -1, 8, 0);
+	}
+	for (int i = 0; i < 8; i++)
+	{
+		CvPoint pt1 = cvPoint(cvRandInt(&rng) % size.width,
+							  cvRandInt(&rng) % size.height);
+		CvPoint pt2 = cvPoint(pt1.x + cvRound((20 + (cvRandInt(&rng) % 100)) * s),
+							  pt1.y + cvRound((20 + (cvRandInt(&rng) % 100)) * s));
+		cvRectangle(img, pt1, pt2, CV_RGB(cvRandInt(&rng) % 256,
+					cvRandInt(&rng) % 256, cvRandInt(&rng) % 256), -1, 8, 0);
+	}
+	for (int i = 0; i < 8; i++)
+	{
+		cvLine(img, cvPoint(cvRandInt(&rng) % size.width, 0),
+			   cvPoint(cvRandInt(&rng) % size.width, size.height - 1),
+			   CV_RGB(255, 255, 255), std::max(1, cvRound(2 * s)), 8, 0);
+	}
+
+	IplImage* noise = cvCreateImage(size, IPL_DEPTH_8U, 3);
+	cvRandArr(&rng, noise, CV_RAND_NORMAL, cvScalarAll(0), cvScalarAll(4));
+	cvAdd(img, noise, img, NULL);
+	cvReleaseImage(&noise);
+
+	return img;
+}
+
+/******************************************************************************/
+
+// benchmark operations not available as processing stages (see ipcv_stage.h)
+// - each is the core of the corresponding example with its default settings
+
+// watershed segmentation seeded from canny contours (watershed_segmentation.cc)
+
+class WatershedBench : public ProcessingStage
+{
+public:
+	WatershedBench() : gray(NULL), edges(NULL), markers(NULL),
+		storage(cvCreateMemStorage(0)) {}
+	~WatershedBench()
+	{
+		if (gray) { cvReleaseImage(&gray); }
+		if (edges) { cvReleaseImage(&edges); }
+		if (markers) { cvReleaseImage(&markers); }
+		cvReleaseMemStorage(&storage);
+	}
+
+	IplImage* process(IplImage* frame)
+	{
+		CvSeq* contours = NULL;
+		reuse_image(&gray, cvGetSize(frame), IPL_DEPTH_8U, 1, frame->origin);
+		reuse_image(&edges, cvGetSize(frame), IPL_DEPTH_8U, 1, frame->origin);
+		reuse_image(&markers, cvGetSize(frame), IPL_DEPTH_32S, 1, frame->origin);
+
+		cvCvtColor(frame, gray, CV_BGR2GRAY);
+		cvCanny(gray, edges, 50, 200, 3);
+		cvFindContours(edges, storage, &contours, sizeof(CvContour),
+						CV_RETR_CCOMP, CV_CHAIN_APPROX_SIMPLE, cvPoint(0,0));
+		cvZero(markers);
+		int comp_count = 0;
+		for( ; contours != 0; contours = contours->h_next, comp_count++ )
+		{
+			cvDrawContours(markers, contours, cvScalarAll(comp_count+1),
+							cvScalarAll(comp_count+1), -1, -1, 8, cvPoint(0,0));
+		}
+		cvClearMemStorage(storage);
+
+		cvWatershed(frame, markers);
+		return markers;
+	}
+	const char* name() const { return "watershed"; }
+
+private:
+	IplImage* gray;
+	IplImage* edges;
+	IplImage* markers;
+	CvMemStorage* storage;
+};
+
+/******************************************************************************/
+
+// hough line / circle detection (hough_lines.cc / hough_circles.cc)
+
+class HoughBench : public ProcessingStage
+{
+public:
+	HoughBench(bool isCircles) : circles(isCircles), gray(NULL), edges(NULL),
+		storage(cvCreateMemStorage(0)) {}
+	~HoughBench()
+	{
+		if (gray) { cvReleaseImage(&gray); }
+		if (edges) { cvReleaseImage(&edges); }
+		cvReleaseMemStorage(&storage);
+	}
+
+	IplImage* process(IplImage* frame)
+	{
+		reuse_image(&gray, cvGetSize(frame), IPL_DEPTH_8U, 1, frame->origin);
+		cvCvtColor(frame, gray, CV_BGR2GRAY);
+
+		if (circles) {
+			cvHoughCircles(gray, storage, CV_HOUGH_GRADIENT, 2, 100, 200, 70, 25, 100);
+		} else {
+			reuse_image(&edges, cvGetSize(frame), IPL_DEPTH_8U, 1, frame->origin);
+			cvCanny(gray, edges, 50, 200, 3);
+			cvHoughLines2(edges, storage, CV_HOUGH_STANDARD, 1, CV_PI / 180, 70, 0, 0);
+		}
+		cvClearMemStorage(storage);
+		return gray;
+	}
+	const char* name() const { return (circles) ? "hough_circles" : "hough_lines"; }
+
+private:
+	bool circles;
+	IplImage* gray;
+	IplImage* edges;
+	CvMemStorage* storage;
+};
+
+/******************************************************************************/
+
+// normalised cross correlation template matching (template_matching.cc) with
+// a template taken from the centre of the first frame (1/10 of its size)
+
+class TemplateMatchingBench : public ProcessingStage
+{
+public:
+	TemplateMatchingBench() : templateImg(NULL), response(NULL) {}
+	~TemplateMatchingBench()
+	{
+		if (templateImg) { cvReleaseImage(&templateImg); }
+		if (response) { cvReleaseMat(&response); }
+	}
+
+	IplImage* process(IplImage* frame)
+	{
+		if (!templateImg)
+		{
+			CvRect r = cvRect((frame->width * 9) / 20, (frame->height * 9) / 20,
+							  frame->width / 10, frame->height / 10);
+			templateImg = cvCreateImage(cvSize(r.width, r.height),
+										frame->depth, frame->nChannels);
+			cvSetImageROI(frame, r);
+			cvCopy(frame, templateImg, NULL);
+			cvResetImageROI(frame);
+			response = cvCreateMat(frame->height - r.height + 1,
+								   frame->width - r.width + 1, CV_32FC1);
+		}
+
+		cvMatchTemplate(frame, templateImg, response, CV_TM_CCORR_NORMED);
+
+		double minVal, maxVal;
+		CvPoint minLoc, maxLoc;
+		cvMinMaxLoc(response, &minVal, &maxVal, &minLoc, &maxLoc, 0);
+
+		return frame;
+	}
+	const char* name() const { return "template_matching"; }
+
+private:
+	IplImage* templateImg;
+	CvMat* response;
+};
+
+/******************************************************************************/
+
+// as above, but through the template matcher of ipcv_template.h with the
+// correlation forced to be spatial or by FFT (with a cached template spectrum)
+
+class TemplateMatcherBench : public ProcessingStage
+{
+public:
+	TemplateMatcherBench(int engine) : engine(engine), matcher(NULL) {}
+	~TemplateMatcherBench()
+	{
+		release_template_matcher(&matcher);
+	}
+
+	IplImage* process(IplImage* frame)
+	{
+		if (!matcher)
+		{
+			CvRect r = cvRect((frame->width * 9) / 20, (frame->height * 9) / 20,
+							  frame->width / 10, frame->height / 10);
+			cvSetImageROI(frame, r);
+			IplImage* templateImg = cvCreateImage(cvSize(r.width, r.height),
+												  frame->depth, frame->nChannels);
+			cvCopy(frame, templateImg, NULL);
+			cvResetImageROI(frame);
+			matcher = create_template_matcher(templateImg);
+			set_template_engine(matcher, engine);
+			cvReleaseImage(&templateImg);
+		}
+
+		CvPoint location;
+		match_template(matcher, frame, &location);
+
+		return frame;
+	}
+	const char* name() const
+	{
+		return (engine == IPCV_TEMPLATE_FFT) ? "template_matching_fft" :
+											   "template_matching_spatial";
+	}
+
+private:
+	int engine;
+	TemplateMatcher* matcher;
+};
+
+/******************************************************************************/
+
+// multiple template matching (multi_template_matching.cc) - a bank of 16
+// templates taken from a grid over the first frame (1/10 of its size each),
+// matched together with the best 3 matches of each
+
+class TemplateBankBench : public ProcessingStage
+{
+public:
+	TemplateBankBench() : bank(NULL) {}
+	~TemplateBankBench()
+	{
+		release_template_bank(&bank);
+	}
+
+	IplImage* process(IplImage* frame)
+	{
+		if (!bank)
+		{
+			bank = create_template_bank();
+			for (int i = 0; i < 16; i++)
+			{
+				CvRect r = cvRect((frame->width * (1 + (2 * (i % 4)))) / 9,
+								  (frame->height * (1 + (2 * (i / 4)))) / 9,
+								  frame->width / 10, frame->height / 10);
+				cvSetImageROI(frame, r);
+				add_bank_template(bank, frame);
+				cvResetImageROI(frame);
+			}
+		}
+
+		match_template_bank(bank, frame, 3, 0.9, &detections);
+
+		return frame;
+	}
+	const char* name() const { return "template_matching_batch"; }
+
+private:
+	TemplateBank* bank;
+	std::vector<TemplateDetection> detections;
+};
+
+/******************************************************************************/
+
+// hue histogram back projection and camshift (camshift_tracking.cc) with the
+// object model taken from the centre of the first frame - the search starts
+// from the same window every frame so each run does the same work (with a
+// margin > 0 only the window expanded by the margin is processed, as with
+// camshift_tracking --track <margin>)
+
+class CamshiftBench : public ProcessingStage
+{
+public:
+	CamshiftBench(int margin = 0) : margin(margin), hue(NULL), mask(NULL),
+		backproject(NULL), hist(NULL) {}
+	~CamshiftBench()
+	{
+		if (hue) { cvReleaseImage(&hue); }
+		if (mask) { cvReleaseImage(&mask); }
+		if (backproject) { cvReleaseImage(&backproject); }
+		if (hist) { cvReleaseHist(&hist); }
+	}
+
+	IplImage* process(IplImage* frame)
+	{
+		CvSize size = cvGetSize(frame);
+		reuse_image(&hue, size, IPL_DEPTH_8U, 1, frame->origin);
+		reuse_image(&mask, size, IPL_DEPTH_8U, 1, frame->origin);
+		reuse_image(&backproject, size, IPL_DEPTH_8U, 1, frame->origin);
+
+		CvRect region = cvRect(0, 0, size.width, size.height);
+		if ((hist) && (margin > 0)) {
+			region = camshift_search_region(selection, margin, size);
+		}
+
+		hue_and_mask(frame, hue, mask, region, 30, 10, 256);
+
+		if (!hist)
+		{
+			int hdims = 16;
+			float hranges_arr[] = {0,180};
+			float* hranges = hranges_arr;
+			float max_val = 0.f;
+
+			selection = cvRect((size.width * 2) / 5, (size.height * 2) / 5,
+								size.width / 5, size.height / 5);
+			hist = cvCreateHist(1, &hdims, CV_HIST_ARRAY, &hranges, 1);
+			cvSetImageROI(hue, selection);
+			cvSetImageROI(mask, selection);
+			cvCalcHist(&hue, hist, 0, mask);
+			cvGetMinMaxHistValue(hist, 0, &max_val, 0, 0);
+			cvConvertScale(hist->bins, hist->bins, max_val ? 255. / max_val : 0., 0);
+			cvResetImageROI(hue);
+			cvResetImageROI(mask);
+		}
+
+		CvConnectedComp track_comp;
+		CvBox2D track_box;
+		CvRect window = selection;
+
+		track_camshift_region(hue, mask, hist, backproject, region, &window,
+							  &track_comp, &track_box);
+
+		return backproject;
+	}
+	const char* name() const { return (margin > 0) ? "camshift_roi" : "camshift"; }
+
+private:
+	int margin;
+	IplImage* hue;
+	IplImage* mask;
+	IplImage* backproject;
+	CvHistogram* hist;
+	CvRect selection;
+};
+
+/******************************************************************************/
+
+// multiple object camshift tracking (multi_camshift_tracking.cc) - 50 targets
+// taken from a grid over the first frame, each tracked within a 32 pixel
+// margin of its window (reset to the grid every frame so each run does the
+// same work)
+
+class CamshiftTargetsBench : public ProcessingStage
+{
+public:
+	CamshiftTargetsBench() : hue(NULL), mask(NULL), tracker(NULL) {}
+	~CamshiftTargetsBench()
+	{
+		if (hue) { cvReleaseImage(&hue); }
+		if (mask) { cvReleaseImage(&mask); }
+		release_camshift_tracker(&tracker);
+	}
+
+	IplImage* process(IplImage* frame)
+	{
+		CvSize size = cvGetSize(frame);
+		reuse_image(&hue, size, IPL_DEPTH_8U, 1, frame->origin);
+		reuse_image(&mask, size, IPL_DEPTH_8U, 1, frame->origin);
+
+		hue_and_mask(frame, hue, mask, cvRect(0, 0, size.width, size.height),
+					 30, 10, 256);
+
+		if (!tracker)
+		{
+			tracker = create_camshift_tracker(16, 32);
+			for (int i = 0; i < 50; i++)
+			{
+				windows[i] = cvRect((size.width * (i % 10)) / 10,
+									(size.height * (i / 10)) / 5,
+									size.width / 20, size.height / 10);
+				add_camshift_target(tracker, hue, mask, windows[i]);
+			}
+		}
+		for (int i = 0; i < 50; i++)
+		{
+			tracker->targets[i].window = windows[i];
+			tracker->targets[i].tracked = true;
+		}
+
+		track_camshift_targets(tracker, hue, mask);
+
+		return mask;
+	}
+	const char* name() const { return "camshift_targets"; }
+
+private:
+	IplImage* hue;
+	IplImage* mask;
+	CamshiftTracker* tracker;
+	CvRect windows[50];
+};
+
+/******************************************************************************/
+
+// gray histogram of the frame compared (by the four measures used in
+// histogram_based_recognition.cc) against a gallery of stored histograms
+
+#define BENCH_GALLERY_SIZE 100
+
+class HistogramCompareBench : public ProcessingStage
+{
+public:
+	HistogramCompareBench() : gray(NULL), current(NULL) {}
+	~HistogramCompareBench()
+	{
+		if (gray) { cvReleaseImage(&gray); }
+		if (current) { cvReleaseHist(&current); }
+		for (size_t i = 0; i < gallery.size(); i++) {
+			cvReleaseHist(&(gallery[i]));
+		}
+	}
+
+	IplImage* process(IplImage* frame)
+	{
+		reuse_image(&gray, cvGetSize(frame), IPL_DEPTH_8U, 1, frame->origin);
+		cvCvtColor(frame, gray, CV_BGR2GRAY);
+
+		if (!current)
+		{
+			// gallery of histograms of the frame at different brightness
+
+			int hist_size = 256;
+			float range_0[]={0,256};
+			float* ranges[] = { range_0 };
+
+			current = cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1);
+			for (int i = 0; i < BENCH_GALLERY_SIZE; i++)
+			{
+				CvHistogram* h = cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1);
+				cvAddS(gray, cvScalarAll(i - (BENCH_GALLERY_SIZE / 2)), gray, NULL);
+				cvCalcHist(&gray, h, 0, NULL);
+				cvNormalizeHist(h, 1);
+				gallery.push_back(h);
+				cvCvtColor(frame, gray, CV_BGR2GRAY);
+			}
+		}
+
+		cvCalcHist(&gray, current, 0, NULL);
+		cvNormalizeHist(current, 1);
+
+		double closestDistance = HUGE_VAL;
+		for (size_t i = 0; i < gallery.size(); i++)
+		{
+			double d = (1 - cvCompareHist(current, gallery[i], CV_COMP_CORREL))
+					 + cvCompareHist(current, gallery[i], CV_COMP_CHISQR)
+					 + (1 - cvCompareHist(current, gallery[i], CV_COMP_INTERSECT))
+					 + cvCompareHist(current, gallery[i], CV_COMP_BHATTACHARYYA);
+			closestDistance = std::min(closestDistance, d);
+		}
+
+		return gray;
+	}
+	const char* name() const { return "histogram_compare"; }
+
+private:
+	IplImage* gray;
+	CvHistogram* current;
+	std::vector<CvHistogram*> gallery;
+};
+
+/******************************************************************************/
+
+// the BENCH_GALLERY_SIZE distinct histograms of the gray frame at different
+// brightness (as HistogramCompareBench) - computed once, and repeated to
+// fill the large galleries rather than recomputed for each entry
+
+static std::vector<CvHistogram*> bench_gallery_histograms(IplImage* frame,
+	IplImage* gray, CvHistogram* hist)
+{
+	std::vector<CvHistogram*> hists(BENCH_GALLERY_SIZE, (CvHistogram*) NULL);
+	for (int b = 0; b < BENCH_GALLERY_SIZE; b++)
+	{
+		cvAddS(gray, cvScalarAll(b - (BENCH_GALLERY_SIZE / 2)), gray, NULL);
+		cvCalcHist(&gray, hist, 0, NULL);
+		cvCopyHist(hist, &(hists[b]));
+		cvCvtColor(frame, gray, CV_BGR2GRAY);
+	}
+	return hists;
+}
+
+static void release_bench_gallery_histograms(std::vector<CvHistogram*>* hists)
+{
+	for (size_t b = 0; b < hists->size(); b++) {
+		cvReleaseHist(&((*hists)[b]));
+	}
+	hists->clear();
+}
+
+/******************************************************************************/
+
+// as HistogramCompareBench, but with the histograms held in a histogram
+// gallery (ipcv_gallery.h) of the given size (the same BENCH_GALLERY_SIZE
+// histograms repeated) - all four measures in one pass over each row
+
+class HistogramGalleryBench : public ProcessingStage
+{
+public:
+	HistogramGalleryBench(int size = BENCH_GALLERY_SIZE) : size(size),
+		gray(NULL), current(NULL), gallery(NULL) {}
+	~HistogramGalleryBench()
+	{
+		if (gray) { cvReleaseImage(&gray); }
+		if (current) { cvReleaseHist(&current); }
+		release_histogram_gallery(&gallery);
+	}
+
+	IplImage* process(IplImage* frame)
+	{
+		reuse_image(&gray, cvGetSize(frame), IPL_DEPTH_8U, 1, frame->origin);
+		cvCvtColor(frame, gray, CV_BGR2GRAY);
+
+		if (!current)
+		{
+			int hist_size = 256;
+			float range_0[]={0,256};
+			float* ranges[] = { range_0 };
+
+			current = cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1);
+			gallery = create_histogram_gallery(hist_size);
+			std::vector<CvHistogram*> hists =
+				bench_gallery_histograms(frame, gray, current);
+			for (int i = 0; i < size; i++)
+			{
+				add_gallery_histogram(gallery, hists[i % BENCH_GALLERY_SIZE]);
+			}
+			release_bench_gallery_histograms(&hists);
+		}
+
+		cvCalcHist(&gray, current, 0, NULL);
+		cvNormalizeHist(current, 1);
+
+		GalleryComparison closest;
+		match_histogram_gallery(gallery, current, &closest);
+
+		return gray;
+	}
+	const char* name() const
+	{
+		return (size > BENCH_GALLERY_SIZE) ? "histogram_gallery_100k" :
+											 "histogram_gallery";
+	}
+
+private:
+	int size;
+	IplImage* gray;
+	CvHistogram* current;
+	HistogramGallery* gallery;
+};
+
+/******************************************************************************/
+
+// as HistogramGalleryBench (100k histograms), but finding the nearest
+// histograms by the Hellinger index (ipcv_ann.h) with the default probes,
+// then comparing only those few by the four measures
+
+class HistogramIndexBench : public ProcessingStage
+{
+public:
+	HistogramIndexBench() : gray(NULL), current(NULL), gallery(NULL), index(NULL),
+		transform(256) {}
+	~HistogramIndexBench()
+	{
+		if (gray) { cvReleaseImage(&gray); }
+		if (current) { cvReleaseHist(&current); }
+		release_histogram_gallery(&gallery);
+		release_hellinger_index(&index);
+	}
+
+	IplImage* process(IplImage* frame)
+	{
+		reuse_image(&gray, cvGetSize(frame), IPL_DEPTH_8U, 1, frame->origin);
+		cvCvtColor(frame, gray, CV_BGR2GRAY);
+
+		if (!current)
+		{
+			int hist_size = 256;
+			float range_0[]={0,256};
+			float* ranges[] = { range_0 };
+
+			current = cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1);
+			gallery = create_histogram_gallery(hist_size);
+			index = create_hellinger_index(hist_size);
+			std::vector<CvHistogram*> hists =
+				bench_gallery_histograms(frame, gray, current);
+			std::vector<float> transforms((size_t) BENCH_GALLERY_SIZE * hist_size);
+			for (int b = 0; b < BENCH_GALLERY_SIZE; b++) {
+				hellinger_transform(hists[b], &(transforms[(size_t) b * hist_size]));
+			}
+			for (int i = 0; i < 100000; i++)
+			{
+				int b = i % BENCH_GALLERY_SIZE;
+				add_gallery_histogram(gallery, hists[b]);
+				add_hellinger_vector(index, &(transforms[(size_t) b * hist_size]));
+			}
+			release_bench_gallery_histograms(&hists);
+		}
+
+		cvCalcHist(&gray, current, 0, NULL);
+		cvNormalizeHist(current, 1);
+
+		hellinger_transform(current, &(transform[0]));
+		search_hellinger_index(index, &(transform[0]), 10, &neighbours);
+
+		GalleryComparison c;
+		double closestDistance = HUGE_VAL;
+		for (size_t i = 0; i < neighbours.size(); i++)
+		{
+			compare_gallery_histogram(gallery, current, neighbours[i].index, &c);
+			closestDistance = std::min(closestDistance, c.distance);
+		}
+
+		return gray;
+	}
+	const char* name() const { return "histogram_ann_100k"; }
+
+private:
+	IplImage* gray;
+	CvHistogram* current;
+	HistogramGallery* gallery;
+	HellingerIndex* index;
+	std::vector<float> transform;
+	std::vector<HellingerNeighbour> neighbours;
+};
+
+/******************************************************************************/
+
+// colour histograms of the frame compared against a gallery of stored colour
+// histograms (of the frame at different brightness) - either as three 256
+// bin channel histograms by the four measures each (averaged, as
+// histogram_based_recognition_colour.cc) or as a single joint colour
+// histogram of 8 levels per channel (512 bins, --joint 8) in a gallery
+
+class ColourHistogramBench : public ProcessingStage
+{
+public:
+	ColourHistogramBench(bool joint) : joint(joint), b(NULL), g(NULL), r(NULL),
+		shifted(NULL), joint_hist(NULL), gallery(NULL)
+	{
+		for (int c = 0; c < 3; c++) { current[c] = NULL; }
+	}
+	~ColourHistogramBench()
+	{
+		if (b) { cvReleaseImage(&b); }
+		if (g) { cvReleaseImage(&g); }
+		if (r) { cvReleaseImage(&r); }
+		if (shifted) { cvReleaseImage(&shifted); }
+		for (int c = 0; c < 3; c++) {
+			if (current[c]) { cvReleaseHist(&(current[c])); }
+		}
+		if (joint_hist) { cvReleaseHist(&joint_hist); }
+		for (size_t i = 0; i < channels.size(); i++) {
+			cvReleaseHist(&(channels[i]));
+		}
+		release_histogram_gallery(&gallery);
+	}
+
+	IplImage* process(IplImage* frame)
+	{
+		CvSize size = cvGetSize(frame);
+		reuse_image(&b, size, IPL_DEPTH_8U, 1, frame->origin);
+		reuse_image(&g, size, IPL_DEPTH_8U, 1, frame->origin);
+		reuse_image(&r, size, IPL_DEPTH_8U, 1, frame->origin);
+
+		if (!current[0])
+		{
+			int hist_size = 256;
+			int joint_size = 512;
+			float range_0[]={0,256};
+			float* ranges[] = { range_0 };
+
+			for (int c = 0; c < 3; c++) {
+				current[c] = cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1);
+			}
+			joint_hist = cvCreateHist(1, &joint_size, CV_HIST_ARRAY, NULL, 1);
+			gallery = create_histogram_gallery(joint_size);
+
+			reuse_image(&shifted, size, IPL_DEPTH_8U, 3, frame->origin);
+			for (int i = 0; i < BENCH_GALLERY_SIZE; i++)
+			{
+				cvAddS(frame, cvScalarAll(i - (BENCH_GALLERY_SIZE / 2)), shifted, NULL);
+				if (joint) {
+					calc_joint_colour_histogram(shifted, 8, joint_hist);
+					add_gallery_histogram(gallery, joint_hist);
+				} else {
+					cvSplit(shifted, b, g, r, NULL);
+					IplImage* planes[3] = {r, g, b};
+					for (int c = 0; c < 3; c++)
+					{
+						CvHistogram* h = cvCreateHist(1, &hist_size, CV_HIST_ARRAY,
+													  ranges, 1);
+						cvCalcHist(&(planes[c]), h, 0, NULL);
+						cvNormalizeHist(h, 1);
+						channels.push_back(h);
+					}
+				}
+			}
+		}
+
+		if (joint)
+		{
+			calc_joint_colour_histogram(frame, 8, joint_hist);
+
+			GalleryComparison closest;
+			match_histogram_gallery(gallery, joint_hist, &closest);
+		} else {
+			cvSplit(frame, b, g, r, NULL);
+			IplImage* planes[3] = {r, g, b};
+			for (int c = 0; c < 3; c++)
+			{
+				cvCalcHist(&(planes[c]), current[c], 0, NULL);
+				cvNormalizeHist(current[c], 1);
+			}
+
+			double closestDistance = HUGE_VAL;
+			for (size_t i = 0; i < channels.size(); i += 3)
+			{
+				double d = 0;
+				for (int c = 0; c < 3; c++)
+				{
+					CvHistogram* h = channels[i + c];
+					d += ((1 - cvCompareHist(current[c], h, CV_COMP_CORREL))
+						 + cvCompareHist(current[c], h, CV_COMP_CHISQR)
+						 + (1 - cvCompareHist(current[c], h, CV_COMP_INTERSECT))
+						 + cvCompareHist(current[c], h, CV_COMP_BHATTACHARYYA)) / 3.0;
+				}
+				closestDistance = std::min(closestDistance, d);
+			}
+		}
+
+		return r;
+	}
+	const char* name() const
+	{
+		return (joint) ? "histogram_joint_colour" : "histogram_compare_colour";
+	}
+
+private:
+	bool joint;
+	IplImage* b;
+	IplImage* g;
+	IplImage* r;
+	IplImage* shifted;
+	CvHistogram* current[3];
+	CvHistogram* joint_hist;
+	std::vector<CvHistogram*> channels;
+	HistogramGallery* gallery;
+};
+
+/******************************************************************************/
+
+// butterworth low pass filtering via the original double precision, complex
+// DFT path of dft_butterworth_lowpass.cc (for comparison with the single
+// precision, real input path of the butterworth_lowpass stage)
+
+class ComplexDFTBench : public ProcessingStage
+{
+public:
+	ComplexDFTBench() : gray(NULL), realInput(NULL), imaginaryInput(NULL),
+		dft_A(NULL), output(NULL), filterCache(create_butterworth_filter_cache(IPCV_BUTTERWORTH_LOWPASS)) {}
+	~ComplexDFTBench()
+	{
+		if (gray) { cvReleaseImage(&gray); }
+		if (realInput) { cvReleaseImage(&realInput); }
+		if (imaginaryInput) { cvReleaseImage(&imaginaryInput); }
+		if (dft_A) { cvReleaseMat(&dft_A); }
+		if (output) { cvReleaseImage(&output); }
+		release_butterworth_filter_cache(&filterCache);
+	}
+
+	IplImage* process(IplImage* frame)
+	{
+		CvSize size = cvGetSize(frame);
+		CvMat tmp;
+		double m, M;
+
+		int dft_M = cvGetOptimalDFTSize( size.height - 1 );
+		int dft_N = cvGetOptimalDFTSize( size.width - 1 );
+
+		reuse_image(&gray, size, IPL_DEPTH_8U, 1, frame->origin);
+		reuse_image(&output, size, IPL_DEPTH_8U, 1, frame->origin);
+		reuse_image(&realInput, size, IPL_DEPTH_64F, 1, frame->origin);
+		reuse_image(&imaginaryInput, size, IPL_DEPTH_64F, 1, frame->origin);
+		if (!dft_A) {
+			dft_A = cvCreateMat( dft_M, dft_N, CV_64FC2 );
+		}
+		update_butterworth_filter(filterCache, cvSize(dft_N, dft_M), 30, 2);
+
+		cvCvtColor(frame, gray, CV_BGR2GRAY);
+
+		// real image into the (zero padded) complex input
+
+		cvZero(dft_A);
+		cvGetSubRect( dft_A, &tmp, cvRect(0, 0, size.width, size.height));
+		cvScale(gray, realInput, 1.0, 0.0);
+		cvZero(imaginaryInput);
+		cvMerge(realInput, imaginaryInput, NULL, NULL, &tmp);
+
+		cvDFT( dft_A, dft_A, CV_DXT_FORWARD, size.height );
+		cvMulSpectrums( dft_A, filterCache->filter, dft_A, 0);
+		cvDFT( dft_A, dft_A, CV_DXT_INVERSE, size.height );
+
+		cvSplit( &tmp, realInput, imaginaryInput, 0, 0 );
+		cvMinMaxLoc(realInput, &m, &M, NULL, NULL, NULL);
+		double range = std::max(M - m, 1e-10);
+		cvConvertScale(realInput, output, 255.0 / range, -m * 255.0 / range);
+
+		return output;
+	}
+	const char* name() const { return "butterworth_lowpass_complex"; }
+
+private:
+	IplImage* gray;
+	IplImage* realInput;
+	IplImage* imaginaryInput;
+	CvMat* dft_A;
+	IplImage* output;
+	ButterworthFilterCache* filterCache;
+};
+
+/******************************************************************************/
+
+// all operations benchmarked by default (stage specifications, see
+// ipcv_stage.h, or one of the benchmark operations above)
+
+static const char* defaultOps =
+	"canny,sobel,laplace,median,gaussian,adaptive_threshold,"
+	"butterworth_lowpass,butterworth_highpass,butterworth_lowpass_complex,"
+	"watershed,hough_lines,hough_circles,template_matching,"
+	"template_matching_spatial,template_matching_fft,template_matching_batch,"
+	"camshift,camshift_roi,camshift_targets,histogram_compare,histogram_gallery,"
+	"histogram_gallery_100k,histogram_ann_100k,histogram_compare_colour,"
+	"histogram_joint_colour";
+
+// create the operation with the given name (or NULL)
+
+static ProcessingStage* create_bench_operation(const char* op)
+{
+	if (!strcmp(op, "watershed")) {
+		return new WatershedBench();
+	} else if (!strcmp(op, "hough_lines")) {
+		return new HoughBench(false);
+	} else if (!strcmp(op, "hough_circles")) {
+		return new HoughBench(true);
+	} else if (!strcmp(op, "template_matching")) {
+		return new TemplateMatchingBench();
+	} else if (!strcmp(op, "template_matching_spatial")) {
+		return new TemplateMatcherBench(IPCV_TEMPLATE_SPATIAL);
+	} else if (!strcmp(op, "template_matching_fft")) {
+		return new TemplateMatcherBench(IPCV_TEMPLATE_FFT);
+	} else if (!strcmp(op, "template_matching_batch")) {
+		return new TemplateBankBench();
+	} else if (!strcmp(op, "camshift")) {
+		return new CamshiftBench();
+	} else if (!strcmp(op, "camshift_roi")) {
+		return new CamshiftBench(32);
+	} else if (!strcmp(op, "camshift_targets")) {
+		return new CamshiftTargetsBench();
+	} else if (!strcmp(op, "histogram_compare")) {
+		return new HistogramCompareBench();
+	} else if (!strcmp(op, "histogram_gallery")) {
+		return new HistogramGalleryBench();
+	} else if (!strcmp(op, "histogram_gallery_100k")) {
+		return new HistogramGalleryBench(100000);
+	} else if (!strcmp(op, "histogram_ann_100k")) {
+		return new HistogramIndexBench();
+	} else if (!strcmp(op, "histogram_compare_colour")) {
+		return new ColourHistogramBench(false);
+	} else if (!strcmp(op, "histogram_joint_colour")) {
+		return new ColourHistogramBench(true);
+	} else if (!strcmp(op, "butterworth_lowpass_complex")) {
+		return new ComplexDFTBench();
+	}
+	return create_stage(op);
+}
+
+/******************************************************************************/
+
+// split a comma separated list
+
+static std::vector<std::string> split_list(const char* list)
+{
+	std::vector<std::string> items;
+	std::string s(list);
+	size_t start = 0, end;
+
+	do {
+		end = s.find(',', start);
+		items.push_back(s.substr(start, (end == std::string::npos) ?
+										std::string::npos : end - start));
+		start = end + 1;
+	} while (end != std::string::npos);
+
+	return items;
+}
+
+/******************************************************************************/
+
+// time an operation on a frame - run once (to allocate its buffers / models)
+// and then repeatedly for at least minTime ms (and 3 runs), returning the
+// mean time per frame in ms
+
+static double time_operation(ProcessingStage* op, IplImage* frame, double minTime)
+{
+	op->process(frame);
+
+	int runs = 0;
+	double elapsed = 0;
+	int64 start = getTickCount();
+
+	while ((runs < 3) || (elapsed < minTime))
+	{
+		op->process(frame);
+		runs++;
+		elapsed = ((getTickCount() - start) / getTickFrequency()) * 1000;
+	}
+
+	return elapsed / runs;
+}
+
+/******************************************************************************/
+
+int main( int argc, char** argv )
+{
+
+  // process any shared command line options
+
+  ipcv_parse_options(&argc, argv, IPCV_REPLAY_INPUT);
+
+  double minTime = 500;					// minimum time per benchmark (ms)
+  const char* ops = defaultOps;			// operations to benchmark
+  const char* resolutionList = "vga,720p,1080p,4k";
+
+  // benchmark options (the remaining argument is the recorded input)
+
+  int kept = 1;
+  for (int i = 1; i < argc; i++)
+  {
+	  if ((!strcmp(argv[i], "--min-time")) && (i + 1 < argc)) {
+		  minTime = atof(argv[++i]);
+	  } else if ((!strcmp(argv[i], "--ops")) && (i + 1 < argc)) {
+		  ops = argv[++i];
+	  } else if ((!strcmp(argv[i], "--resolutions")) && (i + 1 < argc)) {
+		  resolutionList = argv[++i];
+	  } else {
+		  argv[kept++] = argv[i];
+	  }
+  }
+  argc = kept;
+
+  if (argc > 2){
+	  printf("usage: %s [--min-time <ms>] [--ops <op>[,<op> ...]] "
+			 "[--resolutions <res>[,<res> ...]] {<image_name> | <video_name>}\n",
+			 argv[0]);
+	  return -1;
+  }
+
+  // inputs - the synthetic scene and (optionally) the first frame of the
+  // recorded input, each at every resolution
+
+  IplImage* recorded = NULL;
+  if (argc == 2)
+  {
+	  FrameSource* source = create_input_frame_source(argc, argv, 0);
+	  IplImage* img = (source) ? query_frame_source(source) : NULL;
+	  if ((!img) || (img->nChannels != 3) || (img->depth != IPL_DEPTH_8U)){
+		  printf("ERROR: cannot read an 8-bit colour frame from %s\n", argv[1]);
+		  release_frame_source(&source);
+		  return -1;
+	  }
+	  recorded = cvCloneImage(img);
+	  recorded->origin = 0;
+	  release_frame_source(&source);
+  }
+
+  std::vector<std::string> opNames = split_list(ops);
+  std::vector<std::string> resNames = split_list(resolutionList);
+
+  printf("operation,input,resolution,ms_per_frame,ns_per_pixel,fps\n");
+
+  for (size_t r = 0; r < resNames.size(); r++)
+  {
+	  int res;
+	  for (res = 0; res < N_RESOLUTIONS; res++)
+	  {
+		  if (resNames[r] == resolutions[res].name) {
+			  break;
+		  }
+	  }
+	  if (res == N_RESOLUTIONS){
+		  printf("ERROR: unknown resolution \"%s\"\n", resNames[r].c_str());
+		  return -1;
+	  }
+
+	  CvSize size = cvSize(resolutions[res].width, resolutions[res].height);
+	  double pixels = ((double) size.width) * size.height;
+
+	  IplImage* inputs[2] = { create_synthetic_frame(size), NULL };
+	  const char* inputNames[2] = { "synthetic", "recorded" };
+	  if (recorded)
+	  {
+		  inputs[1] = cvCreateImage(size, IPL_DEPTH_8U, 3);
+		  cvResize(recorded, inputs[1], CV_INTER_AREA);
+	  }
+
+	  for (int in = 0; (in < 2) && (inputs[in]); in++)
+	  {
+		  for (size_t o = 0; o < opNames.size(); o++)
+		  {
+			  // a new operation for each input (so models / templates are
+			  // taken from that input)
+
+			  ProcessingStage* op = create_bench_operation(opNames[o].c_str());
+			  if (!op){
+				  return -1;
+			  }
+
+			  double ms = time_operation(op, inputs[in], minTime);
+			  printf("%s,%s,%s,%.3f,%.3f,%.2f\n", opNames[o].c_str(),
+					 inputNames[in], resolutions[res].name, ms,
+					 (ms * 1e6) / pixels, 1000.0 / ms);
+			  fflush(stdout);
+
+			  delete op;
+		  }
+		  cvReleaseImage(&(inputs[in]));
+	  }
+  }
+
+  if (recorded){
+	  cvReleaseImage(&recorded);
+  }
+
+  // all OK : main returns 0
+
+  return 0;
+}
+/******************************************************************************/
@@ -1,5 +1,5 @@
 // Example : CAMSIFT based object tracking for video / camera
-// usage: prog {<video_name>}
+// usage: prog [--roi <x,y,w,h>] {<video_name>}
 
 // Author : Toby Breckon, toby.breckon@cranfield.ac.uk
 
@@ -16,6 +16,11 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_frame_source.h" // threaded prefetching frame source
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+#include "ipcv_camshift.h" // region restricted hue / CAMSHIFT functions
+
 #include <stdio.h>
 #include <algorithm>
 using namespace std;
@@ -124,10 +129,14 @@ static CvScalar hue2rgb( float hue )
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv, IPCV_REPLAY_INPUT);
+
   IplImage* img = NULL;      // image object (main)
   IplImage* img_copy = NULL;      // image object (copy)
 
-  CvCapture* capture = NULL; // capture object
+  FrameSource* source = NULL; // frame source (video, camera or replay)
 
   char const * windowName = "CAMSHIFT Tracking"; // window name
   char const * windowName2 = "Histogram Model (Hue)"; // window name
@@ -142,6 +151,9 @@ int main( int argc, char** argv )
   CvRect track_window;			// tracking window used by CAMSHIFT
   CvBox2D track_box;			// tracking box used by CAMSHIFT
   CvConnectedComp track_comp;   // tracking component used by CAMSHIFT
+  bool tracked = false;			// target tracked in the previous frame
+  CvRect region;				// region of the frame processed (--track)
+  CvRect processed = cvRect(0, 0, 0, 0); // region processed in the previous frame
 
   int vmin = 10, vmax = 256, smin = 30; // min/max values for Variance/Saturation mask
 
@@ -152,28 +164,25 @@ int main( int argc, char** argv )
   // if command line arguments are provided try to read image/video_name
   // otherwise default to capture from attached H/W camera
 
-    if(
-	  ( argc == 2 && (capture = cvCreateFileCapture( argv[1] )) != 0 ) ||
-	  ( argc != 2 && (capture = cvCreateCameraCapture( CAMERA_INDEX )) != 0 )
-	  )
+    if ((source = create_input_frame_source(argc, argv, CAMERA_INDEX)) != 0)
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
-	  cvNamedWindow(windowName2, 0);
-	  cvNamedWindow(windowName3, 0);
-	  cvNamedWindow(windowName4, 0);
+      ipcv_named_window(windowName, 0);
+	  ipcv_named_window(windowName2, 0);
+	  ipcv_named_window(windowName3, 0);
+	  ipcv_named_window(windowName4, 0);
 
-	  cvCreateTrackbar( "Vmin", windowName3, &vmin, 256, 0 );
-      cvCreateTrackbar( "Vmax", windowName3, &vmax, 256, 0 );
-      cvCreateTrackbar( "Smin", windowName3, &smin, 256, 0 );
+	  ipcv_create_trackbar( "Vmin", windowName3, &vmin, 256, 0 );
+      ipcv_create_trackbar( "Vmax", windowName3, &vmax, 256, 0 );
+      ipcv_create_trackbar( "Smin", windowName3, &smin, 256, 0 );
 
 	  printf("\nPress 'c' to reset histogram model\n\n");
 	  printf("\nPress 'b' to show backprojection\n\n");
 
 	  // setup mouse callback
 
-	  cvSetMouseCallback(windowName, set_selected_roi, 0 );
+	  ipcv_set_mouse_callback(windowName, set_selected_roi, 0 );
 
 	  // set initial selection to zero
 
@@ -182,7 +191,7 @@ int main( int argc, char** argv )
 
 	 // do initial capture to get all the buffer sizes
 
-	  img = cvQueryFrame(capture);
+	  img = query_frame_source(source);
 	  if(!img){
 			if (argc == 2){
 					printf("End of video file reached\n");
@@ -192,9 +201,12 @@ int main( int argc, char** argv )
 					exit(1);
 	  }
 
+	  // (or to that given on the command line, clipped to the frame)
+
+	  ipcv_initial_roi(&selection, cvGetSize(img));
+
        // allocate all the required buffers
 
-            IplImage* hsv = cvCloneImage(img);
             IplImage* hue = cvCreateImage( cvGetSize(img), 8, 1 );
 			hue->origin = img->origin;
             IplImage* mask = cvCloneImage(hue);
@@ -204,10 +216,8 @@ int main( int argc, char** argv )
 		// allocate all required histogram buffers
 
 			int hdims = 16;
-			float hranges_arr[] = {0,180};
-			float* hranges = hranges_arr;
-			CvHistogram* histM = cvCreateHist( 1, &hdims, CV_HIST_ARRAY, &hranges, 1 );
-			CvHistogram* histL = cvCreateHist( 1, &hdims, CV_HIST_ARRAY, &hranges, 1 );
+			CvHistogram* histM = create_hue_histogram( hdims );
+			CvHistogram* histL = create_hue_histogram( hdims );
             IplImage* histimgM = cvCreateImage( cvSize(320,200), 8, 3 );
 			IplImage* histimgL = cvCreateImage( cvSize(320,200), 8, 3 );
             cvZero( histimgM );
@@ -222,7 +232,7 @@ int main( int argc, char** argv )
 		  // capture object in use (i.e. video/camera)
 		  // get image from capture object
 
-			  img = cvQueryFrame(capture);
+			  img = query_frame_source(source);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -241,19 +251,40 @@ int main( int argc, char** argv )
 
 		  // *** CAMSIFT Histogram based tracking code
 
-		    // create an HSV version of the input image
+			// with a tracking margin (--track <margin>) only process the track
+			// window expanded by the margin - otherwise (or if the target has
+			// been lost) process the whole frame
+
+			 int64 convertStart = ipcv_timing_start(); // (timing of conversion)
+
+			 if ((ipcv_track_margin() > 0) && histogramCaptured && tracked) {
+				region = camshift_search_region(track_window, ipcv_track_margin(),
+												cvGetSize(img));
+			 } else {
+				region = cvRect(0, 0, img->width, img->height);
+			 }
 
-			 cvCvtColor( img, hsv, CV_BGR2HSV );
+			 // (clearing the mask / back projection of the last region for display)
 
-			 // create a mask for all values within S channel value {smin ... 256}
-			 // and V channel value {vmin .. vmax}
+			 if ((ipcv_track_margin() > 0) && (processed.width > 0) &&
+				 ((region.x != processed.x) || (region.y != processed.y) ||
+				  (region.width != processed.width) || (region.height != processed.height))) {
+				cvSetImageROI( mask, processed );
+				cvSetImageROI( backproject, processed );
+				cvZero( mask );
+				cvZero( backproject );
+				cvResetImageROI( mask );
+				cvResetImageROI( backproject );
+			 }
+			 processed = region;
 
-			cvInRangeS( hsv, cvScalar(0, smin, min(vmin,vmax),0),
-                        cvScalar(180, 256, max(vmin,vmax),0), mask );
+		    // create an HSV version of the region, a mask for all values within
+		    // S channel value {smin ... 256} and V channel value {vmin .. vmax}
+		    // and isolate the hue channel
 
-			// isolate the hue channel
+			 hue_and_mask( img, hue, mask, region, smin, vmin, vmax );
 
-			cvSplit( hsv, hue, NULL, NULL, NULL );
+			ipcv_timing_stop(IPCV_TIMING_CONVERT, convertStart);
 
 		    // if we have a selection then mark it on the image as
 		    // we make it with the mouse
@@ -287,18 +318,12 @@ int main( int argc, char** argv )
 				// get the histogram for the Hue channel
 				// within the areas defined Saturation and Variance Channel mask
 
-				float max_val = 0.f;
-                cvSetImageROI( hue, selection );
-                cvSetImageROI( mask, selection );
-                cvCalcHist( &hue, histM, 0, mask );
-                cvGetMinMaxHistValue( histM, 0, &max_val, 0, 0 );
-                cvConvertScale( histM->bins, histM->bins, max_val ? 255. / max_val : 0., 0 );
-                cvResetImageROI( hue );
-                cvResetImageROI( mask );
+				calc_hue_histogram( hue, mask, selection, histM );
 
 				// set the initial tracking position of the object
 
 				track_window = selection;
+				tracked = true;
 
 				// create the histogram image of model
 
@@ -320,21 +345,21 @@ int main( int argc, char** argv )
 
 			if (histogramCaptured){
 
-				// calculate the back-projection of the histogram on the image
+				IpcvScopedTimer timer(IPCV_TIMING_PROCESS);
 
-				cvCalcBackProject( &hue, backproject, histM );
-				cvAnd( backproject, mask, backproject, 0 );
-
-				// pass this backprojection to the camShift Routine
+				// calculate the back-projection of the histogram on the region
+				// and pass this backprojection to the camShift Routine - which
+				// updates the tracking window for the next iteration based
+				// on the output of the current predicted position
 
-				cvCamShift(backproject, track_window,
-                        cvTermCriteria( CV_TERMCRIT_EPS | CV_TERMCRIT_ITER, 10, 1 ),
-                        &track_comp, &track_box );
+				tracked = track_camshift_region( hue, mask, histM, backproject, region,
+												 &track_window, &track_comp, &track_box );
 
-				// update the tracking window for the next iteration based
-				// on the output of the current predicted position
+				// if the target is lost search for it from the whole frame
 
-				track_window = track_comp.rect;
+				if ((!tracked) && (ipcv_track_margin() > 0)) {
+					track_window = cvRect(0, 0, img->width, img->height);
+				}
 
 				// draw the detected result (taking into account image origin)
 
@@ -346,14 +371,7 @@ int main( int argc, char** argv )
 
 				// draw the histogram of the detected result area
 
-				float max_val = 0.f;
-                cvSetImageROI( hue, track_window );
-                cvSetImageROI( mask, track_window );
-                cvCalcHist( &hue, histL, 0, mask );
-                cvGetMinMaxHistValue( histL, 0, &max_val, 0, 0 );
-                cvConvertScale( histL->bins, histL->bins, max_val ? 255. / max_val : 0., 0 );
-                cvResetImageROI( hue );
-                cvResetImageROI( mask );
+				calc_hue_histogram( hue, mask, track_window, histL );
 
 				// create the histogram image of model
 
@@ -375,13 +393,13 @@ int main( int argc, char** argv )
 		  // display image in window
 
 		  if (!showBackProjection){
-			cvShowImage( windowName, img );
+			ipcv_show_image( windowName, img );
 		  } else {
-			cvShowImage( windowName, backproject );
+			ipcv_show_image( windowName, backproject );
 		  }
-		  cvShowImage( windowName2, histimgM );
-		  cvShowImage( windowName3, mask );
-		  cvShowImage( windowName4, histimgL );
+		  ipcv_show_image( windowName2, histimgM );
+		  ipcv_show_image( windowName3, mask );
+		  ipcv_show_image( windowName4, histimgL );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
@@ -391,7 +409,7 @@ int main( int argc, char** argv )
           // we get a +ve wait time
 
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -424,18 +442,21 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image objects (if it does not originate from a capture object)
 
 	  cvReleaseImage ( &img_copy);
 	  cvReleaseImage ( &backproject );
 	  cvReleaseImage ( &mask  );
-	  cvReleaseImage ( &hsv );
 	  cvReleaseImage ( &hue);
       cvReleaseImage ( &histimgM);
 	  cvReleaseImage ( &histimgL);
 
+	  // release frame source (and capture device)
+
+	  release_frame_source(&source);
+
       // all OK : main returns 0
 
       return 0;
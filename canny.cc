@@ -1,5 +1,5 @@
 // Example : grab and display live video using canny edge detection
-// usage: prog
+// usage: prog {<video_name>}
 
 // Author : Toby Breckon, toby.breckon@cranfield.ac.uk
 
@@ -14,6 +14,10 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_frame_source.h" // threaded prefetching frame source
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>		// standard C++ I/O
 #include <algorithm>    // includes max()
 
@@ -23,6 +27,10 @@ using namespace std;
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img;  // image object
   IplImage* grayImg = NULL;  // tmp image object
   IplImage* edgeImg = NULL;  // output image object
@@ -40,22 +48,28 @@ int main( int argc, char** argv )
 
   // create window object
 
-  cvNamedWindow(windowName, 0 );
+  ipcv_named_window(windowName, 0 );
 
   // add adjustable trackbars for ech of the canny edge parameters
 
-  cvCreateTrackbar("Lower", windowName, &lowerThreshold, 255, NULL);
-  cvCreateTrackbar("Upper", windowName, &upperThreshold, 255, NULL);
-  cvCreateTrackbar("Window", windowName, &windowSize, 7, NULL);
+  ipcv_create_trackbar("Lower", windowName, &lowerThreshold, 255, NULL);
+  ipcv_create_trackbar("Upper", windowName, &upperThreshold, 255, NULL);
+  ipcv_create_trackbar("Window", windowName, &windowSize, 7, NULL);
+
+  // open video file if one is provided, otherwise grab from camera
+  // (here assume only 1 camera, device #1)
+
+  CvCapture* capture = (argc == 2) ? cvCreateFileCapture(argv[1]) : cvCaptureFromCAM(1);
 
-  // grab an image from camera (here assume only 1 camera, device #0)
+  // decode frames from the capture object on a background thread
+  // (N.B. the frame source now owns the capture object)
 
-  CvCapture* capture = cvCaptureFromCAM(1); // capture from video device #0
-  if(!cvGrabFrame(capture)){
+  FrameSource* source = create_prefetch_frame_source(capture);
+  if(!source){
     printf("Could not grab a frame\n");
     exit(0);
   }
-  img=cvRetrieveFrame(capture); // retrieve the captured frame
+  img = query_frame_source(source); // retrieve the captured frame
 
   // create other images (and make sure they have the same origin)
 
@@ -67,10 +81,6 @@ int main( int argc, char** argv )
 				img->depth, 1);
   edgeImg->origin = img->origin;
 
-  // grab the next frame to maintain sync
-
-  cvGrabFrame(capture);
-
  // start main grab/process/display loop
 
   while (keepProcessing)
@@ -78,7 +88,11 @@ int main( int argc, char** argv )
 
    int64 timeStart = getTickCount(); // get time at start of loop
 
-   img=cvRetrieveFrame(capture); // retrieve the captured frame
+   img = query_frame_source(source); // retrieve the next decoded frame
+   if(!img){
+	 printf("End of video reached\n");
+	 break;
+   }
 
 	// check that the window size is always odd and > 1
 
@@ -89,12 +103,18 @@ int main( int argc, char** argv )
    // convert colour of captured image to greyscale and perform
    // edge detection using canny edge detection algorithm
 
-   cvCvtColor(img, grayImg, CV_BGR2GRAY);
-   cvCanny(grayImg, edgeImg, lowerThreshold, upperThreshold, max(3, windowSize));
+   {
+     IpcvScopedTimer timer(IPCV_TIMING_CONVERT);
+     cvCvtColor(img, grayImg, CV_BGR2GRAY);
+   }
+   {
+     IpcvScopedTimer timer(IPCV_TIMING_PROCESS);
+     cvCanny(grayImg, edgeImg, lowerThreshold, upperThreshold, max(3, windowSize));
+   }
 
    // display image in window
 
-   cvShowImage(windowName, edgeImg);
+   ipcv_show_image(windowName, edgeImg);
 
    // start event processing loop
 
@@ -105,7 +125,7 @@ int main( int argc, char** argv )
    // we get a +ve wait time
 
 
-    key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+    key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                   (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 	if (key == 'x'){
@@ -116,20 +136,16 @@ int main( int argc, char** argv )
 	   keepProcessing = false;
 	}
 
-	// capture next frame
-
-    cvGrabFrame(capture);
-
   }
 
   // destroy window object
   // (triggered by event loop *only* window is closed)
 
-  cvDestroyWindow( windowName );
+  ipcv_destroy_window( windowName );
 
-  // release capture device
+  // release frame source (and capture device)
 
-  cvReleaseCapture(&capture);
+  release_frame_source(&source);
 
   // destroy image objects
 
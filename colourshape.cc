@@ -9,6 +9,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -31,6 +34,10 @@ using namespace std;
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
   CvCapture* capture = NULL; // capture object
 
@@ -61,29 +68,31 @@ int main( int argc, char** argv )
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-	  cvNamedWindow(windowNameHSV, 1);
-	  cvNamedWindow(windowNameCanny, 1);
+	  ipcv_named_window(windowNameHSV, 1);
+	  ipcv_named_window(windowNameCanny, 1);
 
-	  cvResizeWindow(windowNameHSV, 640, 480);
-	  cvResizeWindow(windowNameCanny, 640, 480);
-	  cvMoveWindow(windowNameHSV, 0, 100);
-  	  cvMoveWindow(windowNameCanny, 500, 20);
+	  if (!ipcv_headless()){
+		  cvResizeWindow(windowNameHSV, 640, 480);
+		  cvResizeWindow(windowNameCanny, 640, 480);
+		  cvMoveWindow(windowNameHSV, 0, 100);
+		  cvMoveWindow(windowNameCanny, 500, 20);
+	  }
 
 
 	  //setup trackbars	- canny edge detection
 
-	  cvCreateTrackbar("Lower", windowNameCanny, &cannyLower, 255, NULL);
-	  cvCreateTrackbar("Upper", windowNameCanny, &cannyUpper, 255, NULL);
+	  ipcv_create_trackbar("Lower", windowNameCanny, &cannyLower, 255, NULL);
+	  ipcv_create_trackbar("Upper", windowNameCanny, &cannyUpper, 255, NULL);
 
 	  // if capture object in use (i.e. video/camera)
 	  // get initial image from capture object
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -123,13 +132,13 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame is just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
 			  if(!img){
 				if (argc == 2){
@@ -144,6 +153,8 @@ int main( int argc, char** argv )
 
 		    // convert to HSV and extract the HUE as primary wavelength
 
+				int64 processStart = ipcv_timing_start(); // (timing of processing)
+
 				cvCvtColor(img, HSV, CV_BGR2HSV);
 				cvSetImageCOI(HSV, 1); // channel 1, 0 means all channels
 				cvCopy(HSV, singleChannelH);
@@ -182,10 +193,12 @@ int main( int argc, char** argv )
 					cvClearSeq(contours);
 				}
 
+				ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 			  // display image in window
 
-			  cvShowImage( windowNameHSV, HSV );
-			  cvShowImage( windowNameCanny, dst );
+			  ipcv_show_image( windowNameHSV, HSV );
+			  ipcv_show_image( windowNameCanny, dst );
 
 
 			  // start event processing loop (very important,in fact essential for GUI)
@@ -195,7 +208,7 @@ int main( int argc, char** argv )
               // we get a +ve wait time
 
 
-              key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+              key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));;
 
 		  if (key == 'x'){
@@ -212,7 +225,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-	  cvDestroyAllWindows();
+	  ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
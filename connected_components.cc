@@ -9,6 +9,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -59,6 +62,10 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img;  			 		// input image object
   IplImage* grayImg = NULL;  		// tmp image object
   IplImage* thresholdedImg = NULL;  // threshold output image object
@@ -91,24 +98,24 @@ int main( int argc, char** argv )
     {
       // create window objects
 
-      cvNamedWindow(windowName1, 0 );
-      cvNamedWindow(windowName2, 0 );
-      cvNamedWindow(windowName3, 0 );
+      ipcv_named_window(windowName1, 0 );
+      ipcv_named_window(windowName2, 0 );
+      ipcv_named_window(windowName3, 0 );
 
 	  // add adjustable trackbar for threshold parameter
 
-      cvCreateTrackbar("Neighbourhood (N)", windowName3, &windowSize, 255, NULL);
-	  cvCreateTrackbar("Constant (C)", windowName3, &constant, 50, NULL);
+      ipcv_create_trackbar("Neighbourhood (N)", windowName3, &windowSize, 255, NULL);
+	  ipcv_create_trackbar("Constant (C)", windowName3, &constant, 50, NULL);
 
 	  // if capture object in use (i.e. video/camera)
 	  // get initial image from capture object
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -159,10 +166,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -177,6 +184,7 @@ int main( int argc, char** argv )
 		  // if input is not already grayscale, convert to grayscale
 
 		  if (img->nChannels > 1){
+			 IpcvScopedTimer timer(IPCV_TIMING_CONVERT);
 			 cvCvtColor(img, grayImg, CV_BGR2GRAY);
 	      } else {
 			grayImg = img;
@@ -184,7 +192,7 @@ int main( int argc, char** argv )
 
 		  // display image in window
 
-		  cvShowImage( windowName2, grayImg );
+		  ipcv_show_image( windowName2, grayImg );
 
 		  // check that the window size is always odd and > 3
 
@@ -196,13 +204,19 @@ int main( int argc, char** argv )
 
 		  // threshold the image and display
 
+		  int64 processStart = ipcv_timing_start(); // (timing of processing)
+
 		  cvAdaptiveThreshold(grayImg, thresholdedImg, 255,
 		  						CV_ADAPTIVE_THRESH_MEAN_C, CV_THRESH_BINARY,
 		  						windowSize, constant);
-		  cvShowImage( windowName3, thresholdedImg );
+
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+		  ipcv_show_image( windowName3, thresholdedImg );
 
 		 // find the contours
 
+		  processStart = ipcv_timing_start();
+
 		  cvFindContours( thresholdedImg, storage,
 		  		&contours, sizeof(CvContour), CV_RETR_CCOMP, CV_CHAIN_APPROX_SIMPLE );
 
@@ -224,10 +238,12 @@ int main( int argc, char** argv )
 				cvClearSeq(contours);
 			}
 
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 
 		  // display images in window
 
-		  cvShowImage( windowName1, dst );
+		  ipcv_show_image( windowName1, dst );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 40ms per frame
@@ -237,7 +253,7 @@ int main( int argc, char** argv )
           // we get a +ve wait time
 
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -252,7 +268,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
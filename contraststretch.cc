@@ -9,6 +9,10 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+#include "ipcv_histogram.h" // shared histogram functions
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -27,42 +31,13 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 
 /******************************************************************************/
 
-// function that takes a gray scale image and draws a histogram
-// image for it in a pre-allocated image
-
-void create_histogram_image(IplImage* grayImg, IplImage* histogramImage){
-
-  CvHistogram *hist = NULL;	    // pointer to histogram object
-  float max_value = 0;			// max value in histogram
-  int hist_size = 256;			// size of histogram (number of bins)
-  int bin_w = 0;				// initial width to draw bars
-  float range_0[]={0,256};
-  float* ranges[] = { range_0 };
-
-  hist = cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1);
-
-  cvCalcHist( &grayImg, hist, 0, NULL );
-  cvGetMinMaxHistValue( hist, 0, &max_value, 0, 0 );
-  cvScale( hist->bins, hist->bins, ((double)histogramImage->height)/max_value, 0 );
-  cvSet( histogramImage, cvScalarAll(255), 0 );
-  bin_w = cvRound((double)histogramImage->width/hist_size);
-
-  for(int i = 0; i < hist_size; i++ )
-  {
-     cvRectangle( histogramImage, cvPoint(i*bin_w, histogramImage->height),
-                  cvPoint((i+1)*bin_w, histogramImage->height
-	  								- cvRound(cvGetReal1D(hist->bins,i))),
-                   					cvScalarAll(0), -1, 8, 0 );
-  }
-
-  cvReleaseHist (&hist);
-}
-
-/******************************************************************************/
-
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
 
   IplImage* stHistogramImage = NULL;  	// histogram images
@@ -91,20 +66,20 @@ int main( int argc, char** argv )
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
-	  cvNamedWindow(windowName1, 0);
-	  cvNamedWindow(windowNameH1, 0);
-	  cvNamedWindow(windowNameH2, 0);
+      ipcv_named_window(windowName, 0);
+	  ipcv_named_window(windowName1, 0);
+	  ipcv_named_window(windowNameH1, 0);
+	  ipcv_named_window(windowNameH2, 0);
 
 	  // define required images for intermediate processing
       // (if using a capture object we need to get a frame first to get the size)
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -126,6 +101,11 @@ int main( int argc, char** argv )
 	  stHistogramImage = cvCreateImage(cvSize(255,200), 8, 1);
 	  grayHistogramImage = cvCreateImage(cvSize(255,200), 8, 1);
 
+	  // histogram objects (kept for the lifetime of the loop)
+
+	  GrayHistogram* stHist = create_gray_histogram();
+	  GrayHistogram* grayHist = create_gray_histogram();
+
 	  // start main loop
 
 	  while (keepProcessing) {
@@ -137,10 +117,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -163,30 +143,35 @@ int main( int argc, char** argv )
 			  // if input is not already grayscale, convert to grayscale
 
 			  if (img->nChannels > 1){
+				  IpcvScopedTimer timer(IPCV_TIMING_CONVERT);
 				  cvCvtColor(img, grayImg, CV_BGR2GRAY);
 			  } else {
 				  grayImg = img;
 			  }
 
+			  int64 processStart = ipcv_timing_start(); // (timing of stretching)
+
 			  // contrast stretch it (cvNormalize() with these parameters does
 			  // basic constrast stretching - see opencv manual)
 
 			  cvNormalize(grayImg, stImg, 0, 255, CV_MINMAX);
 
+			  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 		  // ***
 
 		  // *** draw histograms
 
-		  create_histogram_image(grayImg, grayHistogramImage);
-		  create_histogram_image(stImg, stHistogramImage);
+		  update_histogram_image(grayHist, grayImg, grayHistogramImage);
+		  update_histogram_image(stHist, stImg, stHistogramImage);
 
 		  // display images in window
 
-		  cvShowImage( windowName,  stImg );
-		  cvShowImage( windowName1, grayImg );
+		  ipcv_show_image( windowName,  stImg );
+		  ipcv_show_image( windowName1, grayImg );
 
-		  cvShowImage( windowNameH1,  stHistogramImage );
-		  cvShowImage( windowNameH2, grayHistogramImage );
+		  ipcv_show_image( windowNameH1,  stHistogramImage );
+		  ipcv_show_image( windowNameH2, grayHistogramImage );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 4 ms roughly equates to 100ms/25fps = 4ms per frame
@@ -196,7 +181,7 @@ int main( int argc, char** argv )
           // we get a +ve wait time
 
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -212,7 +197,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
@@ -226,6 +211,8 @@ int main( int argc, char** argv )
 
 	  cvReleaseImage( &stHistogramImage );
       cvReleaseImage( &grayHistogramImage );
+	  release_gray_histogram( &stHist );
+	  release_gray_histogram( &grayHist );
 
       // all OK : main returns 0
 
@@ -11,84 +11,39 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_frame_source.h" // threaded prefetching frame source
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+#include "ipcv_dft.h" // shared DFT functions (cvShiftDFT etc.)
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
 using namespace std;
 
 /******************************************************************************/
-// Rearrange the quadrants of Fourier image so that the origin is at
-// the image center
-// src & dst arrays of equal size & type
-void cvShiftDFT(CvArr * src_arr, CvArr * dst_arr );
-
-/******************************************************************************/
-// setup the camera index / file capture properly based on OS platform
+// setup the camera index properly based on OS platform
 
 // 0 in linux gives first camera for v4l
 //-1 in windows gives first device or user dialog selection
 
 #ifdef linux
 	#define CAMERA_INDEX 0
-	#define VIDEOCAPTURE cvCaptureFromFile
 #else
 	#define CAMERA_INDEX -1
-    #define VIDEOCAPTURE cvCaptureFromAVI
 #endif
-/******************************************************************************/
-
-// return a floating point spectrum magnitude image scaled for user viewing
-
-// dft_A - input dft (2 channel floating point, Real + Imaginary fourier image)
-// rearrange - perform rearrangement of DFT quadrants if > 0
-// return value - pointer to output spectrum magnitude image scaled for user viewing
-
-IplImage* create_spectrum_magnitude_display(CvMat* dft_A, int rearrange);
 
 /******************************************************************************/
 
-// create a 2-channel butterworth-based homomorphic filter with radius D, order
-// n and homomorphic upper and lower as specified
-
-void create_butterworth_homomorphic_filter(CvMat* dft_Filter,
-int D, int n, float upper, float lower)
+int main( int argc, char** argv )
 {
-	CvMat* single = cvCreateMat(dft_Filter->rows, dft_Filter->cols, CV_64FC1 );
-
-	CvPoint centre = cvPoint(dft_Filter->rows / 2, dft_Filter->cols / 2);
-	double radius;
 
-	// create essentially create a butterworth highpass filter
-	// with additional scaling and offset
+  // process any shared command line options (e.g. --headless)
 
-	// details based on Gonzalez/Woods 3rd Edition, p293 w/ guidance from
-	// MATLAB implementation on MATLAB File Exchange
-
-	for(int i = 0; i < dft_Filter->rows; i++)
-	{
-		for(int j = 0; j < dft_Filter->cols; j++)
-		{
-			radius = (double) sqrt(pow((i - centre.x), 2.0) + pow((double) (j - centre.y), 2.0));
-			CV_MAT_ELEM(*single, double, i, j) =
-			((upper - lower) * ( 1 / (1 + pow((double) (D /  radius), (double) (2 * n))))) + lower;
-		}
-	}
-
-	// N.B. perhaps need to check that all elements of single are within a reasonable range
-	// - NOT DONE
-
-	cvMerge(single, single, NULL, NULL, dft_Filter);
-
-	cvReleaseMat(&single);
-}
-
-/******************************************************************************/
-
-int main( int argc, char** argv )
-{
+  ipcv_parse_options(&argc, argv, IPCV_REPLAY_INPUT);
 
   IplImage* img = NULL;      // image object
-  CvCapture* capture = NULL; // capture object
+  FrameSource* source = NULL; // frame source (video, raw frames or camera)
 
   IplImage* dft_spec_mag = NULL;
 
@@ -111,30 +66,28 @@ int main( int argc, char** argv )
   bool doHistEq = false;		// flag for hist. eq. output
 
   // if command line arguments are provided try to read image/video_name
-  // otherwise default to capture from attached H/W camera
+  // (or raw frame file) otherwise default to capture from attached H/W camera
 
     if(
 	  ( argc == 2 && (img = cvLoadImage( argv[1], CV_LOAD_IMAGE_UNCHANGED)) != 0 ) ||
-	  ( argc == 2 && (capture = VIDEOCAPTURE( argv[1] )) != 0 ) ||
-	  ( argc != 2 && (capture = cvCreateCameraCapture( 0 )) != 0 )
+	  ( (source = create_input_frame_source(argc, argv, 0)) != 0 )
 	  )
     {
       // create window objects (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(originalName, 0);
-	  cvNamedWindow(homomorphicName, 0);
-	  cvNamedWindow(spectrumMagName, 0);
-	  cvNamedWindow(filterName, 0);
+      ipcv_named_window(originalName, 0);
+	  ipcv_named_window(homomorphicName, 0);
+	  ipcv_named_window(spectrumMagName, 0);
+	  ipcv_named_window(filterName, 0);
 
 	  // define required floating point images for DFT processing
 	  // (if using a capture object we need to get a frame first to get the size)
 
-	  if (capture) {
+	  if (source) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // (video / camera frames are decoded on a background thread)
 
-		  img = cvQueryFrame(capture);
+		  img = query_frame_source(source);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -158,22 +111,40 @@ int main( int argc, char** argv )
 	  printf("Optimal size for DFT is height = %i, width = %i\n", dft_M, dft_N);
 
       CvMat* dft_A = cvCreateMat( dft_M, dft_N, CV_64FC2 );
-	  CvMat* dft_Filter = cvCreateMat( dft_M, dft_N, CV_64FC2 );
+	  CvMat* dft_Filter = NULL;
+
+	  // the filter is cached and only rebuilt when the trackbar values change
+
+	  ButterworthFilterCache* filterCache =
+	  			create_butterworth_filter_cache(IPCV_BUTTERWORTH_HOMOMORPHIC);
 
 	  CvMat tmp;
 	  double m, M;
       IplImage* image_Re = cvCreateImage( cvSize(dft_N, dft_M), IPL_DEPTH_64F, 1);
       IplImage* image_Im = cvCreateImage( cvSize(dft_N, dft_M), IPL_DEPTH_64F, 1);
 
-	  IplImage* image_Re_Filter = cvCreateImage( cvGetSize(dft_Filter), IPL_DEPTH_64F, 1);
+	  IplImage* image_Re_Filter = cvCreateImage( cvSize(dft_N, dft_M), IPL_DEPTH_64F, 1);
 	  IplImage* outputImg = cvCreateImage( cvSize(dft_N, dft_M), img->depth, 1);
 
+	  // arrays for the real input, single precision DFT path (--real-dft) in
+	  // which the filter is applied to the CCS packed DFT
+
+	  IplImage* logInput = NULL;
+	  IplImage* dft_R = NULL;
+	  CvMat* dft_Packed = NULL;
+
+	  if (ipcv_real_dft()){
+		  logInput = cvCreateImage( cvGetSize(img), IPL_DEPTH_32F, 1);
+		  dft_R = cvCreateImage( cvSize(dft_N, dft_M), IPL_DEPTH_32F, 1);
+		  dft_Packed = cvCreateMat( dft_M, dft_N, CV_32FC1 );
+	  }
+
 	  // add adjustable trackbar for low pass filter threshold parameter
 
-      cvCreateTrackbar("Radius D", homomorphicName, &radiusD, (min(dft_M, dft_N) / 2), NULL);
-	  cvCreateTrackbar("upper H (* 0.01)", homomorphicName, &high_h_v_TB, 200, NULL);
-	  cvCreateTrackbar("lower H (*0.01)", homomorphicName, &low_h_v_TB, 100, NULL);
-	  cvCreateTrackbar("Order n", homomorphicName, &order, 10, NULL);
+      ipcv_create_trackbar("Radius D", homomorphicName, &radiusD, (min(dft_M, dft_N) / 2), NULL);
+	  ipcv_create_trackbar("upper H (* 0.01)", homomorphicName, &high_h_v_TB, 200, NULL);
+	  ipcv_create_trackbar("lower H (*0.01)", homomorphicName, &low_h_v_TB, 100, NULL);
+	  ipcv_create_trackbar("Order n", homomorphicName, &order, 10, NULL);
 
 	  // define grayscale image
 
@@ -190,12 +161,12 @@ int main( int argc, char** argv )
 		  // if capture object in use (i.e. video/camera)
 		  // get image from capture object
 
-		  if (capture) {
+		  if (source) {
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // get the next frame already decoded by the frame source
+			  // (replaces cvQueryFrame - the frame is valid until the next call)
 
-			  img = cvQueryFrame(capture);
+			  img = query_frame_source(source);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -222,100 +193,146 @@ int main( int argc, char** argv )
 		  	  // if input is not already grayscale, convert to grayscale
 
 			  if (img->nChannels > 1){
+				  IpcvScopedTimer timer(IPCV_TIMING_CONVERT);
 				  cvCvtColor(img, grayImg, CV_BGR2GRAY);
 			  } else {
 				  grayImg = img;
 			  }
 
-		  // convert grayscale image to real part of DTF input
-
-		  cvScale(grayImg, realInput, 1.0, 0.0);
+		  // set up filter (first channel is real part / second is imaginary)
+		  // rebuilding it only if the trackbar parameters have changed
 
-		  // take the natural log of the input (compute log(1 + Mag)
+	  	  int64 processStart = ipcv_timing_start(); // (timing of filtering)
 
-		   cvAddS( realInput, cvScalarAll(1.0), realInput, NULL ); // 1 + Mag
-	 	   cvLog( realInput, realInput ); // log(1 + Mag)
+	  	  if (update_butterworth_filter(filterCache, cvSize(dft_N, dft_M), radiusD, order,
+		  							(high_h_v_TB * 0.01), (low_h_v_TB * 0.01)))
+		  {
+			  dft_Filter = filterCache->filter;
 
-		  // merge with imaginary part (initialised to all zeros)
+			  // copy and scale for display
 
-    	  cvZero(imaginaryInput);
-    	  cvMerge(realInput, imaginaryInput, NULL, NULL, complexInput);
+			  cvSplit(dft_Filter, image_Re_Filter, NULL, NULL, NULL);
+			  shift_dft_inplace(image_Re_Filter);
+			  cvMinMaxLoc(image_Re_Filter, &m, &M, NULL, NULL, NULL);
+			  cvScale(image_Re_Filter, image_Re_Filter, 1.0/(M-m), 1.0*(-m)/(M-m));
 
-		  // copy A to dft_A and pad dft_A with zeros
+			  // and convert it to packed form for the real input DFT path
 
-		  cvGetSubRect( dft_A, &tmp, cvRect(0,0, grayImg->width,grayImg->height));
-		  cvCopy( complexInput, &tmp, NULL );
-		  cvGetSubRect( dft_A, &tmp, cvRect(img->width,0, dft_A->cols - grayImg->width, grayImg->height));
-		  if ((dft_A->cols - grayImg->width) > 0)
-		  {
-		  	cvZero( &tmp );
+			  if (dft_Packed){
+				  create_packed_filter(dft_Filter, dft_Packed);
+			  }
 		  }
 
-		  // set up filter (first channel is real part / second is imaginary)
+		  if (ipcv_real_dft()){
 
-	  	  create_butterworth_homomorphic_filter(dft_Filter, radiusD, order,
-		  							(high_h_v_TB * 0.01), (low_h_v_TB * 0.01));
+			  // take the natural log of the input (compute log(1 + Mag) as
+			  // below) and its real input DFT (CCS packed, single precision)
 
-		  // copy and scale for display
+			  cvScale(grayImg, logInput, 1.0, 0.0);
+			  cvAddS( logInput, cvScalarAll(1.0), logInput, NULL );
+			  cvLog( logInput, logInput );
 
-		  cvSplit(dft_Filter, image_Re_Filter, NULL, NULL, NULL);
-		  cvMinMaxLoc(image_Re_Filter, &m, &M, NULL, NULL, NULL);
-		  cvScale(image_Re_Filter, image_Re_Filter, 1.0/(M-m), 1.0*(-m)/(M-m));
+			  cvResetImageROI( dft_R );
+			  dft_real_forward( logInput, dft_R, (CV_DXT_FORWARD | CV_DXT_SCALE) );
 
-		  // get the DFT of the original image (scaled) (and shirt quadrants)
+			  // apply filter (element-wise, no quadrant shifts needed)
 
-		  //cvDFT( dft_A, dft_A, CV_DXT_FORWARD, complexInput->height );
-		  cvDFT( dft_A, dft_A, (CV_DXT_FORWARD | CV_DXT_SCALE), complexInput->height );
+			  cvMul( dft_R, dft_Packed, dft_R, 1 );
 
-		  cvShiftDFT( dft_A, dft_A );
+			  // compute spectrum magnitude for display (re-using the image)
 
-		  // apply filter (and shift quadrants back)
+			  update_spectrum_magnitude_display(dft_R, 1, &dft_spec_mag);
 
-		  cvMulSpectrums( dft_A, dft_Filter, dft_A, 0);
-		  cvShiftDFT( dft_A, dft_A );
+			  // invert dft (giving a real image), take the exp of the image
+			  // area of the result and convert to 8-bit 255
 
-		  // compute spectrum magnitude for display
+			  cvDFT( dft_R, dft_R, CV_DXT_INV_SCALE, grayImg->height );
+			  cvSetImageROI( dft_R, cvRect(0, 0, grayImg->width, grayImg->height) );
+			  cvSetImageROI( outputImg, cvRect(0, 0, grayImg->width, grayImg->height) );
 
-		  if (dft_spec_mag != NULL){
-			  cvReleaseImage(&dft_spec_mag);
-		  }
-		  dft_spec_mag = create_spectrum_magnitude_display(dft_A, 1);
+			  cvExp( dft_R, dft_R );
+
+			  cvMinMaxLoc(dft_R, &m, &M, NULL, NULL, NULL);
+			  cvScale(dft_R, outputImg, 255.0 / (M-m), 255.0 * (-m)/(M-m));
+
+		  } else {
+
+			  // convert grayscale image to real part of DTF input
+
+			  cvScale(grayImg, realInput, 1.0, 0.0);
+
+			  // take the natural log of the input (compute log(1 + Mag)
+
+			   cvAddS( realInput, cvScalarAll(1.0), realInput, NULL ); // 1 + Mag
+		 	   cvLog( realInput, realInput ); // log(1 + Mag)
+
+			  // merge with imaginary part (initialised to all zeros)
 
-		  // invert dft
+	    	  cvZero(imaginaryInput);
+	    	  cvMerge(realInput, imaginaryInput, NULL, NULL, complexInput);
 
-		  cvDFT( dft_A, dft_A, CV_DXT_INV_SCALE, complexInput->height );
-		  //cvDFT( dft_A, dft_A, CV_DXT_INVERSE, complexInput->height );
+			  // copy A to dft_A and pad dft_A with zeros
 
-		  // take the ABS of result (as per MATLAB implementation ??)
-          // (appears not to effect result - 29/5/09
-		  // cvAbsDiffS(dft_A, dft_A, cvScalarAll(0));
+			  cvGetSubRect( dft_A, &tmp, cvRect(0,0, grayImg->width,grayImg->height));
+			  cvCopy( complexInput, &tmp, NULL );
+			  cvGetSubRect( dft_A, &tmp, cvRect(img->width,0, dft_A->cols - grayImg->width, grayImg->height));
+			  if ((dft_A->cols - grayImg->width) > 0)
+			  {
+			  	cvZero( &tmp );
+			  }
+
+			  // get the DFT of the original image (scaled)
+
+			  //cvDFT( dft_A, dft_A, CV_DXT_FORWARD, complexInput->height );
+			  cvDFT( dft_A, dft_A, (CV_DXT_FORWARD | CV_DXT_SCALE), complexInput->height );
+
+			  // apply filter (in the unshifted layout of the DFT, so no
+			  // rearrangement of the quadrants is needed)
+
+			  cvMulSpectrums( dft_A, dft_Filter, dft_A, 0);
+
+			  // compute spectrum magnitude for display (re-using the image)
+
+			  update_spectrum_magnitude_display(dft_A, 1, &dft_spec_mag);
+
+			  // invert dft
+
+			  cvDFT( dft_A, dft_A, CV_DXT_INV_SCALE, complexInput->height );
+			  //cvDFT( dft_A, dft_A, CV_DXT_INVERSE, complexInput->height );
+
+			  // take the ABS of result (as per MATLAB implementation ??)
+	          // (appears not to effect result - 29/5/09
+			  // cvAbsDiffS(dft_A, dft_A, cvScalarAll(0));
 
-		  // Split Fourier in real and imaginary parts
-		  cvSplit( dft_A, image_Re, image_Im, 0, 0 );
+			  // Split Fourier in real and imaginary parts
+			  cvSplit( dft_A, image_Re, image_Im, 0, 0 );
 
-		 // take the exp (inverse of natural log of the input)
+			 // take the exp (inverse of natural log of the input)
 
-	 	 cvExp( image_Re, image_Re );
+		 	 cvExp( image_Re, image_Re );
 
-		 cvMinMaxLoc(image_Re, &m, &M, NULL, NULL, NULL);
-		 cvScale(image_Re, image_Re, 1.0/(M-m), 1.0*(-m)/(M-m));
+			 cvMinMaxLoc(image_Re, &m, &M, NULL, NULL, NULL);
+			 cvScale(image_Re, image_Re, 1.0/(M-m), 1.0*(-m)/(M-m));
 
-		 // convert to 8-bit 255
+			 // convert to 8-bit 255
 
-		 cvMinMaxLoc(image_Re, &m, &M, NULL, NULL, NULL);
-	     cvScale(image_Re, outputImg, 255.0 / (M-m), 1.0*(-m)/(M-m));
+			 cvMinMaxLoc(image_Re, &m, &M, NULL, NULL, NULL);
+		     cvScale(image_Re, outputImg, 255.0 / (M-m), 1.0*(-m)/(M-m));
+		  }
 		 outputImg->origin = img->origin;
 
 		 if (doHistEq){
 		 	cvEqualizeHist(outputImg, outputImg);
 	 	 }
 
+	  	  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 		  // display image in window
 
-		  cvShowImage( originalName, grayImg );
-		  cvShowImage( homomorphicName, outputImg ); // N.B. floating point image
-		  cvShowImage( spectrumMagName, dft_spec_mag );
-		  cvShowImage( filterName, image_Re_Filter );
+		  ipcv_show_image( originalName, grayImg );
+		  ipcv_show_image( homomorphicName, outputImg ); // N.B. floating point image
+		  ipcv_show_image( spectrumMagName, dft_spec_mag );
+		  ipcv_show_image( filterName, image_Re_Filter );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 100ms/25fps = 40ms per frame
@@ -324,7 +341,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -347,20 +364,23 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
-      if (!capture){
+      if (!source){
 		  if (grayImg == img) {grayImg = NULL;}
 		  cvReleaseImage( &img );
-
-      }
+      }	else {
+		  // release frame source (and capture device)
+		  if (grayImg == img) {grayImg = NULL;}
+		  release_frame_source(&source);
+	  }
 
 	  // release other images
 
 	  cvReleaseMat( &dft_A);
-	  cvReleaseMat( &dft_Filter);
+	  release_butterworth_filter_cache( &filterCache );
 	  if (grayImg) {cvReleaseImage( &grayImg );}
 	  cvReleaseImage( &realInput );
 	  cvReleaseImage( &imaginaryInput );
@@ -370,6 +390,9 @@ int main( int argc, char** argv )
 	  cvReleaseImage( &dft_spec_mag );
 	  cvReleaseImage(&image_Re_Filter);
 	  cvReleaseImage(&outputImg);
+	  if (logInput) {cvReleaseImage( &logInput );}
+	  if (dft_R) {cvReleaseImage( &dft_R );}
+	  if (dft_Packed) {cvReleaseMat( &dft_Packed );}
 
       // all OK : main returns 0
 
@@ -381,112 +404,3 @@ int main( int argc, char** argv )
     return -1;
 }
 /******************************************************************************/
-// Rearrange the quadrants of Fourier image so that the origin is at
-// the image center
-// src & dst arrays of equal size & type
-void cvShiftDFT(CvArr * src_arr, CvArr * dst_arr )
-{
-    CvMat * tmp = NULL;
-    CvMat q1stub, q2stub;
-    CvMat q3stub, q4stub;
-    CvMat d1stub, d2stub;
-    CvMat d3stub, d4stub;
-    CvMat * q1, * q2, * q3, * q4;
-    CvMat * d1, * d2, * d3, * d4;
-
-    CvSize size = cvGetSize(src_arr);
-    CvSize dst_size = cvGetSize(dst_arr);
-    int cx, cy;
-
-    if(dst_size.width != size.width ||
-       dst_size.height != size.height){
-        cvError( CV_StsUnmatchedSizes,
-		   "cvShiftDFT", "Source and Destination arrays must have equal sizes",
-		   __FILE__, __LINE__ );
-    }
-
-    if(src_arr==dst_arr){
-        tmp = cvCreateMat(size.height/2, size.width/2, cvGetElemType(src_arr));
-    }
-
-    cx = size.width/2;
-    cy = size.height/2; // image center
-
-    q1 = cvGetSubRect( src_arr, &q1stub, cvRect(0,0,cx, cy) );
-    q2 = cvGetSubRect( src_arr, &q2stub, cvRect(cx,0,cx,cy) );
-    q3 = cvGetSubRect( src_arr, &q3stub, cvRect(cx,cy,cx,cy) );
-    q4 = cvGetSubRect( src_arr, &q4stub, cvRect(0,cy,cx,cy) );
-    d1 = cvGetSubRect( src_arr, &d1stub, cvRect(0,0,cx,cy) );
-    d2 = cvGetSubRect( src_arr, &d2stub, cvRect(cx,0,cx,cy) );
-    d3 = cvGetSubRect( src_arr, &d3stub, cvRect(cx,cy,cx,cy) );
-    d4 = cvGetSubRect( src_arr, &d4stub, cvRect(0,cy,cx,cy) );
-
-    if(src_arr!=dst_arr){
-        if( !CV_ARE_TYPES_EQ( q1, d1 )){
-            cvError( CV_StsUnmatchedFormats,
-			"cvShiftDFT", "Source and Destination arrays must have the same format",
-			__FILE__, __LINE__ );
-        }
-        cvCopy(q3, d1, 0);
-        cvCopy(q4, d2, 0);
-        cvCopy(q1, d3, 0);
-        cvCopy(q2, d4, 0);
-    }
-    else{
-        cvCopy(q3, tmp, 0);
-        cvCopy(q1, q3, 0);
-        cvCopy(tmp, q1, 0);
-        cvCopy(q4, tmp, 0);
-        cvCopy(q2, q4, 0);
-        cvCopy(tmp, q2, 0);
-
-		cvReleaseMat(&tmp);
-    }
-}
-/******************************************************************************/
-
-// return a floating point spectrum magnitude image scaled for user viewing
-
-// dft_A - input dft (2 channel floating point, Real + Imaginary fourier image)
-// rearrange - perform rearrangement of DFT quadrants if > 0
-// return value - pointer to output spectrum magnitude image scaled for user viewing
-
-IplImage* create_spectrum_magnitude_display(CvMat* dft_A, int rearrange)
-{
-
-	double m, M;
-    IplImage* image_Re = cvCreateImage( cvSize(dft_A->cols, dft_A->rows), IPL_DEPTH_64F, 1);
-    IplImage* image_Im = cvCreateImage( cvSize(dft_A->cols, dft_A->rows), IPL_DEPTH_64F, 1);
-
-	 // Split Fourier in real and imaginary parts
-	  cvSplit( dft_A, image_Re, image_Im, 0, 0 );
-
-	 // Compute the magnitude of the spectrum Mag = sqrt(Re^2 + Im^2)
-	 cvPow( image_Re, image_Re, 2.0);
-	 cvPow( image_Im, image_Im, 2.0);
-	 cvAdd( image_Re, image_Im, image_Re, NULL);
-	 cvPow( image_Re, image_Re, 0.5 );
-
-	 // Compute log(1 + Mag)
-	 cvAddS( image_Re, cvScalarAll(1.0), image_Re, NULL ); // 1 + Mag
-	 cvLog( image_Re, image_Re ); // log(1 + Mag)
-
-	// Rearrange the quadrants of Fourier image so that the origin is at
-	// the image center
-	if (rearrange){
-		cvShiftDFT( image_Re, image_Re );
-	}
-
-	 // scale image for display
-	 cvMinMaxLoc(image_Re, &m, &M, NULL, NULL, NULL);
-	 cvScale(image_Re, image_Re, 1.0/(M-m), 1.0*(-m)/(M-m));
-
-	 // release imaginary image part
-	 cvReleaseImage(&image_Im);
-
-	// return DFT spectrum
-
-	return image_Re;
-
-}
-/******************************************************************************/
@@ -1,17 +1,30 @@
 // Example : eigen image based recognition image / video / camera
-// usage: prog {<video_name>}
+// usage: prog [--incremental] {<video_name>}
 
 // Author : Toby Breckon, toby.breckon@cranfield.ac.uk
 
 // Copyright (c) 2008 School of Engineering, Cranfield University
 // License : LGPL - http://www.gnu.org/licenses/lgpl.html
 
+// Notes: with --incremental the model is an incremental PCA model (see
+// ipcv_pca.h) of the first NUMBER_OF_EIGENVECTORS_IN_USE eigenvectors,
+// rather than cvCalcPCA() over all of the samples - 'b' builds it from the
+// samples collected so far (a block at a time), after which each sample
+// captured updates the mean, eigenvectors and coefficients straight away
+// (at a cost independent of the number of samples already in the model)
+
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+#include "ipcv_pca.h" // incremental PCA model
+
 #include "cvaux.h"    // aux. OpenCV funcionality
 
 #include <stdio.h>    // standard C/C++ includes
+#include <string.h>
+#include <vector>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
 using namespace std;
@@ -33,15 +46,34 @@ void printhelp(){
 	printf("\nControls: \n");
 	printf("\tspace = capture a sample image\n");
 	printf("\tb = build Eigen model from sample images\n");
+	printf("\t    (with --incremental, samples may still be captured after)\n");
 	printf("\tr = recognise current image\n");
 	printf("\tx = exit\n");
 }
 
 /******************************************************************************/
 
+// copy a (single channel, 8-bit) image into one row of a matrix (row by row,
+// so any padding at the end of each image row is skipped)
+
+void image_to_row(const IplImage* img, CvMat* mat, int row)
+{
+	uchar* dst = mat->data.ptr + (row * mat->step);
+	for (int y = 0; y < img->height; y++){
+		memcpy(dst + (y * img->width), img->imageData + (y * img->widthStep),
+			   img->width);
+	}
+}
+
+/******************************************************************************/
+
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
   CvCapture* capture = NULL; // capture object
 
@@ -59,7 +91,7 @@ int main( int argc, char** argv )
 
   // data structures and matrices for eigen based face recognition
 
-  IplImage* input[MAX_NUMBER_OF_SAMPLE_IMAGES];
+  std::vector<IplImage*> input;
   CvMat* pcaInputs = NULL;
   CvMat* average = NULL;
   CvMat* eigenValues = NULL;
@@ -68,11 +100,27 @@ int main( int argc, char** argv )
   CvMat* recogniseCoeffs = NULL;
   CvMat* recognise = NULL;
 
+  IncrementalPCA* model = NULL;	// incremental model (if --incremental)
+  bool incremental = false;
+
   int imagesCollected = 0;			// number of sample images collected
 
   bool recognitionStage = false;	// flag to determine when have started
   									// recognition
 
+  // incremental model option (the remaining argument, if any, is the video)
+
+  int kept = 1;
+  for (int i = 1; i < argc; i++)
+  {
+	  if (!strcmp(argv[i], "--incremental")) {
+		  incremental = true;
+	  } else {
+		  argv[kept++] = argv[i];
+	  }
+  }
+  argc = kept;
+
   // if command line arguments are provided try to read image/video_name
   // otherwise default to capture from attached H/W camera
 
@@ -87,7 +135,7 @@ int main( int argc, char** argv )
 
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
+      ipcv_named_window(windowName, 0);
 
 	  // set up font structure
 
@@ -99,10 +147,10 @@ int main( int argc, char** argv )
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -129,10 +177,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame is just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -157,6 +205,7 @@ int main( int argc, char** argv )
 		  // if input is not already grayscale, convert to grayscale
 
 			  if (img->nChannels > 1){
+				  IpcvScopedTimer timer(IPCV_TIMING_CONVERT);
 				  cvCvtColor(img, grayImg, CV_BGR2GRAY);
 			  } else {
 				  grayImg = img;
@@ -198,7 +247,7 @@ int main( int argc, char** argv )
 		  cvLine(img, cvPoint(img->width / 2, 0),
 		  				cvPoint(img->width / 2, img->height),
 			 	 		CV_RGB(0,0,255), 1, 8 , 0);
-		  cvShowImage( windowName, img );
+		  ipcv_show_image( windowName, img );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
@@ -207,7 +256,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -220,10 +269,24 @@ int main( int argc, char** argv )
 
 	   		// if user presses " " then capture an image
 
-			if (!recognitionStage) {
+			if (incremental) {
+
+				// (no limit on the number of samples - once the model is
+				// built, each sample updates it)
+
+				input.push_back(cvCloneImage(grayImg));
+				imagesCollected++;
+				printf("Sample image collected - %i\n", imagesCollected);
+
+				if (recognitionStage) {
+					add_pca_images(model, &(input[imagesCollected - 1]), 1);
+					printf("Eigenimage model updated (%d eigenvectors in use)\n",
+							pca_components(model));
+				}
+			} else if (!recognitionStage) {
 				 if (imagesCollected < MAX_NUMBER_OF_SAMPLE_IMAGES)
 				 {
-					input[imagesCollected] = cvCloneImage(grayImg);
+					input.push_back(cvCloneImage(grayImg));
 					imagesCollected++;
 					printf("Sample image collected - %i\n", imagesCollected);
 				 } else {
@@ -237,7 +300,30 @@ int main( int argc, char** argv )
 	   		// if user presses "b" then build model and move
 			// into recognition mode
 
-			if (imagesCollected > 2) {
+			if ((imagesCollected > 2) && (incremental)) {
+
+			// build (or bring up to date) the incremental model from the
+			// samples not yet in it
+
+			if (!model) {
+				model = create_incremental_pca(input[0]->width * input[0]->height,
+											   NUMBER_OF_EIGENVECTORS_IN_USE);
+			}
+			int added = pca_sample_count(model);
+
+			printf("\nBuilding Eigenimage model for %i images ... ",
+					imagesCollected - added);
+			fflush(NULL);
+
+			if (imagesCollected > added) {
+				add_pca_images(model, &(input[added]), imagesCollected - added);
+			}
+
+			printf("Done (%d eigenvectors in use)\n", pca_components(model));
+
+			recognitionStage = true;
+
+			} else if (imagesCollected > 2) {
 
 			printf("\nBuilding Eigenimage model for %i images ... ", imagesCollected);
 			fflush(NULL);
@@ -257,9 +343,7 @@ int main( int argc, char** argv )
 			recognise = cvCreateMat(1, input[0]->width * input[0]->height, CV_8UC1);
 
 			for (int i = 0; i < imagesCollected; i++){
-				for (int j = 0; j < (input[0]->width * input[0]->height); j++){
-					CV_MAT_ELEM(*pcaInputs, uchar, i, j) = (input[i])->imageData[(j)];
-				}
+				image_to_row(input[i], pcaInputs, i);
 			}
 
 			// compute eigen image representation
@@ -283,13 +367,29 @@ int main( int argc, char** argv )
 
 			// if user presses "r" then do recognition
 
-			  if (recognitionStage) {
+			  int64 processStart = ipcv_timing_start(); // (timing of recognition)
+
+			  if ((recognitionStage) && (incremental)) {
+
+				// find the closest sample in the incremental model
+
+				double closestCoeffDistance = 0;
+				int closestImage = nearest_pca_sample(model, grayImg,
+													  &closestCoeffDistance);
+
+				ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
+				printf("Recognition - closest matching image = %d\n", closestImage);
+				ipcv_named_window("Recognition Result", 1 );
+                ipcv_show_image("Recognition Result", input[closestImage]);
+				ipcv_wait_key(0);
+				ipcv_destroy_window("Recognition Result");
+
+			  } else if (recognitionStage) {
 
 				// project image to eigen space
 
-			  	for (int j = 0; j < (input[0]->width * input[0]->height); j++){
-					CV_MAT_ELEM(*recognise, uchar, 0, j) = (grayImg)->imageData[(j)];
-				}
+				image_to_row(grayImg, recognise, 0);
 
 				cvProjectPCA(recognise, average, eigens, recogniseCoeffs);
 
@@ -314,11 +414,13 @@ int main( int argc, char** argv )
 					}
 				}
 
+				ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 				printf("Recognition - closest matching image = %d\n", closestImage);
-				cvNamedWindow("Recognition Result", 1 );
-                cvShowImage("Recognition Result", input[closestImage]);
-				cvWaitKey(0);
-				cvDestroyWindow("Recognition Result");
+				ipcv_named_window("Recognition Result", 1 );
+                ipcv_show_image("Recognition Result", input[closestImage]);
+				ipcv_wait_key(0);
+				ipcv_destroy_window("Recognition Result");
 
 			} else {
 				printf("ERROR - need a build eigen model before recognition.\n");
@@ -329,7 +431,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
@@ -339,6 +441,8 @@ int main( int argc, char** argv )
 	  cvReleaseImage(&grayImg);
 	  for (int i = 0; i < imagesCollected; i++){cvReleaseImage( &(input[i]));}
 
+	  release_incremental_pca(&model);
+
 	  // release matrix objects
 
 	  cvReleaseMat( &pcaInputs);
@@ -9,6 +9,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -30,6 +33,10 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img;  			 	 // input image object
   IplImage* erodeImage = NULL;   // erode image object
   IplImage* dilateImage = NULL;  // dilate image object
@@ -58,23 +65,23 @@ int main( int argc, char** argv )
     {
       // create window objects
 
-      cvNamedWindow(windowName1, 0 );
-      cvNamedWindow(windowName2, 0 );
+      ipcv_named_window(windowName1, 0 );
+      ipcv_named_window(windowName2, 0 );
 
 	  // add adjustable trackbar for threshold parameter
 
-      cvCreateTrackbar("iterations", windowName1, &erode, 10, NULL);
-	  cvCreateTrackbar("iterations", windowName2, &dilate, 10, NULL);
+      ipcv_create_trackbar("iterations", windowName1, &erode, 10, NULL);
+	  ipcv_create_trackbar("iterations", windowName2, &dilate, 10, NULL);
 
 	  // if capture object in use (i.e. video/camera)
 	  // get initial image from capture object
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -106,10 +113,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -123,13 +130,17 @@ int main( int argc, char** argv )
 
 		  // do erode / dilate
 
+		  int64 processStart = ipcv_timing_start(); // (timing of morphology)
+
 		  cvErode(img, erodeImage, NULL,  erode);
 		  cvDilate(img, dilateImage, NULL,  dilate);
 
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 		  // display images in window
 
-		  cvShowImage( windowName1, erodeImage );
-		  cvShowImage( windowName2, dilateImage );
+		  ipcv_show_image( windowName1, erodeImage );
+		  ipcv_show_image( windowName2, dilateImage );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 4 ms roughly equates to 100ms/25fps = 4ms per frame
@@ -138,7 +149,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -153,7 +164,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
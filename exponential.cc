@@ -9,6 +9,10 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+#include "ipcv_lut.h" // lookup table point transforms
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -30,6 +34,10 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
   CvCapture* capture = NULL; // capture object
 
@@ -56,13 +64,13 @@ int main( int argc, char** argv )
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName1, 0);
-	  cvNamedWindow(windowName2, 0);
+      ipcv_named_window(windowName1, 0);
+	  ipcv_named_window(windowName2, 0);
 
 	  // add adjustable trackbar for parameters
 
-      cvCreateTrackbar("Constant", windowName1, &constant, 50, NULL);
-	  cvCreateTrackbar("Alpha (* 0.001)", windowName1, &alpha_mult, 25, NULL);
+      ipcv_create_trackbar("Constant", windowName1, &constant, 50, NULL);
+	  ipcv_create_trackbar("Alpha (* 0.001)", windowName1, &alpha_mult, 25, NULL);
 
 
 	  // define required images for intermediate processing
@@ -70,10 +78,10 @@ int main( int argc, char** argv )
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -95,6 +103,10 @@ int main( int argc, char** argv )
 	  			cvCreateImage(cvSize(img->width,img->height), img->depth, 1);
 	  expImg->origin = img->origin;
 
+	  // lookup table for the transform (rebuilt as the parameters change)
+
+	  PointTransformLUT* expLUT = create_point_transform_lut(exponential_transform, 2);
+
 	  // start main loop
 
 	  while (keepProcessing) {
@@ -106,10 +118,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -125,26 +137,28 @@ int main( int argc, char** argv )
 		  // if input is not already grayscale, convert to grayscale
 
 			  if (img->nChannels > 1){
+				  IpcvScopedTimer timer(IPCV_TIMING_CONVERT);
 				  cvCvtColor(img, grayImg, CV_BGR2GRAY);
 			  } else {
 				  grayImg = img;
 			  }
 
-		  // do the exp of image (as per formula in lecture 8)
+		  // do the exp of image (as per formula in lecture 8) - evaluated once
+		  // for each of the 256 possible input values into a lookup table
+		  // (only when the parameters change) and then applied to the image
 
-		  for(int i=0; i < img->width; i++){
-			for(int j=0; j < img->height; j++){
-			  CV_IMAGE_ELEM((IplImage*) expImg, uchar, j, (i * grayImg->nChannels))
-				= (uchar) constant *
-				(pow((1 + (alpha * alpha_mult)),
-				CV_IMAGE_ELEM((IplImage*) grayImg, uchar, j, (i * grayImg->nChannels))) -1);
-			}
-		  }
+		  int64 processStart = ipcv_timing_start(); // (timing of transform)
+
+		  double params[2] = {(double) (uchar) constant, alpha * alpha_mult};
+		  update_point_transform_lut(expLUT, params);
+		  apply_point_transform_lut(expLUT, grayImg, expImg);
+
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
 
 		  // display images in window
 
-		  cvShowImage( windowName1, expImg );
-		  cvShowImage( windowName2, grayImg );
+		  ipcv_show_image( windowName1, expImg );
+		  ipcv_show_image( windowName2, grayImg );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
@@ -153,7 +167,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -168,7 +182,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image objects (if it does not originate from a capture object)
 
@@ -177,6 +191,7 @@ int main( int argc, char** argv )
       }
 	  cvReleaseImage(&grayImg);
 	  cvReleaseImage(&expImg);
+	  release_point_transform_lut(&expLUT);
 
       // all OK : main returns 0
 
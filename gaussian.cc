@@ -9,6 +9,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -30,6 +33,10 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
   IplImage* smooth = NULL;   // tmp image object
   CvCapture* capture = NULL; // capture object
@@ -55,22 +62,22 @@ int main( int argc, char** argv )
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName1, 0);
-	  cvNamedWindow(windowName2, 0);
+      ipcv_named_window(windowName1, 0);
+	  ipcv_named_window(windowName2, 0);
 
 	  // add adjustable trackbar for window size parameter
 
-      cvCreateTrackbar("Neighbourhood (N)", windowName1, &windowSize, 100, NULL);
+      ipcv_create_trackbar("Neighbourhood (N)", windowName1, &windowSize, 100, NULL);
 
 	  // if capture object in use (i.e. video/camera)
 	  // get initial image from capture object
 
 	  if (capture) {
 
-		  // cvQueryFrame is just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -99,10 +106,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -122,13 +129,17 @@ int main( int argc, char** argv )
 			  windowSize = 3;
 		  }
 
+		  int64 processStart = ipcv_timing_start(); // (timing of smoothing)
+
 		  // Gaussian smooth image
 		  cvSmooth(img, smooth, CV_GAUSSIAN, windowSize, windowSize);
 
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 		  // display images in window
 
-		  cvShowImage( windowName1, smooth );
-		  cvShowImage( windowName2, img);
+		  ipcv_show_image( windowName1, smooth );
+		  ipcv_show_image( windowName2, img);
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 40ms per frame
@@ -137,7 +148,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -152,7 +163,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
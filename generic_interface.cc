@@ -10,6 +10,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_frame_source.h" // threaded prefetching frame source
+#include "ipcv_interface.h" // headless aware display interface
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -31,8 +34,12 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv, IPCV_REPLAY_INPUT);
+
   IplImage* img = NULL;      // image object
-  CvCapture* capture = NULL; // capture object
+  FrameSource* source = NULL; // frame source (image, video, camera or replay)
 
   char const * windowName = "Cranfield University: "; // window name
 
@@ -44,15 +51,15 @@ int main( int argc, char** argv )
   // if command line arguments are provided try to read image/video_name
   // otherwise default to capture from attached H/W camera
 
-    if(
-	  ( argc == 2 && (img = cvLoadImage( argv[1], CV_LOAD_IMAGE_UNCHANGED)) != 0 ) ||
-	  ( argc == 2 && (capture = cvCreateFileCapture( argv[1] )) != 0 ) ||
-	  ( argc != 2 && (capture = cvCreateCameraCapture( CAMERA_INDEX )) != 0 )
-	  )
+  // (N.B. with --replay the frames come from memory instead - see
+  // ipcv_frame_source.h)
+
+    if ((source = create_input_frame_source(argc, argv, CAMERA_INDEX)) != 0)
     {
+
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
+      ipcv_named_window(windowName, 0);
 
 	  // start main loop
 
@@ -60,27 +67,22 @@ int main( int argc, char** argv )
 
           int64 timeStart = getTickCount(); // get time at start of loop
 
-		  // if capture object in use (i.e. video/camera)
-		  // get image from capture object
-
-		  if (capture) {
-
-			  // cvQueryFrame is just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
-
-			  img = cvQueryFrame(capture);
-			  if(!img){
-				if (argc == 2){
-					printf("End of video file reached\n");
-				} else {
-					printf("ERROR: cannot get next fram from camera\n");
-				}
-				exit(0);
-			  }
+		  // get the next frame from the frame source
+		  // (replaces cvQueryFrame - the frame is valid until the next call)
+
+		  img = query_frame_source(source);
+		  if(!img){
+			if (argc == 2){
+				printf("End of video file reached\n");
+			} else {
+				printf("ERROR: cannot get next fram from camera\n");
+			}
+			exit(0);
+		  }
 
-		  }	else {
+		  if (frame_source_is_image(source)){
 
-			  // if not a capture object set event delay to zero so it waits
+			  // if not a video / camera set event delay to zero so it waits
 			  // indefinitely (as single image file, no need to loop)
 
 			  EVENT_LOOP_DELAY = 0;
@@ -94,7 +96,7 @@ int main( int argc, char** argv )
 
 		  // display image in window
 
-		  cvShowImage( windowName, img );
+		  ipcv_show_image( windowName, img );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
@@ -103,7 +105,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -118,16 +120,11 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
-      // destroy image object (if it does not originate from a capture object)
+      // release frame source (and any image or capture device)
 
-      if (!capture){
-		  cvReleaseImage( &img );
-      }	else {
-		  	// release capture device
-	  		cvReleaseCapture(&capture);
-	  }
+      release_frame_source(&source);
 
       // all OK : main returns 0
 
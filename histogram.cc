@@ -9,6 +9,10 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+#include "ipcv_histogram.h" // shared histogram functions
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -30,6 +34,10 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
   IplImage* grayImg = NULL;  // image object
   IplImage* hist_img = NULL; // histogram image object
@@ -43,12 +51,7 @@ int main( int argc, char** argv )
   int  EVENT_LOOP_DELAY = 40;	// delay for GUI window
                                 // 40 ms equates to 1000ms/25fps = 40ms per frame
 
-  CvHistogram *hist = NULL;	    // pointer to histogram object
-  float max_value = 0;			// max value in histogram
-  int hist_size = 256;			// size of histogram (number of bins)
-  int bin_w = 0;				// initial width to draw bars
-  float range_0[]={0,256};
-  float* ranges[] = { range_0 };
+  GrayHistogram *hist = NULL;	// pointer to histogram object
 
   // if command line arguments are provided try to read image/video_name
   // otherwise default to capture from attached H/W camera
@@ -61,12 +64,12 @@ int main( int argc, char** argv )
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
-	  cvNamedWindow(windowNameHist, 0);
+      ipcv_named_window(windowName, 0);
+	  ipcv_named_window(windowNameHist, 0);
 
 	  // create histogram + image to draw it in
 
-	  hist = cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1);
+	  hist = create_gray_histogram();
 	  hist_img = cvCreateImage(cvSize(255,200), 8, 1);
 
 	  // if capture object in use (i.e. video/camera)
@@ -74,10 +77,10 @@ int main( int argc, char** argv )
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -103,10 +106,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame is just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -127,31 +130,26 @@ int main( int argc, char** argv )
 		  // get a grayscale version of the image
 
 		  if (img->nChannels > 1){
+		  	IpcvScopedTimer timer(IPCV_TIMING_CONVERT);
 		  	cvCvtColor(img, grayImg, CV_BGR2GRAY);
 		  } else {
 			grayImg = img;
 		  }
 		  grayImg->origin = img->origin;
 
-		  // calc and display histogram (from opencv demhist.c example)
+		  // calc and display histogram (counted and drawn directly into the
+		  // histogram image, as per the opencv demhist.c example)
 
-		  cvCalcHist( &grayImg, hist, 0, NULL );
-    	  cvGetMinMaxHistValue( hist, 0, &max_value, 0, 0 );
-    	  cvScale( hist->bins, hist->bins, ((double)hist_img->height)/max_value, 0 );
-    	  cvSet( hist_img, cvScalarAll(255), 0 );
-    	  bin_w = cvRound((double)hist_img->width/hist_size);
+		  int64 processStart = ipcv_timing_start(); // (timing of histogram)
 
-    	  for(int i = 0; i < hist_size; i++ )
-		  {
-        		cvRectangle( hist_img, cvPoint(i*bin_w, hist_img->height),
-            		         cvPoint((i+1)*bin_w, hist_img->height - cvRound(cvGetReal1D(hist->bins,i))),
-                		     cvScalarAll(0), -1, 8, 0 );
-		  }
+		  update_histogram_image(hist, grayImg, hist_img);
+
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
 
 		  // display image in window
 
-		  cvShowImage(windowNameHist, hist_img );
-		  cvShowImage( windowName, grayImg );
+		  ipcv_show_image(windowNameHist, hist_img );
+		  ipcv_show_image( windowName, grayImg );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
@@ -160,7 +158,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -175,7 +173,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
@@ -184,7 +182,7 @@ int main( int argc, char** argv )
       }
 	  cvReleaseImage( &grayImg );
 	  cvReleaseImage( &hist_img );
-	  cvReleaseHist( &hist );
+	  release_gray_histogram( &hist );
 
 
       // all OK : main returns 0
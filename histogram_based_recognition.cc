@@ -1,15 +1,35 @@
 // Example : basic histogram based recognition from video / camera
-// usage: prog {<video_name>}
+// usage: prog [--gallery <file>] [--ann <probes>] {<video_name>}
 
 // Author : Toby Breckon, toby.breckon@cranfield.ac.uk
 
 // Copyright (c) 2008 School of Engineering, Cranfield University
 // License : LGPL - http://www.gnu.org/licenses/lgpl.html
 
+// Notes: the sample histograms are held in a histogram gallery (see
+// ipcv_gallery.h), with no limit on the number of samples - with --gallery
+// <file> the gallery is loaded from the file (if it exists) at the start,
+// so samples collected in earlier runs are recognised, and saved on exit
+// (a file that exists but is not a complete gallery of the same histograms
+// is an error, so it is never overwritten).
+// With --ann <probes> the samples are also held in an approximate nearest
+// neighbour index of their Hellinger transforms (see ipcv_ann.h) and only
+// the few nearest samples found by the index (searching <probes> clusters,
+// 0 = all) are compared by the four measures, rather than every sample
+
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+#include "ipcv_gallery.h" // gallery of normalised histograms
+#include "ipcv_ann.h" // nearest neighbour index of histograms
+
 #include <stdio.h>    // standard C/C++ includes
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <vector>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
 
@@ -27,6 +47,16 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 
 /******************************************************************************/
 
+// largest gallery for which the comparison with every sample is printed
+
+#define MAX_PRINTED_COMPARISONS 32
+
+// number of nearest samples (from the index) compared by the four measures
+
+#define ANN_SHORTLIST 10
+
+/******************************************************************************/
+
 void printhelp(){
 	printf("\nControls: \n");
 	printf("\tspace = capture a sample image\n");
@@ -41,6 +71,10 @@ void printhelp(){
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
   CvCapture* capture = NULL; // capture object
 
@@ -51,9 +85,11 @@ int main( int argc, char** argv )
   int  EVENT_LOOP_DELAY = 40;	// delay for GUI window
                                 // 40 ms equates to 1000ms/25fps = 40ms per frame
 
+  const char* galleryFile = NULL;	// gallery file (loaded / saved)
+  int probes = -1;					// index probes (-1 = no index)
+
   // histogram specific stuff
 
-  #define MAX_NUMBER_OF_SAMPLE_IMAGES 255
   int hist_size = 256;			// size of histogram (number of bins)
   float range_0[]={0,hist_size};
   float* ranges[] = { range_0 };
@@ -61,15 +97,80 @@ int main( int argc, char** argv )
   					cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1);
 
   // data structures and matrices for histogram based recognition
+  // (the sample images of the gallery, NULL for those loaded from a file)
 
-  IplImage* input[MAX_NUMBER_OF_SAMPLE_IMAGES];
-  CvHistogram* histogram[MAX_NUMBER_OF_SAMPLE_IMAGES];
+  HistogramGallery* gallery = NULL;
+  std::vector<IplImage*> input;
+  std::vector<GalleryComparison> comparisons;
+  HellingerIndex* index = NULL;
+  std::vector<HellingerNeighbour> neighbours;
+  std::vector<float> transform(hist_size);
 
   int imagesCollected = 0;			// number of sample images collected
 
   bool recognitionStage = false;	// flag to determine when have started
   									// recognition
 
+  // gallery / index options (the remaining argument, if any, is the video)
+
+  int kept = 1;
+  for (int i = 1; i < argc; i++)
+  {
+	  if ((!strcmp(argv[i], "--gallery")) && (i + 1 < argc)) {
+		  galleryFile = argv[++i];
+	  } else if ((!strcmp(argv[i], "--ann")) && (i + 1 < argc)) {
+		  probes = std::max(0, atoi(argv[++i]));
+	  } else {
+		  argv[kept++] = argv[i];
+	  }
+  }
+  argc = kept;
+
+  // load the gallery (if the file exists) or start an empty one - a file
+  // that exists but cannot be loaded is fatal (rather than overwritten, and
+  // its samples lost, on exit)
+
+  if (galleryFile) {
+	  FILE* file = fopen(galleryFile, "rb");
+	  if (file) {
+		  fclose(file);
+		  gallery = load_histogram_gallery(galleryFile);
+		  if (!gallery) {
+			  printf("ERROR: cannot load gallery %s - exiting\n", galleryFile);
+			  return -1;
+		  }
+	  } else if (errno != ENOENT) {
+		  printf("ERROR: cannot open gallery %s - exiting\n", galleryFile);
+		  return -1;
+	  }
+  }
+  if ((gallery) && (gallery_bins(gallery) != hist_size)) {
+	  printf("ERROR: gallery %s is not of %i bin histograms - exiting\n",
+			 galleryFile, hist_size);
+	  release_histogram_gallery(&gallery);
+	  return -1;
+  }
+  if (gallery) {
+	  imagesCollected = gallery_size(gallery);
+	  input.assign(imagesCollected, (IplImage*) NULL);
+	  printf("Gallery loaded - %i samples from %s\n", imagesCollected, galleryFile);
+  } else {
+	  gallery = create_histogram_gallery(hist_size);
+  }
+
+  // index all of the gallery histograms (if an index is wanted)
+
+  if (probes >= 0)
+  {
+	  index = create_hellinger_index(hist_size, probes);
+	  for (int i = 0; i < gallery_size(gallery); i++)
+	  {
+		  hellinger_transform_values(gallery_histogram(gallery, i), hist_size,
+									 &(transform[0]));
+		  add_hellinger_vector(index, &(transform[0]));
+	  }
+  }
+
   // if command line arguments are provided try to read image/video_name
   // otherwise default to capture from attached H/W camera
 
@@ -84,7 +185,7 @@ int main( int argc, char** argv )
 
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
+      ipcv_named_window(windowName, 0);
 
 	  // set up font structure
 
@@ -96,10 +197,10 @@ int main( int argc, char** argv )
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -126,10 +227,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame is just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -148,6 +249,7 @@ int main( int argc, char** argv )
 		  // if input is not already grayscale, convert to grayscale
 
 			  if (img->nChannels > 1){
+				  IpcvScopedTimer timer(IPCV_TIMING_CONVERT);
 				  cvCvtColor(img, grayImg, CV_BGR2GRAY);
 			  } else {
 				  grayImg = img;
@@ -163,7 +265,7 @@ int main( int argc, char** argv )
 			cvPutText(img, "RECOGNITION",
 			  		cvPoint(10,img->height - 10), &font, CV_RGB(255, 0 ,0));
 		  }
-		  cvShowImage( windowName, img );
+		  ipcv_show_image( windowName, img );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
@@ -172,7 +274,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -187,25 +289,21 @@ int main( int argc, char** argv )
 	   		// if user presses " " then capture a sample image
 
 			if (!recognitionStage) {
-				 if (imagesCollected < MAX_NUMBER_OF_SAMPLE_IMAGES)
-				 {
 
-					// copy image + build/store image histogram
+					// copy image + build/store image histogram (in the gallery)
 
-				    input[imagesCollected] = cvCloneImage(grayImg);
-					histogram[imagesCollected] =
-					 	 cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1);
-					cvCalcHist( &grayImg, histogram[imagesCollected], 0, NULL );
-					cvNormalizeHist(histogram[imagesCollected], 1);
+				    input.push_back(cvCloneImage(grayImg));
+					cvCalcHist( &grayImg, currentHistogram, 0, NULL );
+					int sample = add_gallery_histogram(gallery, currentHistogram);
+					if (index) {
+						hellinger_transform_values(gallery_histogram(gallery, sample),
+												   hist_size, &(transform[0]));
+						add_hellinger_vector(index, &(transform[0]));
+					}
 
 					imagesCollected++;
 
 					printf("Sample image collected - %i\n", imagesCollected);
-
-				 } else {
-					printf("ERROR: Maximum sample images (%d) collected.\n",
-													 imagesCollected);
-				 }
 		   }
 
 		  } else if ((key == '\n') || (key == 'm')) { // use "m" in windows
@@ -222,6 +320,8 @@ int main( int argc, char** argv )
 
 			// if user presses "r" then do recognition
 
+			  int64 processStart = ipcv_timing_start(); // (timing of recognition)
+
 			  // calc current image histogram
 
 			  cvCalcHist( &grayImg, currentHistogram, 0, NULL );
@@ -229,49 +329,59 @@ int main( int argc, char** argv )
 
 			  if (recognitionStage) {
 
-				// for each histogram (do comparison
-
-				double closestDistance = HUGE;
-				int closestImage = 0;
-
-				for (int i = 0; i < imagesCollected; i++)
-				{
-
-					// do histogram comparision here
+				// compare with every histogram in the gallery (all four
+				// measures in one pass over each) and find the closest - or,
+				// with an index, with only the nearest few found by the index
+
+				GalleryComparison closest;
+				bool printAll = (imagesCollected <= MAX_PRINTED_COMPARISONS);
+				int closestImage = -1;
+
+				if (index) {
+					hellinger_transform(currentHistogram, &(transform[0]));
+					search_hellinger_index(index, &(transform[0]), ANN_SHORTLIST,
+										   &neighbours);
+					comparisons.resize(neighbours.size());
+					for (size_t i = 0; i < neighbours.size(); i++)
+					{
+						compare_gallery_histogram(gallery, currentHistogram,
+												  neighbours[i].index, &(comparisons[i]));
+						if ((closestImage < 0) ||
+							(comparisons[i].distance < closest.distance)) {
+							closest = comparisons[i];
+							closestImage = closest.index;
+						}
+					}
+					printAll = true;
+				} else {
+					closestImage = match_histogram_gallery(gallery, currentHistogram,
+											&closest, printAll ? &comparisons : NULL);
+				}
 
-					double correlation = cvCompareHist(currentHistogram,
-												histogram[i],CV_COMP_CORREL);
-					double chisquared = cvCompareHist(currentHistogram,
-												histogram[i],CV_COMP_CHISQR);
-					double intersect = cvCompareHist(currentHistogram,
-												histogram[i],CV_COMP_INTERSECT);
-					double bhattacharyya = cvCompareHist(currentHistogram,
-												histogram[i],CV_COMP_BHATTACHARYYA);
+				ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
 
-					// here we just sum the differences of the measures
-					// (which as the histograms are all normalised are all
-					// measures in the range -1->0->1)
+				// here the distance is just the sum of the differences of the
+				// measures (which as the histograms are all normalised are all
+				// measures in the range -1->0->1)
 
-					// N.B. For the OpenCV implementation:
-					// low correlation = large difference (so we invert it)
-					// low intersection = large difference (so we invert it)
-					// high chisquared = large differences
-					// high bhatt. = large difference
-					// - and vice versa
+				// N.B. For the OpenCV implementation:
+				// low correlation = large difference (so we invert it)
+				// low intersection = large difference (so we invert it)
+				// high chisquared = large differences
+				// high bhatt. = large difference
+				// - and vice versa
 
-					double diff = (1 - correlation) + chisquared
-											+ (1 - intersect) + bhattacharyya;
+				if (!printAll) {
+					comparisons.assign(1, closest);
+				}
+				for (size_t i = 0; (closestImage >= 0) && (i < comparisons.size()); i++)
+				{
+					GalleryComparison& c = comparisons[i];
 
 					printf("Comparison image %i Corr: %.3f ChiSq: %.3f",
-												i, correlation, chisquared);
+												c.index, c.correlation, c.chisquared);
 					printf(" Intersect: %.3f Bhatt: %.3f Total Distance = %.3f\n",
-												intersect, bhattacharyya, diff);
-
-					if (diff < closestDistance){
-						closestDistance = diff;
-						closestImage = i;
-
-					}
+												c.intersect, c.bhattacharyya, c.distance);
 				}
 
 				printf("\n");
@@ -279,12 +389,19 @@ int main( int argc, char** argv )
 				// output the result in a window
 
 				printf("Recognition - closest matching image = %d\n", closestImage);
-				printf("Press any key to clear. \n\n");
 
-				cvNamedWindow("Recognition Result", 1 );
-                cvShowImage("Recognition Result", input[closestImage]);
-				cvWaitKey(0);
-				cvDestroyWindow("Recognition Result");
+				// (a sample loaded from the gallery file has no image to show)
+
+				if ((closestImage >= 0) && (input[closestImage])) {
+					printf("Press any key to clear. \n\n");
+
+					ipcv_named_window("Recognition Result", 1 );
+	                ipcv_show_image("Recognition Result", input[closestImage]);
+					ipcv_wait_key(0);
+					ipcv_destroy_window("Recognition Result");
+				} else {
+					printf("\n");
+				}
 
 			} else {
 				printf("ERROR - need to enter recognition stage first.\n");
@@ -295,7 +412,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
@@ -303,11 +420,26 @@ int main( int argc, char** argv )
 		  cvReleaseImage( &img );
       }
 	  cvReleaseImage(&grayImg);
-	  for (int i = 0; i < imagesCollected; i++)
+	  for (size_t i = 0; i < input.size(); i++)
 		  {
-			  cvReleaseImage( &(input[i]));
-			  cvReleaseHist( &(histogram[i]));
+			  if (input[i]) {
+				  cvReleaseImage( &(input[i]));
+			  }
 		  }
+	  cvReleaseHist( &currentHistogram );
+
+	  // save the gallery (for the next run)
+
+	  if (galleryFile) {
+		  if (save_histogram_gallery(gallery, galleryFile)) {
+			  printf("Gallery saved - %i samples to %s\n", gallery_size(gallery),
+					 galleryFile);
+		  } else {
+			  printf("ERROR: cannot save gallery to %s\n", galleryFile);
+		  }
+	  }
+	  release_hellinger_index(&index);
+	  release_histogram_gallery(&gallery);
 
       // all OK : main returns 0
 
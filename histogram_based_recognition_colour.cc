@@ -1,16 +1,39 @@
 // Example : basic histogram based recognition from video / camera
 //           using all three R, G, B colour channels
-// usage: prog {<video_name>}
+// usage: prog [--joint <levels>] [--ann <probes>] {<video_name>}
 
 // Author : Toby Breckon, toby.breckon@cranfield.ac.uk
 
 // Copyright (c) 2009 School of Engineering, Cranfield University
 // License : LGPL - http://www.gnu.org/licenses/lgpl.html
 
+// Notes: with --joint <levels> each image is described by a single joint
+// colour histogram (levels bins per channel, levels^3 in all - see
+// ipcv_histogram.h) counted in one pass over the BGR pixels, rather than by
+// three 256 bin channel histograms, and the samples are held in a histogram
+// gallery (see ipcv_gallery.h) - so one histogram is compared by the four
+// measures per sample, in one pass over it, rather than three.
+
+// With --ann <probes> the samples are also held in an approximate
+// nearest neighbour index (see ipcv_ann.h) of the Hellinger transforms of
+// their histograms (the three channel histograms concatenated, each
+// weighted by 1/3, or the joint histogram) and
+// only the few nearest samples found by the index (searching <probes>
+// clusters, 0 = all) are compared by the four measures, not every sample
+
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+#include "ipcv_ann.h" // nearest neighbour index of histograms
+#include "ipcv_gallery.h" // gallery of normalised histograms
+#include "ipcv_histogram.h" // joint colour histogram
+
 #include <stdio.h>    // standard C/C++ includes
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
 
@@ -28,6 +51,12 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 
 /******************************************************************************/
 
+// number of nearest samples (from the index) compared by the four measures
+
+#define ANN_SHORTLIST 10
+
+/******************************************************************************/
+
 void printhelp(){
 	printf("\nControls: \n");
 	printf("\tspace = capture a sample image\n");
@@ -42,6 +71,10 @@ void printhelp(){
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
   CvCapture* capture = NULL; // capture object
 
@@ -54,7 +87,6 @@ int main( int argc, char** argv )
 
   // histogram specific stuff
 
-  #define MAX_NUMBER_OF_SAMPLE_IMAGES 255
   int hist_size = 256;			// size of histogram (number of bins)
   float range_0[]={0, float(hist_size)};
   float* ranges[] = { range_0 };
@@ -67,16 +99,64 @@ int main( int argc, char** argv )
 
   // data structures and matrices for histogram based recognition
 
-  IplImage* input[MAX_NUMBER_OF_SAMPLE_IMAGES];
-  CvHistogram* histogramR[MAX_NUMBER_OF_SAMPLE_IMAGES];
-  CvHistogram* histogramG[MAX_NUMBER_OF_SAMPLE_IMAGES];
-  CvHistogram* histogramB[MAX_NUMBER_OF_SAMPLE_IMAGES];
+  std::vector<IplImage*> input;
+  std::vector<CvHistogram*> histogramR;
+  std::vector<CvHistogram*> histogramG;
+  std::vector<CvHistogram*> histogramB;
 
   int imagesCollected = 0;			// number of sample images collected
 
+  int levels = 0;					// joint histogram levels (0 = channels)
+  int joint_size = 0;				// joint histogram bins (levels^3)
+  CvHistogram* currentJoint = NULL;
+  HistogramGallery* gallery = NULL;	// (joint histograms of the samples)
+  std::vector<GalleryComparison> comparisons;
+
+  int probes = -1;					// index probes (-1 = no index)
+  HellingerIndex* index = NULL;
+  std::vector<HellingerNeighbour> neighbours;
+  std::vector<int> candidates;		// samples compared with the current image
+  std::vector<float> transform;
+
   bool recognitionStage = false;	// flag to determine when have started
   									// recognition
 
+  // joint histogram / index options (the remaining argument, if any, is
+  // the video)
+
+  int kept = 1;
+  for (int i = 1; i < argc; i++)
+  {
+	  if ((!strcmp(argv[i], "--joint")) && (i + 1 < argc)) {
+		  levels = atoi(argv[++i]);
+	  } else if ((!strcmp(argv[i], "--ann")) && (i + 1 < argc)) {
+		  probes = std::max(0, atoi(argv[++i]));
+	  } else {
+		  argv[kept++] = argv[i];
+	  }
+  }
+  argc = kept;
+
+  // (levels must be a power of 2, at most 256)
+
+  if ((levels < 0) || (levels > 256) || (levels & (levels - 1)))
+  {
+	  printf("ERROR: joint histogram levels must be a power of 2 (up to 256)\n");
+	  levels = 0;
+  }
+  if (levels)
+  {
+	  joint_size = levels * levels * levels;
+	  currentJoint = cvCreateHist(1, &joint_size, CV_HIST_ARRAY, NULL, 1);
+	  gallery = create_histogram_gallery(joint_size);
+  }
+
+  int dims = (levels) ? joint_size : 3 * hist_size;
+  transform.resize(dims);
+  if (probes >= 0) {
+	  index = create_hellinger_index(dims, probes);
+  }
+
   // if command line arguments are provided try to read image/video_name
   // otherwise default to capture from attached H/W camera
 
@@ -91,7 +171,7 @@ int main( int argc, char** argv )
 
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
+      ipcv_named_window(windowName, 0);
 
 	  // set up font structure
 
@@ -103,10 +183,10 @@ int main( int argc, char** argv )
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -143,10 +223,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame is just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -167,7 +247,7 @@ int main( int argc, char** argv )
 			cvPutText(img, "RECOGNITION",
 			  		cvPoint(10,img->height - 20), &font, CV_RGB(255, 0 ,0));
 		  }
-		  cvShowImage( windowName, img );
+		  ipcv_show_image( windowName, img );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
@@ -176,7 +256,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -190,9 +270,26 @@ int main( int argc, char** argv )
 
 	   		// if user presses " " then capture a sample image
 
-			if (!recognitionStage) {
-				 if (imagesCollected < MAX_NUMBER_OF_SAMPLE_IMAGES)
-				 {
+			if ((!recognitionStage) && (levels)) {
+
+					// copy image + build/store joint histogram (in the gallery)
+					// and index it
+
+				    input.push_back(cvCloneImage(img));
+
+					calc_joint_colour_histogram(img, levels, currentJoint);
+					int sample = add_gallery_histogram(gallery, currentJoint);
+					if (index) {
+						hellinger_transform_values(gallery_histogram(gallery, sample),
+												   joint_size, &(transform[0]));
+						add_hellinger_vector(index, &(transform[0]));
+					}
+
+					imagesCollected++;
+
+					printf("Sample image collected - %i\n", imagesCollected);
+
+			} else if (!recognitionStage) {
 
 					// split image into R, G and B channels and
 					// store histograms (rememeber - BGR!)
@@ -201,31 +298,36 @@ int main( int argc, char** argv )
 
 					// copy image + build/store image histograms
 
-				    input[imagesCollected] = cvCloneImage(img);
+				    input.push_back(cvCloneImage(img));
 
-					histogramR[imagesCollected] =
-					 	 cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1);
+					histogramR.push_back(
+					 	 cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1));
 					cvCalcHist( &channelR, histogramR[imagesCollected], 0, NULL );
 					cvNormalizeHist(histogramR[imagesCollected], 1);
 
-					histogramG[imagesCollected] =
-					 	 cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1);
+					histogramG.push_back(
+					 	 cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1));
 					cvCalcHist( &channelG, histogramG[imagesCollected], 0, NULL );
 					cvNormalizeHist(histogramG[imagesCollected], 1);
 
-					histogramB[imagesCollected] =
-					 	 cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1);
+					histogramB.push_back(
+					 	 cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1));
 					cvCalcHist( &channelB, histogramB[imagesCollected], 0, NULL );
 					cvNormalizeHist(histogramB[imagesCollected], 1);
 
+					// (and index them)
+
+					if (index) {
+						float* t = &(transform[0]);
+						t += hellinger_transform(histogramR[imagesCollected], t, 1. / 3);
+						t += hellinger_transform(histogramG[imagesCollected], t, 1. / 3);
+						hellinger_transform(histogramB[imagesCollected], t, 1. / 3);
+						add_hellinger_vector(index, &(transform[0]));
+					}
+
 					imagesCollected++;
 
 					printf("Sample image collected - %i\n", imagesCollected);
-
-				 } else {
-					printf("ERROR: Maximum sample images (%d) collected.\n",
-													 imagesCollected);
-				 }
 		   }
 
 		  } else if ((key == '\n') || (key == 'm')) { // use "m" in windows
@@ -242,28 +344,90 @@ int main( int argc, char** argv )
 
 			// if user presses "r" then do recognition
 
-			  // get the colour channels (rememeber - BGR!)
+			  int64 processStart = ipcv_timing_start(); // (timing of recognition)
+
+			  if (levels) {
+
+				  // calc current image joint histogram
+
+				  calc_joint_colour_histogram(img, levels, currentJoint);
+			  } else {
+
+				  // get the colour channels (rememeber - BGR!)
 
-			  cvSplit(img, channelB, channelG, channelR, NULL);
+				  cvSplit(img, channelB, channelG, channelR, NULL);
 
-			  // calc current image channel histograms
+				  // calc current image channel histograms
 
-			  cvCalcHist( &channelR, currentHistogramR, 0, NULL );
-			  cvNormalizeHist( currentHistogramR, 1);
-			  cvCalcHist( &channelG, currentHistogramG, 0, NULL );
-			  cvNormalizeHist( currentHistogramG, 1);
-			  cvCalcHist( &channelB, currentHistogramB, 0, NULL );
-			  cvNormalizeHist( currentHistogramB, 1);
+				  cvCalcHist( &channelR, currentHistogramR, 0, NULL );
+				  cvNormalizeHist( currentHistogramR, 1);
+				  cvCalcHist( &channelG, currentHistogramG, 0, NULL );
+				  cvNormalizeHist( currentHistogramG, 1);
+				  cvCalcHist( &channelB, currentHistogramB, 0, NULL );
+				  cvNormalizeHist( currentHistogramB, 1);
+			  }
 
 			  if (recognitionStage) {
 
+				// the samples to compare - all of them, or with an index
+				// only the nearest few found by the index
+
+				// (for joint histograms the four measures of each are found
+				// here, by the gallery)
+
+				candidates.clear();
+				comparisons.clear();
+				if (levels) {
+					if (index) {
+						hellinger_transform(currentJoint, &(transform[0]));
+						search_hellinger_index(index, &(transform[0]), ANN_SHORTLIST,
+											   &neighbours);
+						comparisons.resize(neighbours.size());
+						for (size_t n = 0; n < neighbours.size(); n++) {
+							compare_gallery_histogram(gallery, currentJoint,
+													  neighbours[n].index, &(comparisons[n]));
+						}
+					} else {
+						match_histogram_gallery(gallery, currentJoint, NULL, &comparisons);
+					}
+					for (size_t n = 0; n < comparisons.size(); n++) {
+						candidates.push_back(comparisons[n].index);
+					}
+				} else if (index) {
+					float* t = &(transform[0]);
+					t += hellinger_transform(currentHistogramR, t, 1. / 3);
+					t += hellinger_transform(currentHistogramG, t, 1. / 3);
+					hellinger_transform(currentHistogramB, t, 1. / 3);
+					search_hellinger_index(index, &(transform[0]), ANN_SHORTLIST,
+										   &neighbours);
+					for (size_t n = 0; n < neighbours.size(); n++) {
+						candidates.push_back(neighbours[n].index);
+					}
+				} else {
+					for (int i = 0; i < imagesCollected; i++) {
+						candidates.push_back(i);
+					}
+				}
+
 				// for each histogram do comparison
 
 				double closestDistance = HUGE;
 				int closestImage = 0;
 
-				for (int i = 0; i < imagesCollected; i++)
+				for (size_t n = 0; n < candidates.size(); n++)
 				{
+					int i = candidates[n];
+					double correlation, chisquared, intersect, bhattacharyya;
+
+					if (levels) {
+
+						// (the measures of the joint histograms, found above)
+
+						correlation = comparisons[n].correlation;
+						chisquared = comparisons[n].chisquared;
+						intersect = comparisons[n].intersect;
+						bhattacharyya = comparisons[n].bhattacharyya;
+					} else {
 
 					// do histogram comparision here
 
@@ -271,26 +435,27 @@ int main( int argc, char** argv )
 					// just add the measures for all three channels
 					// and divide by 3 - i.e. averaging them)
 
-					double correlation = ((
+					correlation = ((
 						cvCompareHist(currentHistogramR, histogramR[i],CV_COMP_CORREL) +
 						cvCompareHist(currentHistogramG, histogramG[i],CV_COMP_CORREL) +
 						cvCompareHist(currentHistogramB, histogramB[i],CV_COMP_CORREL)) / 3.0);
 
-					double chisquared = ((
+					chisquared = ((
 						cvCompareHist(currentHistogramR, histogramR[i],CV_COMP_CHISQR) +
 						cvCompareHist(currentHistogramG, histogramG[i],CV_COMP_CHISQR) +
 						cvCompareHist(currentHistogramB, histogramB[i],CV_COMP_CHISQR)) / 3.0);
 
-					double intersect =	((
+					intersect =	((
 						cvCompareHist(currentHistogramR, histogramR[i],CV_COMP_INTERSECT) +
 						cvCompareHist(currentHistogramG, histogramG[i],CV_COMP_INTERSECT) +
 						cvCompareHist(currentHistogramB, histogramB[i],CV_COMP_INTERSECT)) / 3.0);
 
 
-					double bhattacharyya = 	((
+					bhattacharyya = 	((
 						cvCompareHist(currentHistogramR, histogramR[i],CV_COMP_BHATTACHARYYA) +
 						cvCompareHist(currentHistogramG, histogramG[i],CV_COMP_BHATTACHARYYA) +
 						cvCompareHist(currentHistogramB, histogramB[i],CV_COMP_BHATTACHARYYA)) / 3.0);
+					}
 
 					// here we just sum the differences of the measures
 					// (which as the histograms are all normalised are all
@@ -318,6 +483,8 @@ int main( int argc, char** argv )
 					}
 				}
 
+				ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 				printf("\n");
 
 				// output the result in a window
@@ -325,10 +492,10 @@ int main( int argc, char** argv )
 				printf("Recognition - closest matching image = %d\n", closestImage);
 				printf("Press any key to clear. \n\n");
 
-				cvNamedWindow("Recognition Result", 1 );
-                cvShowImage("Recognition Result", input[closestImage]);
-				cvWaitKey(0);
-				cvDestroyWindow("Recognition Result");
+				ipcv_named_window("Recognition Result", 1 );
+                ipcv_show_image("Recognition Result", input[closestImage]);
+				ipcv_wait_key(0);
+				ipcv_destroy_window("Recognition Result");
 
 			} else {
 				printf("ERROR - need to enter recognition stage first.\n");
@@ -339,7 +506,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
@@ -350,9 +517,12 @@ int main( int argc, char** argv )
 	  cvReleaseImage(&channelG);
 	  cvReleaseImage(&channelR);
 
-	for (int i = 0; i < imagesCollected; i++)
+	for (size_t i = 0; i < input.size(); i++)
 		  {
 			  cvReleaseImage( &(input[i]));
+		  }
+	for (size_t i = 0; i < histogramR.size(); i++)
+		  {
 			  cvReleaseHist( &(histogramR[i]));
 			  cvReleaseHist( &(histogramG[i]));
 			  cvReleaseHist( &(histogramB[i]));
@@ -362,6 +532,12 @@ int main( int argc, char** argv )
 	  cvReleaseHist( &currentHistogramG );
 	  cvReleaseHist( &currentHistogramB );
 
+	  release_hellinger_index(&index);
+	  release_histogram_gallery(&gallery);
+	  if (currentJoint) {
+		  cvReleaseHist( &currentJoint );
+	  }
+
 	  // all OK : main returns 0
 
       return 0;
@@ -9,6 +9,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -30,6 +33,10 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
   CvCapture* capture = NULL; // capture object
 
@@ -60,22 +67,22 @@ int main( int argc, char** argv )
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
-	  cvNamedWindow(controls, 0);
- 	  cvCreateTrackbar("Upper", controls, &upperThreshold, 255, NULL);
-	  cvCreateTrackbar("Min. Distance", controls, &minDistance, 200, NULL);
-      cvCreateTrackbar("threshold", controls, &houghThreshold, 255, NULL);
-	  cvCreateTrackbar("Min. Radius", controls, &minRadius, 100, NULL);
-      cvCreateTrackbar("Max. Radius", controls, &maxRadius, 255, NULL);
+      ipcv_named_window(windowName, 0);
+	  ipcv_named_window(controls, 0);
+ 	  ipcv_create_trackbar("Upper", controls, &upperThreshold, 255, NULL);
+	  ipcv_create_trackbar("Min. Distance", controls, &minDistance, 200, NULL);
+      ipcv_create_trackbar("threshold", controls, &houghThreshold, 255, NULL);
+	  ipcv_create_trackbar("Min. Radius", controls, &minRadius, 100, NULL);
+      ipcv_create_trackbar("Max. Radius", controls, &maxRadius, 255, NULL);
 
       // (if using a capture object we need to get a frame first to get the size)
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -104,10 +111,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame is just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -127,10 +134,16 @@ int main( int argc, char** argv )
 
 		  // compute gray image
 
+		  int64 convertStart = ipcv_timing_start(); // (timing of grayscale conversion)
+
 		  cvCvtColor( img, gray_dst, CV_BGR2GRAY );
 
+		  ipcv_timing_stop(IPCV_TIMING_CONVERT, convertStart);
+
 		  // get hough lines
 
+		  int64 processStart = ipcv_timing_start(); // (timing of circle detection)
+
 		  if (minDistance == 0){minDistance++;}
 		  if (upperThreshold == 0){upperThreshold++;}
 		  if (houghThreshold == 0){houghThreshold++;}
@@ -149,9 +162,11 @@ int main( int argc, char** argv )
 			}
 		    cvClearSeq(circles);
 
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 		  // display image in window
 
-		  cvShowImage( windowName, img );
+		  ipcv_show_image( windowName, img );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
@@ -160,7 +175,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -175,7 +190,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
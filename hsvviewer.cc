@@ -9,6 +9,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -30,6 +33,10 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      	 // image object
   IplImage*	HSVimg = NULL;   	 // HSV image object
   IplImage*	HSVimg_out = NULL;   // HSV image object
@@ -56,20 +63,20 @@ int main( int argc, char** argv )
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
-	  cvNamedWindow(windowNameH, 0);
-	  cvNamedWindow(windowNameS, 0);
-	  cvNamedWindow(windowNameV, 0);
+      ipcv_named_window(windowName, 0);
+	  ipcv_named_window(windowNameH, 0);
+	  ipcv_named_window(windowNameS, 0);
+	  ipcv_named_window(windowNameV, 0);
 
 	  // define required channel images for display processing
 	  // (if using a capture object we need to get a frame first to get the size)
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -120,10 +127,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -143,6 +150,8 @@ int main( int argc, char** argv )
 
 		  // colour transform images
 
+		  int64 processStart = ipcv_timing_start(); // (timing of colour space conversion)
+
 		  cvCvtColor(img, HSVimg, CV_BGR2HSV);
 
 		  // split image into channels remembering BGR ordering of OpenCV
@@ -157,12 +166,14 @@ int main( int argc, char** argv )
 		  cvMerge(h_channel, s_channel_out, v_channel_out, NULL, HSVimg);
 		  cvCvtColor(HSVimg, HSVimg_out, CV_HSV2BGR);
 
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 		  // display images in windows
 
-		  cvShowImage( windowName, img );
-		  cvShowImage( windowNameH, h_channel );
-		  cvShowImage( windowNameS, s_channel );
-		  cvShowImage( windowNameV, v_channel );
+		  ipcv_show_image( windowName, img );
+		  ipcv_show_image( windowNameH, h_channel );
+		  ipcv_show_image( windowNameS, s_channel );
+		  ipcv_show_image( windowNameV, v_channel );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 4 ms roughly equates to 100ms/25fps = 4ms per frame
@@ -171,7 +182,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -186,7 +197,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
@@ -0,0 +1,312 @@
+// Module : approximate nearest neighbour index of Hellinger transformed
+//          histograms for the histogram based recognition examples
+// usage: see ipcv_ann.h
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+#include "ipcv_ann.h"
+
+#include <math.h>
+#include <float.h>
+#include <algorithm> // contains max() function (amongst others)
+
+/******************************************************************************/
+
+#define KMEANS_ITERATIONS 8		// k-means iterations per training
+#define KMEANS_SAMPLES 64		// training vectors per cluster (at most)
+
+struct HellingerIndex
+{
+	int dims;						// length of each vector
+	int probes;						// clusters searched per query (0 = all)
+	std::vector<float> vectors;		// all of the vectors, one row of dims each
+	std::vector<float> centroids;	// cluster centres, one row of dims each
+	std::vector<std::vector<int> > lists;	// vectors of each cluster
+	int trained;					// index size when the clusters were trained
+									// (0 = not clustered, searched exhaustively)
+	CvRNG rng;						// (choice of training vectors)
+};
+
+/******************************************************************************/
+
+void hellinger_transform_values(const float* h, int n, float* out, double weight)
+{
+	double sum = 0;
+	for (int i = 0; i < n; i++) {
+		sum += h[i];
+	}
+	double scale = (fabs(sum) > DBL_EPSILON) ? weight / sum : 0.;
+	for (int i = 0; i < n; i++) {
+		out[i] = (float) sqrt(std::max(0., h[i] * scale));
+	}
+}
+
+int hellinger_transform(const CvHistogram* hist, float* out, double weight)
+{
+	CvMat stub;
+	CvMat* mat = cvGetMat(hist->bins, &stub, 0, 1);
+	int n = mat->rows * mat->cols;
+
+	hellinger_transform_values(mat->data.fl, n, out, weight);
+	return n;
+}
+
+/******************************************************************************/
+
+// squared Euclidean distance of two vectors
+
+static float distance2(const float* a, const float* b, int n)
+{
+	float d2 = 0;
+	for (int i = 0; i < n; i++)
+	{
+		float d = a[i] - b[i];
+		d2 += d * d;
+	}
+	return d2;
+}
+
+// nearest cluster centre to a vector
+
+static int nearest_centroid(const HellingerIndex* index, const float* v)
+{
+	int n = index->dims;
+	int best = 0;
+	float bestD2 = FLT_MAX;
+
+	for (size_t c = 0; c < index->lists.size(); c++)
+	{
+		float d2 = distance2(v, &(index->centroids[c * n]), n);
+		if (d2 < bestD2)
+		{
+			bestD2 = d2;
+			best = (int) c;
+		}
+	}
+	return best;
+}
+
+/******************************************************************************/
+
+// (re)train the clusters by k-means over a sample of the vectors and put every
+// vector in the list of its nearest cluster
+
+static void train_index(HellingerIndex* index)
+{
+	int n = index->dims;
+	int count = hellinger_index_size(index);
+	int clusters = std::max(1, cvRound(sqrt((double) count)));
+
+	// a random sample of the vectors (the first clusters of which are the
+	// initial centres)
+
+	std::vector<int> sample(count);
+	for (int i = 0; i < count; i++) {
+		sample[i] = i;
+	}
+	int samples = std::min(count, clusters * KMEANS_SAMPLES);
+	for (int i = 0; i < samples; i++) {
+		std::swap(sample[i], sample[i + (cvRandInt(&(index->rng)) % (count - i))]);
+	}
+	sample.resize(samples);
+
+	index->centroids.assign((size_t) clusters * n, 0.f);
+	for (int c = 0; c < clusters; c++) {
+		std::copy(&(index->vectors[(size_t) sample[c] * n]),
+				  &(index->vectors[(size_t) sample[c] * n]) + n,
+				  &(index->centroids[(size_t) c * n]));
+	}
+	index->lists.assign(clusters, std::vector<int>());
+
+	std::vector<int> assigned(samples);
+	std::vector<float> sums((size_t) clusters * n);
+	std::vector<int> members(clusters);
+
+	for (int it = 0; it < KMEANS_ITERATIONS; it++)
+	{
+		for (int i = 0; i < samples; i++) {
+			assigned[i] = nearest_centroid(index, &(index->vectors[(size_t) sample[i] * n]));
+		}
+
+		// each centre moved to the mean of its samples (or, if it has none,
+		// to a random sample)
+
+		std::fill(sums.begin(), sums.end(), 0.f);
+		std::fill(members.begin(), members.end(), 0);
+		for (int i = 0; i < samples; i++)
+		{
+			const float* v = &(index->vectors[(size_t) sample[i] * n]);
+			float* s = &(sums[(size_t) assigned[i] * n]);
+			for (int j = 0; j < n; j++) {
+				s[j] += v[j];
+			}
+			members[assigned[i]]++;
+		}
+		for (int c = 0; c < clusters; c++)
+		{
+			float* centre = &(index->centroids[(size_t) c * n]);
+			if (members[c])
+			{
+				const float* s = &(sums[(size_t) c * n]);
+				for (int j = 0; j < n; j++) {
+					centre[j] = s[j] / members[c];
+				}
+			} else {
+				int r = sample[cvRandInt(&(index->rng)) % samples];
+				std::copy(&(index->vectors[(size_t) r * n]),
+						  &(index->vectors[(size_t) r * n]) + n, centre);
+			}
+		}
+	}
+
+	for (int i = 0; i < count; i++) {
+		index->lists[nearest_centroid(index, &(index->vectors[(size_t) i * n]))].push_back(i);
+	}
+	index->trained = count;
+}
+
+/******************************************************************************/
+
+HellingerIndex* create_hellinger_index(int dims, int probes)
+{
+	HellingerIndex* index = new HellingerIndex;
+
+	index->dims = dims;
+	index->probes = std::max(probes, 0);
+	index->trained = 0;
+	index->rng = cvRNG(0x1234);
+
+	return index;
+}
+
+/******************************************************************************/
+
+void set_hellinger_index_probes(HellingerIndex* index, int probes)
+{
+	index->probes = std::max(probes, 0);
+}
+
+/******************************************************************************/
+
+int add_hellinger_vector(HellingerIndex* index, const float* vector)
+{
+	int n = index->dims;
+	int i = hellinger_index_size(index);
+
+	index->vectors.insert(index->vectors.end(), vector, vector + n);
+
+	// cluster the index once it is large enough (and again each time it has
+	// grown by IPCV_ANN_RETRAIN_FACTOR), otherwise add the vector to the list
+	// of its nearest cluster
+
+	int count = i + 1;
+	if (((!index->trained) && (count >= IPCV_ANN_MIN_CLUSTERED)) ||
+		((index->trained) && (count >= index->trained * IPCV_ANN_RETRAIN_FACTOR))) {
+		train_index(index);
+	} else if (index->trained) {
+		index->lists[nearest_centroid(index, vector)].push_back(i);
+	}
+	return i;
+}
+
+/******************************************************************************/
+
+int hellinger_index_size(const HellingerIndex* index)
+{
+	return (int) (index->vectors.size() / index->dims);
+}
+
+/******************************************************************************/
+
+// (for sorting candidates by distance, then index)
+
+static bool nearer(const HellingerNeighbour& a, const HellingerNeighbour& b)
+{
+	return (a.distance < b.distance) ||
+		   ((a.distance == b.distance) && (a.index < b.index));
+}
+
+/******************************************************************************/
+
+int search_hellinger_index(HellingerIndex* index, const float* query, int k,
+						   std::vector<HellingerNeighbour>* neighbours)
+{
+	int n = index->dims;
+	int count = hellinger_index_size(index);
+	int clusters = (int) index->lists.size();
+	std::vector<HellingerNeighbour> candidates;
+	HellingerNeighbour c;
+
+	if ((!index->trained) || (index->probes == 0) || (index->probes >= clusters))
+	{
+		// exhaustive search
+
+		candidates.resize(count);
+		for (int i = 0; i < count; i++)
+		{
+			candidates[i].index = i;
+			candidates[i].distance = distance2(query, &(index->vectors[(size_t) i * n]), n);
+		}
+	} else {
+
+		// search the lists of the probes nearest clusters
+
+		std::vector<HellingerNeighbour> centres(clusters);
+		for (int i = 0; i < clusters; i++)
+		{
+			centres[i].index = i;
+			centres[i].distance = distance2(query, &(index->centroids[(size_t) i * n]), n);
+		}
+		std::partial_sort(centres.begin(), centres.begin() + index->probes,
+						  centres.end(), nearer);
+
+		for (int p = 0; p < index->probes; p++)
+		{
+			const std::vector<int>& list = index->lists[centres[p].index];
+			for (size_t j = 0; j < list.size(); j++)
+			{
+				c.index = list[j];
+				c.distance = distance2(query, &(index->vectors[(size_t) c.index * n]), n);
+				candidates.push_back(c);
+			}
+		}
+	}
+
+	// the k nearest (as Hellinger distances, ||a - b|| / sqrt(2))
+
+	k = std::min(std::max(k, 1), (int) candidates.size());
+	std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(),
+					  nearer);
+	candidates.resize(k);
+	for (int i = 0; i < k; i++) {
+		candidates[i].distance = sqrtf(candidates[i].distance * 0.5f);
+	}
+
+	if (neighbours) {
+		*neighbours = candidates;
+	}
+	return (k > 0) ? candidates[0].index : -1;
+}
+
+/******************************************************************************/
+
+void clear_hellinger_index(HellingerIndex* index)
+{
+	index->vectors.clear();
+	index->centroids.clear();
+	index->lists.clear();
+	index->trained = 0;
+}
+
+/******************************************************************************/
+
+void release_hellinger_index(HellingerIndex** index)
+{
+	if ((index) && (*index))
+	{
+		delete *index;
+		*index = NULL;
+	}
+}
+
+/******************************************************************************/
@@ -0,0 +1,103 @@
+// Module : approximate nearest neighbour index of Hellinger transformed
+//          histograms for the histogram based recognition examples
+// usage: #include "ipcv_ann.h" (link with the ipcv library)
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: the Hellinger transform of a histogram (the square root of each bin,
+// normalised to sum to 1) turns the Bhattacharyya distance into a Euclidean
+// one - sum (sqrt(p) - sqrt(q))^2 = 2 (1 - sum sqrt(p q)) - so histograms are
+// ranked the same by the Euclidean distance of their transforms as by the
+// Bhattacharyya measure of cvCompareHist().
+
+// The index clusters the transformed histograms by k-means (sqrt(N) clusters,
+// an inverted file) and a query only compares against the histograms of the
+// few clusters nearest to it (the number of probes, the recall / speed knob).
+// Histograms are inserted one at a time - each into its nearest cluster, with
+// the clusters trained again each time the index has grown by a factor of
+// IPCV_ANN_RETRAIN_FACTOR - and a small index is just searched exhaustively.
+
+#ifndef IPCV_ANN_H
+#define IPCV_ANN_H
+
+#include "cv.h"       // open cv general include file
+
+#include <vector>
+
+/******************************************************************************/
+
+#define IPCV_ANN_MIN_CLUSTERED 1024	// index size at which clustering starts
+#define IPCV_ANN_RETRAIN_FACTOR 4	// growth at which clusters are retrained
+#define IPCV_ANN_DEFAULT_PROBES 8	// clusters searched per query (default)
+
+// a neighbour returned by a search
+
+typedef struct HellingerNeighbour
+{
+	int index;				// index of the histogram (in insertion order)
+	float distance;			// Hellinger distance (0 = identical, 1 = disjoint)
+} HellingerNeighbour;
+
+typedef struct HellingerIndex HellingerIndex;
+
+/******************************************************************************/
+
+// Hellinger transform of a (1D) histogram - out[i] = sqrt(weight * h[i] / sum)
+
+// hist - histogram
+// out - returned transform (as many values as the histogram has bins)
+// weight - weight of the histogram (e.g. 1 / 3 for each of the three
+//          histograms of a colour image, concatenated into one vector)
+// return value - number of values (bins) written
+
+int hellinger_transform(const CvHistogram* hist, float* out, double weight = 1.);
+
+// as above, for the n bins of a histogram given as values
+
+void hellinger_transform_values(const float* h, int n, float* out, double weight = 1.);
+
+/******************************************************************************/
+
+// create an (empty) index
+
+// dims - length of each (transformed) histogram vector
+// probes - clusters searched per query (0 = all, i.e. an exact search)
+// return value - pointer to index
+
+HellingerIndex* create_hellinger_index(int dims, int probes = IPCV_ANN_DEFAULT_PROBES);
+
+// set the number of clusters searched per query (0 = all) - more gives a
+// higher recall, fewer a faster search
+
+void set_hellinger_index_probes(HellingerIndex* index, int probes);
+
+// insert a (transformed) histogram vector of dims values
+// return value - index of the histogram (in insertion order)
+
+int add_hellinger_vector(HellingerIndex* index, const float* vector);
+
+// number of histograms in the index
+
+int hellinger_index_size(const HellingerIndex* index);
+
+// find the (approximate) k nearest histograms to a (transformed) query
+
+// query - query vector (of dims values)
+// k - number of neighbours
+// neighbours - if not NULL, returned neighbours (nearest first)
+// return value - index of the nearest histogram, or -1 if the index is empty
+
+int search_hellinger_index(HellingerIndex* index, const float* query, int k,
+						   std::vector<HellingerNeighbour>* neighbours);
+
+// remove all of the histograms
+
+void clear_hellinger_index(HellingerIndex* index);
+
+// release the index
+
+void release_hellinger_index(HellingerIndex** index);
+
+/******************************************************************************/
+
+#endif
@@ -0,0 +1,344 @@
+// Module : shared hue histogram / CAMSHIFT tracking functions for
+//          camshift_tracking.cc and multi_camshift_tracking.cc
+// usage: see ipcv_camshift.h
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+#include "ipcv_camshift.h"
+
+#include <algorithm> // contains max() function (amongst others)
+#include <thread>
+#include <atomic>
+
+/******************************************************************************/
+
+CvRect camshift_search_region(CvRect window, int margin, CvSize size)
+{
+	int x0 = std::max(0, window.x - margin);
+	int y0 = std::max(0, window.y - margin);
+	int x1 = std::min(size.width, window.x + window.width + margin);
+	int y1 = std::min(size.height, window.y + window.height + margin);
+
+	// (a window that has left the frame gives the whole frame)
+
+	if ((x1 <= x0) || (y1 <= y0)) {
+		return cvRect(0, 0, size.width, size.height);
+	}
+	return cvRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+/******************************************************************************/
+
+// reciprocal tables of the fixed point BGR to HSV conversion of cvCvtColor()
+// (CV_BGR2HSV, 8-bit) - so that the fused conversion below gives exactly the
+// same hue and saturation, with no division per pixel
+
+#define HSV_SHIFT 12
+
+struct HSVTables
+{
+	int sdiv[256];		// (255 << HSV_SHIFT) / v
+	int hdiv[256];		// (180 << HSV_SHIFT) / (6 * (max - min))
+
+	HSVTables()
+	{
+		sdiv[0] = hdiv[0] = 0;
+		for (int i = 1; i < 256; i++)
+		{
+			sdiv[i] = cvRound((255 << HSV_SHIFT) / (1. * i));
+			hdiv[i] = cvRound((180 << HSV_SHIFT) / (6. * i));
+		}
+	}
+};
+
+static const HSVTables& hsv_tables()
+{
+	static HSVTables tables;
+	return tables;
+}
+
+/******************************************************************************/
+
+void hue_and_mask(IplImage* img, IplImage* hue, IplImage* mask, CvRect region,
+				  int smin, int vmin, int vmax)
+{
+	const HSVTables& t = hsv_tables();
+	const int round = 1 << (HSV_SHIFT - 1);
+	int cn = img->nChannels;
+	int vlow = std::min(vmin, vmax);
+	int vhigh = std::max(vmin, vmax);
+
+	// a single pass over the region: the hue of each pixel (as the H channel
+	// of CV_BGR2HSV) and the mask of saturation in {smin ... 256} and value in
+	// {vlow ... vhigh} (as cvInRangeS() in OpenCV 2.4, i.e. the bounds
+	// inclusive - the saturation upper bound always holds)
+
+	for (int y = region.y; y < region.y + region.height; y++)
+	{
+		const uchar* src = (const uchar*) (img->imageData + (y * img->widthStep)) +
+						   (region.x * cn);
+		uchar* h = (uchar*) (hue->imageData + (y * hue->widthStep)) + region.x;
+		uchar* m = (uchar*) (mask->imageData + (y * mask->widthStep)) + region.x;
+
+		for (int x = 0; x < region.width; x++, src += cn)
+		{
+			int b = src[0], g = src[1], r = src[2];
+			int v = std::max(b, std::max(g, r));
+			int diff = v - std::min(b, std::min(g, r));
+			int s = ((diff * t.sdiv[v]) + round) >> HSV_SHIFT;
+			int hv;
+
+			if (v == r) {
+				hv = g - b;
+			} else if (v == g) {
+				hv = (b - r) + (2 * diff);
+			} else {
+				hv = (r - g) + (4 * diff);
+			}
+			hv = ((hv * t.hdiv[diff]) + round) >> HSV_SHIFT;
+			hv += (hv < 0) ? 180 : 0;
+
+			h[x] = (uchar) hv;
+			m[x] = ((s >= smin) && (v >= vlow) && (v <= vhigh)) ? 255 : 0;
+		}
+	}
+}
+
+/******************************************************************************/
+
+// back project the hue histogram (masked) and run CAMSHIFT from the track
+// window within one region - using matrix headers over the region (rather
+// than image ROIs) so that the shared hue / mask are never modified and
+// several regions can be processed at once
+
+static bool camshift_in_region(IplImage* hue, IplImage* mask, CvHistogram* hist,
+							   CvMat* backproject, CvRect region, CvRect* window,
+							   CvConnectedComp* comp, CvBox2D* box)
+{
+	CvMat hueStub, maskStub;
+	CvMat* hueRegion = cvGetSubRect(hue, &hueStub, region);
+	CvMat* maskRegion = cvGetSubRect(mask, &maskStub, region);
+
+	// the track window relative to the region (and within it)
+
+	int x0 = std::max(window->x, region.x);
+	int y0 = std::max(window->y, region.y);
+	int x1 = std::min(window->x + window->width, region.x + region.width);
+	int y1 = std::min(window->y + window->height, region.y + region.height);
+	CvRect local = ((x1 > x0) && (y1 > y0)) ?
+					cvRect(x0 - region.x, y0 - region.y, x1 - x0, y1 - y0) :
+					cvRect(0, 0, region.width, region.height);
+
+	// calculate the back-projection of the histogram on the region and
+	// pass this to the camShift Routine
+
+	cvCalcArrBackProject((CvArr**) &hueRegion, backproject, hist);
+	cvAnd(backproject, maskRegion, backproject, 0);
+
+	cvCamShift(backproject, local,
+				cvTermCriteria(CV_TERMCRIT_EPS | CV_TERMCRIT_ITER, 10, 1),
+				comp, box);
+
+	// back to frame co-ordinates
+
+	comp->rect.x += region.x;
+	comp->rect.y += region.y;
+	box->center.x += region.x;
+	box->center.y += region.y;
+
+	if ((comp->area < IPCV_CAMSHIFT_MIN_MASS) || (comp->rect.width <= 0) ||
+		(comp->rect.height <= 0)) {
+		return false;
+	}
+
+	*window = comp->rect;
+	return true;
+}
+
+/******************************************************************************/
+
+bool track_camshift_region(IplImage* hue, IplImage* mask, CvHistogram* hist,
+						   IplImage* backproject, CvRect region, CvRect* window,
+						   CvConnectedComp* comp, CvBox2D* box)
+{
+	CvMat stub;
+
+	return camshift_in_region(hue, mask, hist,
+							  cvGetSubRect(backproject, &stub, region), region,
+							  window, comp, box);
+}
+
+/******************************************************************************/
+
+CvHistogram* create_hue_histogram(int hdims)
+{
+	float hranges_arr[] = {0,180};
+	float* hranges = hranges_arr;
+
+	return cvCreateHist(1, &hdims, CV_HIST_ARRAY, &hranges, 1);
+}
+
+void calc_hue_histogram(IplImage* hue, IplImage* mask, CvRect rect, CvHistogram* hist)
+{
+	CvMat hueStub, maskStub;
+	CvMat* hueRect = cvGetSubRect(hue, &hueStub, rect);
+	float max_val = 0.f;
+
+	cvCalcArrHist((CvArr**) &hueRect, hist, 0, cvGetSubRect(mask, &maskStub, rect));
+	cvGetMinMaxHistValue(hist, 0, &max_val, 0, 0);
+	cvConvertScale(hist->bins, hist->bins, max_val ? 255. / max_val : 0., 0);
+}
+
+/******************************************************************************/
+
+CamshiftTracker* create_camshift_tracker(int hdims, int margin, int threads)
+{
+	CamshiftTracker* tracker = new CamshiftTracker;
+
+	tracker->hdims = hdims;
+	tracker->margin = std::max(margin, 0);
+	tracker->threads = (threads > 0) ? threads :
+					   std::max(1, (int) std::thread::hardware_concurrency());
+
+	return tracker;
+}
+
+/******************************************************************************/
+
+int add_camshift_target(CamshiftTracker* tracker, IplImage* hue, IplImage* mask,
+						CvRect selection)
+{
+	CamshiftTarget t;
+
+	t.hist = create_hue_histogram(tracker->hdims);
+	calc_hue_histogram(hue, mask, selection, t.hist);
+	t.window = selection;
+	t.tracked = true;
+	t.backproject = NULL;
+
+	tracker->targets.push_back(t);
+	return (int) tracker->targets.size() - 1;
+}
+
+/******************************************************************************/
+
+void clear_camshift_targets(CamshiftTracker* tracker)
+{
+	for (size_t i = 0; i < tracker->targets.size(); i++)
+	{
+		cvReleaseHist(&(tracker->targets[i].hist));
+		if (tracker->targets[i].backproject) {
+			cvReleaseMat(&(tracker->targets[i].backproject));
+		}
+	}
+	tracker->targets.clear();
+}
+
+/******************************************************************************/
+
+// track one target (in its own search region and back projection buffer)
+
+static void track_camshift_target(CamshiftTracker* tracker, CamshiftTarget& t,
+								  IplImage* hue, IplImage* mask)
+{
+	CvSize size = cvGetSize(hue);
+	CvRect region = ((tracker->margin > 0) && (t.tracked)) ?
+					camshift_search_region(t.window, tracker->margin, size) :
+					cvRect(0, 0, size.width, size.height);
+
+	// back projection buffer of the region size (only ever grown)
+
+	if ((t.backproject) &&
+		((t.backproject->rows * t.backproject->cols) < (region.width * region.height)))
+	{
+		cvReleaseMat(&(t.backproject));
+	}
+	if (!t.backproject) {
+		t.backproject = cvCreateMat(region.height, region.width, CV_8UC1);
+	}
+	CvMat backproject;
+	cvInitMatHeader(&backproject, region.height, region.width, CV_8UC1,
+					t.backproject->data.ptr);
+
+	t.tracked = camshift_in_region(hue, mask, t.hist, &backproject, region,
+								   &(t.window), &(t.comp), &(t.box));
+
+	// if the target is lost search for it from the whole frame
+
+	if (!t.tracked) {
+		t.window = cvRect(0, 0, size.width, size.height);
+	}
+}
+
+/******************************************************************************/
+
+// the work of one frame of a tracker, shared by the threads
+
+struct TrackerWork
+{
+	CamshiftTracker* tracker;
+	IplImage* hue;
+	IplImage* mask;
+	std::atomic<int> next;			// next target to be started
+};
+
+// track targets until all have been started
+
+static void tracker_worker(TrackerWork* work)
+{
+	int n = (int) work->tracker->targets.size();
+
+	for (int i = work->next++; i < n; i = work->next++)
+	{
+		track_camshift_target(work->tracker, work->tracker->targets[i],
+							  work->hue, work->mask);
+	}
+}
+
+/******************************************************************************/
+
+int track_camshift_targets(CamshiftTracker* tracker, IplImage* hue, IplImage* mask)
+{
+	int n = (int) tracker->targets.size();
+
+	// track the targets in parallel (each thread taking the next target not
+	// yet started, with the calling thread as one of them)
+
+	TrackerWork work;
+	work.tracker = tracker;
+	work.hue = hue;
+	work.mask = mask;
+	work.next = 0;
+	std::vector<std::thread> threads;
+
+	for (int i = 1; i < std::min(tracker->threads, n); i++)
+	{
+		threads.push_back(std::thread(tracker_worker, &work));
+	}
+	tracker_worker(&work);
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+
+	int tracked = 0;
+	for (int i = 0; i < n; i++)
+	{
+		tracked += (tracker->targets[i].tracked) ? 1 : 0;
+	}
+	return tracked;
+}
+
+/******************************************************************************/
+
+void release_camshift_tracker(CamshiftTracker** tracker)
+{
+	if ((tracker) && (*tracker))
+	{
+		clear_camshift_targets(*tracker);
+		delete *tracker;
+		*tracker = NULL;
+	}
+}
+
+/******************************************************************************/
@@ -0,0 +1,130 @@
+// Module : shared hue histogram / CAMSHIFT tracking functions for
+//          camshift_tracking.cc and multi_camshift_tracking.cc
+// usage: #include "ipcv_camshift.h" (link with the ipcv library)
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: CAMSHIFT only looks at the back projection in (and near) the track
+// window, so with a tracking margin the colour conversion, masking and back
+// projection are restricted to the track window expanded by that margin -
+// with the whole frame processed again whenever the target is lost.
+
+// A CAMSHIFT tracker (CamshiftTracker) tracks many targets, each with its own
+// hue histogram and track window - the hue channel and mask are computed once
+// per frame for all of the targets and the back projection / CAMSHIFT of each
+// target (in its own search region) are run in parallel
+
+#ifndef IPCV_CAMSHIFT_H
+#define IPCV_CAMSHIFT_H
+
+#include "cv.h"       // open cv general include file
+
+#include <vector>
+
+/******************************************************************************/
+
+// the target is lost if the back projection in the track window sums to less
+// than this (i.e. the equivalent of a few pixels of full probability)
+
+#define IPCV_CAMSHIFT_MIN_MASS (4 * 255)
+
+/******************************************************************************/
+
+// return the region of a frame of the given size to process for a track
+// window expanded by margin pixels (on each side), clipped to the frame
+
+CvRect camshift_search_region(CvRect window, int margin, CvSize size);
+
+// convert a region of a BGR image to the hue channel and the mask of pixels
+// with saturation in {smin ... 256} and value in {vmin ... vmax}, bounds
+// inclusive (only that region of hue and mask is written) - in a single pass,
+// giving the same result as cvCvtColor(CV_BGR2HSV), cvInRangeS() (of OpenCV
+// 2.4) and cvSplit() with no HSV image
+
+// img - input image (8-bit BGR, 3 or 4 channel)
+// hue - output hue channel (8-bit, 1 channel, as img)
+// mask - output mask (8-bit, 1 channel, as img)
+// region - region to convert
+
+void hue_and_mask(IplImage* img, IplImage* hue, IplImage* mask, CvRect region,
+				  int smin, int vmin, int vmax);
+
+// back project the hue histogram (masked) over a region and run CAMSHIFT
+// from the track window within that region
+
+// hue, mask - hue channel and mask (valid within region)
+// hist - hue histogram of the target
+// backproject - output back projection (8-bit, 1 channel, as hue)
+// region - region to process (containing the track window)
+// window - track window, updated to the new track window
+// comp, box - returned CAMSHIFT component / box (in frame co-ordinates)
+// return value - true if the target has been tracked, false if it is lost
+
+bool track_camshift_region(IplImage* hue, IplImage* mask, CvHistogram* hist,
+						   IplImage* backproject, CvRect region, CvRect* window,
+						   CvConnectedComp* comp, CvBox2D* box);
+
+// calculate the hue histogram of a region (within the mask), scaled so that
+// the largest bin is 255
+
+void calc_hue_histogram(IplImage* hue, IplImage* mask, CvRect rect, CvHistogram* hist);
+
+// create a hue histogram (of hdims bins over the hue range 0 ... 180)
+
+CvHistogram* create_hue_histogram(int hdims = 16);
+
+/******************************************************************************/
+
+// a target of a CAMSHIFT tracker
+
+typedef struct CamshiftTarget
+{
+	CvHistogram* hist;		// hue histogram of the target
+	CvRect window;			// track window
+	CvBox2D box;			// track box (of the last frame)
+	CvConnectedComp comp;	// track component (of the last frame)
+	bool tracked;			// tracked in the last frame (false = lost)
+	CvMat* backproject;		// back projection buffer (of the search region)
+} CamshiftTarget;
+
+typedef struct CamshiftTracker
+{
+	int hdims;				// hue histogram bins
+	int margin;				// search margin around each track window (0 = the
+							// whole frame is searched for every target)
+	int threads;			// number of targets tracked at once
+	std::vector<CamshiftTarget> targets;
+} CamshiftTracker;
+
+// create a tracker (with no targets)
+
+// hdims - hue histogram bins for each target
+// margin - search margin (pixels) around each track window (0 = whole frame)
+// threads - number of targets tracked at once (0 = one per core)
+// return value - pointer to tracker
+
+CamshiftTracker* create_camshift_tracker(int hdims = 16, int margin = 0, int threads = 0);
+
+// add a target from a selected region of the hue channel / mask
+// return value - index of the target
+
+int add_camshift_target(CamshiftTracker* tracker, IplImage* hue, IplImage* mask,
+						CvRect selection);
+
+// remove all of the targets
+
+void clear_camshift_targets(CamshiftTracker* tracker);
+
+// track all of the targets in a frame (given as its hue channel and mask,
+// see hue_and_mask()) - a lost target is searched for from the whole frame
+// return value - number of targets tracked
+
+int track_camshift_targets(CamshiftTracker* tracker, IplImage* hue, IplImage* mask);
+
+// release the tracker (and all of the targets)
+
+void release_camshift_tracker(CamshiftTracker** tracker);
+
+/******************************************************************************/
+
+#endif
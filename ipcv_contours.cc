@@ -0,0 +1,47 @@
+// Module : shared contour functions for the contour / moment based examples
+// usage: see ipcv_contours.h
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+#include "ipcv_contours.h"
+
+#include <math.h>
+
+/******************************************************************************/
+
+// find the largest contour (by area) from a sequence of contours and return a
+// pointer to that item in the sequence
+
+CvSeq* findLargestContour(CvSeq* contours){
+
+  CvSeq* current_contour = contours;
+  double largestArea = 0;
+  CvSeq* largest_contour = NULL;
+
+  // check we at least have some contours
+
+  if (contours == NULL){return NULL;}
+
+  // for each contour compare it to current largest area on
+  // record and remember the contour with the largest area
+  // (note the use of fabs() for the cvContourArea() function)
+
+  while (current_contour != NULL){
+
+	  double area = fabs(cvContourArea(current_contour));
+
+	  if(area > largestArea){
+		  largestArea = area;
+		  largest_contour = current_contour;
+	  }
+
+	  current_contour = current_contour->h_next;
+  }
+
+  // return pointer to largest
+
+  return largest_contour;
+
+}
+
+/******************************************************************************/
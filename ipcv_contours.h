@@ -0,0 +1,20 @@
+// Module : shared contour functions for the contour / moment based examples
+// usage: #include "ipcv_contours.h" (link with the ipcv library)
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+#ifndef IPCV_CONTOURS_H
+#define IPCV_CONTOURS_H
+
+#include "cv.h"       // open cv general include file
+
+/******************************************************************************/
+
+// find the largest contour (by area) from a sequence of contours and return a
+// pointer to that item in the sequence
+
+CvSeq* findLargestContour(CvSeq* contours);
+
+/******************************************************************************/
+
+#endif
@@ -0,0 +1,575 @@
+// Module : shared Fourier (DFT) processing functions for the dft_*.cc examples
+// usage: see ipcv_dft.h
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// portions based on OpenCV library example dft.c
+
+#include "ipcv_dft.h"
+
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+/******************************************************************************/
+// Rearrange the quadrants of Fourier image so that the origin is at
+// the image center
+// src & dst arrays of equal size & type
+void cvShiftDFT(CvArr * src_arr, CvArr * dst_arr )
+{
+    CvMat * tmp = NULL;
+    CvMat q1stub, q2stub;
+    CvMat q3stub, q4stub;
+    CvMat d1stub, d2stub;
+    CvMat d3stub, d4stub;
+    CvMat * q1, * q2, * q3, * q4;
+    CvMat * d1, * d2, * d3, * d4;
+
+    CvSize size = cvGetSize(src_arr);
+    CvSize dst_size = cvGetSize(dst_arr);
+    int cx, cy;
+
+    if(dst_size.width != size.width ||
+       dst_size.height != size.height){
+        cvError( CV_StsUnmatchedSizes,
+		   "cvShiftDFT", "Source and Destination arrays must have equal sizes",
+		   __FILE__, __LINE__ );
+    }
+
+    if(src_arr==dst_arr){
+        tmp = cvCreateMat(size.height/2, size.width/2, cvGetElemType(src_arr));
+    }
+
+    cx = size.width/2;
+    cy = size.height/2; // image center
+
+    q1 = cvGetSubRect( src_arr, &q1stub, cvRect(0,0,cx, cy) );
+    q2 = cvGetSubRect( src_arr, &q2stub, cvRect(cx,0,cx,cy) );
+    q3 = cvGetSubRect( src_arr, &q3stub, cvRect(cx,cy,cx,cy) );
+    q4 = cvGetSubRect( src_arr, &q4stub, cvRect(0,cy,cx,cy) );
+    d1 = cvGetSubRect( dst_arr, &d1stub, cvRect(0,0,cx,cy) );
+    d2 = cvGetSubRect( dst_arr, &d2stub, cvRect(cx,0,cx,cy) );
+    d3 = cvGetSubRect( dst_arr, &d3stub, cvRect(cx,cy,cx,cy) );
+    d4 = cvGetSubRect( dst_arr, &d4stub, cvRect(0,cy,cx,cy) );
+
+    if(src_arr!=dst_arr){
+        if( !CV_ARE_TYPES_EQ( q1, d1 )){
+            cvError( CV_StsUnmatchedFormats,
+			"cvShiftDFT", "Source and Destination arrays must have the same format",
+			__FILE__, __LINE__ );
+        }
+        cvCopy(q3, d1, 0);
+        cvCopy(q4, d2, 0);
+        cvCopy(q1, d3, 0);
+        cvCopy(q2, d4, 0);
+    }
+    else{
+        cvCopy(q3, tmp, 0);
+        cvCopy(q1, q3, 0);
+        cvCopy(tmp, q1, 0);
+        cvCopy(q4, tmp, 0);
+        cvCopy(q2, q4, 0);
+        cvCopy(tmp, q2, 0);
+
+		cvReleaseMat(&tmp);
+    }
+}
+/******************************************************************************/
+
+// swap the n byte elements at a and b
+
+static inline void swap_elements(uchar* a, uchar* b, int n)
+{
+	for (int k = 0; k < n; k++) {
+		std::swap(a[k], b[k]);
+	}
+}
+
+// reverse the order of count elements of n bytes, step bytes apart, from p
+
+static void reverse_elements(uchar* p, int count, int step, int n)
+{
+	for (int i = 0, j = count - 1; i < j; i++, j--) {
+		swap_elements(p + i * step, p + j * step, n);
+	}
+}
+
+// rotate count elements of n bytes, step bytes apart, from p right by k
+// (in place - by reversing the whole and then both parts)
+
+static void rotate_elements(uchar* p, int count, int step, int n, int k)
+{
+	if ((k % count) == 0) {
+		return;
+	}
+	reverse_elements(p, count, step, n);
+	reverse_elements(p, k, step, n);
+	reverse_elements(p + k * step, count - k, step, n);
+}
+
+void shift_dft_inplace(CvArr* arr, int inverse)
+{
+	CvMat stub;
+	CvMat* mat = cvGetMat(arr, &stub);
+
+	int rows = mat->rows;
+	int cols = mat->cols;
+	int esize = CV_ELEM_SIZE(mat->type);
+
+	// rotate each row right by cols/2 (or left for the inverse) ...
+
+	int k = (inverse) ? cols - (cols / 2) : cols / 2;
+	for (int i = 0; i < rows; i++) {
+		rotate_elements(mat->data.ptr + i * mat->step, cols, esize, esize, k);
+	}
+
+	// ... and then the rows down by rows/2 (swapping whole rows)
+
+	k = (inverse) ? rows - (rows / 2) : rows / 2;
+	if ((k % rows) != 0)
+	{
+		reverse_elements(mat->data.ptr, rows, mat->step, cols * esize);
+		reverse_elements(mat->data.ptr, k, mat->step, cols * esize);
+		reverse_elements(mat->data.ptr + k * mat->step, rows - k, mat->step, cols * esize);
+	}
+}
+/******************************************************************************/
+
+// return a floating point spectrum magnitude image scaled for user viewing
+
+// dft_A - input dft (2 channel floating point, Real + Imaginary fourier image)
+// rearrange - perform rearrangement of DFT quadrants if > 0
+// return value - pointer to output spectrum magnitude image scaled for user viewing
+
+IplImage* create_spectrum_magnitude_display(CvMat* dft_A, int rearrange)
+{
+	IplImage* image_Mag = NULL;
+
+	return update_spectrum_magnitude_display(dft_A, rearrange, &image_Mag);
+}
+/******************************************************************************/
+
+void dft_real_forward(const CvArr* src, CvArr* dft_R, int flags)
+{
+	CvSize size = cvGetSize(src);
+	CvSize dft_size = cvGetSize(dft_R);
+	CvMat tmp;
+
+	// copy (and convert) the input to the top left of dft_R and pad the right
+	// hand side with zeros
+
+	cvGetSubRect( dft_R, &tmp, cvRect(0, 0, size.width, size.height));
+	cvConvert( src, &tmp );
+	if ((dft_size.width - size.width) > 0)
+	{
+		cvGetSubRect( dft_R, &tmp,
+				cvRect(size.width, 0, dft_size.width - size.width, size.height));
+		cvZero( &tmp );
+	}
+
+	// no need to pad bottom part of dft_R with zeros because of
+	// use nonzero_rows parameter in cvDFT() call below
+
+	cvDFT( dft_R, dft_R, flags, size.height );
+}
+/******************************************************************************/
+
+// return the value of the first channel of a 32/64-bit filter at (row, col)
+
+static inline double filter_value(const CvMat* filter, int row, int col)
+{
+	int cn = CV_MAT_CN(filter->type);
+
+	if (CV_MAT_DEPTH(filter->type) == CV_64F) {
+		return ((const double*) (filter->data.ptr + row * filter->step))[col * cn];
+	}
+	return ((const float*) (filter->data.ptr + row * filter->step))[col * cn];
+}
+
+void create_packed_filter(const CvArr* filter, CvArr* packed)
+{
+	CvMat fstub, pstub;
+	CvMat* f = cvGetMat(filter, &fstub);
+	CvMat* p = cvGetMat(packed, &pstub);
+
+	int M = f->rows;
+	int N = f->cols;
+
+	if ((p->rows != M) || (p->cols != N)){
+		cvError( CV_StsUnmatchedSizes, "create_packed_filter",
+				"Filter and packed filter arrays must have equal sizes",
+				__FILE__, __LINE__ );
+	}
+	if ((CV_MAT_TYPE(p->type) != CV_32FC1) ||
+		((CV_MAT_DEPTH(f->type) != CV_32F) && (CV_MAT_DEPTH(f->type) != CV_64F))){
+		cvError( CV_StsUnsupportedFormat, "create_packed_filter",
+				"Filter must be 32/64-bit and packed filter 1 channel 32-bit",
+				__FILE__, __LINE__ );
+	}
+
+	// each element of the CCS packed DFT is the real or imaginary part of the
+	// DFT at frequency (v, u) - as the filter is real and symmetric both are
+	// simply multiplied by the filter value at that frequency (v, u)
+
+	for(int i = 0; i < M; i++)
+	{
+		float* row = (float*) (p->data.ptr + i * p->step);
+
+		for(int j = 0; j < N; j++)
+		{
+			int u, v;
+
+			if ((j == 0) || ((j == N - 1) && ((N % 2) == 0)))
+			{
+				// first (and last, for even N) column hold the packed 1D DFT
+				// of the columns u = 0 (and u = N/2) of the full DFT
+
+				u = (j == 0) ? 0 : N / 2;
+				v = (i + 1) / 2;
+			} else {
+				u = (j + 1) / 2;
+				v = i;
+			}
+
+			row[j] = (float) filter_value(f, v, u);
+		}
+	}
+}
+/******************************************************************************/
+
+// get the real and imaginary parts of the DFT at frequency (v, u) from a CCS
+// packed DFT (using the conjugate symmetry of the DFT of a real input)
+
+static inline void ccs_element(const CvMat* d, int v, int u, float* re, float* im)
+{
+	int M = d->rows;
+	int N = d->cols;
+
+	#define CCS(r, c) (((const float*) (d->data.ptr + (r) * d->step))[(c)])
+
+	if ((u == 0) || ((u * 2) == N))
+	{
+		int c = (u == 0) ? 0 : N - 1;
+		int k = (v <= (M / 2)) ? v : M - v;
+
+		if (k == 0) {
+			*re = CCS(0, c); *im = 0;
+		} else if ((k * 2) == M) {
+			*re = CCS(M - 1, c); *im = 0;
+		} else {
+			*re = CCS(2 * k - 1, c); *im = CCS(2 * k, c);
+		}
+	} else if (u <= ((N - 1) / 2)) {
+		*re = CCS(v, 2 * u - 1); *im = CCS(v, 2 * u);
+	} else {
+		int v2 = (M - v) % M;
+		*re = CCS(v2, 2 * (N - u) - 1); *im = - CCS(v2, 2 * (N - u));
+	}
+
+	#undef CCS
+}
+
+/******************************************************************************/
+
+// log(1 + Mag) of a DFT element, tracking the min / max
+
+static inline float log_magnitude(float re, float im, float* m, float* M)
+{
+	float mag = logf(1.0f + sqrtf((re * re) + (im * im)));
+
+	*m = std::min(*m, mag);
+	*M = std::max(*M, mag);
+
+	return mag;
+}
+
+// log(1 + Mag) of one row of a 2 channel (interleaved Real + Imaginary)
+// complex DFT, with element u written to out[u + shift] (wrapping around)
+
+template<typename T>
+static void log_magnitude_row(const T* src, int n, int shift, float* out,
+								float* m, float* M)
+{
+	int split = n - shift;
+
+	for(int u = 0; u < split; u++) {
+		out[u + shift] = log_magnitude((float) src[2 * u], (float) src[2 * u + 1], m, M);
+	}
+	for(int u = split; u < n; u++) {
+		out[u - split] = log_magnitude((float) src[2 * u], (float) src[2 * u + 1], m, M);
+	}
+}
+
+// log(1 + Mag) of row v of a CCS packed DFT (as above)
+
+static void log_magnitude_packed_row(const CvMat* d, int v, int shift, float* out,
+										float* m, float* M)
+{
+	int n = d->cols;
+	int split = n - shift;
+	const float* src = (const float*) (d->data.ptr + v * d->step);
+	const float* conj = (const float*) (d->data.ptr + ((d->rows - v) % d->rows) * d->step);
+	float re, im;
+
+	#define OUT(u) out[((u) < split) ? ((u) + shift) : ((u) - split)]
+
+	// the columns u = 0 (and u = N/2, for even N) are packed by column ...
+
+	ccs_element(d, v, 0, &re, &im);
+	OUT(0) = log_magnitude(re, im, m, M);
+	if ((n % 2) == 0) {
+		ccs_element(d, v, n / 2, &re, &im);
+		OUT(n / 2) = log_magnitude(re, im, m, M);
+	}
+
+	// ... the others are interleaved in this row for u <= (N-1)/2 and are the
+	// complex conjugates of those in row M-v for u > N/2
+
+	for(int u = 1; u <= ((n - 1) / 2); u++)
+	{
+		OUT(u) = log_magnitude(src[2 * u - 1], src[2 * u], m, M);
+		OUT(n - u) = log_magnitude(conj[2 * u - 1], conj[2 * u], m, M);
+	}
+
+	#undef OUT
+}
+
+IplImage* update_spectrum_magnitude_display(const CvArr* dft, int rearrange,
+											IplImage** display)
+{
+	CvMat dstub;
+	CvMat* d = cvGetMat(dft, &dstub);
+
+	int dft_M = d->rows;
+	int dft_N = d->cols;
+	int type = CV_MAT_TYPE(d->type);
+	float m = FLT_MAX, M = -FLT_MAX;
+
+	if ((type != CV_32FC2) && (type != CV_64FC2) && (type != CV_32FC1)){
+		cvError( CV_StsUnsupportedFormat, "update_spectrum_magnitude_display",
+				"DFT must be 2 channel 32/64-bit or 1 channel 32-bit (CCS packed)",
+				__FILE__, __LINE__ );
+	}
+
+	// (re-)allocate the output only if needed
+
+	if ((*display) && (((*display)->width != dft_N) || ((*display)->height != dft_M)))
+	{
+		cvReleaseImage(display);
+	}
+	if (!(*display)) {
+		*display = cvCreateImage( cvSize(dft_N, dft_M), IPL_DEPTH_32F, 1);
+	}
+	IplImage* image_Mag = *display;
+
+	// compute log(1 + Mag) straight from the DFT, writing each element to its
+	// rearranged position if required and tracking the min / max as we go
+
+	int rowShift = (rearrange) ? (dft_M / 2) : 0;
+	int colShift = (rearrange) ? (dft_N / 2) : 0;
+
+	for(int v = 0; v < dft_M; v++)
+	{
+		int row = (v + rowShift) % dft_M;
+		float* out = (float*) (image_Mag->imageData + row * image_Mag->widthStep);
+		const uchar* src = d->data.ptr + v * d->step;
+
+		switch (type)
+		{
+			case CV_32FC2:
+				log_magnitude_row((const float*) src, dft_N, colShift, out, &m, &M);
+				break;
+			case CV_64FC2:
+				log_magnitude_row((const double*) src, dft_N, colShift, out, &m, &M);
+				break;
+			default:
+				log_magnitude_packed_row(d, v, colShift, out, &m, &M);
+				break;
+		}
+	}
+
+	// scale image for display (in a second pass, in place)
+
+	cvConvertScale(image_Mag, image_Mag, 1.0/(M-m), 1.0*(-m)/(M-m));
+
+	return image_Mag;
+}
+/******************************************************************************/
+
+// return the distance of element (i, j) of a DFT sized array from the zero
+// frequency in the (unshifted) layout of the DFT - i.e. the distance from the
+// nearest corner, or the distance from the center after rearrangement
+
+static inline double dft_distance(const CvMat* dft, int i, int j)
+{
+	double di = std::min(i, dft->rows - i);
+	double dj = std::min(j, dft->cols - j);
+
+	return sqrt((di * di) + (dj * dj));
+}
+/******************************************************************************/
+
+// create a 2-channel butterworth low-pass filter with radius D, order n
+
+void create_butterworth_lowpass_filter(CvMat* dft_Filter, int D, int n)
+{
+	CvMat* single = cvCreateMat(dft_Filter->rows, dft_Filter->cols, CV_64FC1 );
+
+	double radius;
+
+	// based on the forumla in the IP notes (p. 130 of 2009/10 version)
+	// see also HIPR2 on-line
+
+	for(int i = 0; i < dft_Filter->rows; i++)
+	{
+		for(int j = 0; j < dft_Filter->cols; j++)
+		{
+			radius = dft_distance(dft_Filter, i, j);
+			CV_MAT_ELEM(*single, double, i, j) =
+						( 1 / (1 + pow((double) (radius /  D), (double) (2 * n))));
+		}
+	}
+
+	cvMerge(single, single, NULL, NULL, dft_Filter);
+
+	cvReleaseMat(&single);
+}
+/******************************************************************************/
+
+// create a 2-channel butterworth high-pass filter with radius D, order n
+
+void create_butterworth_highpass_filter(CvMat* dft_Filter, int D, int n)
+{
+	CvMat* single = cvCreateMat(dft_Filter->rows, dft_Filter->cols, CV_64FC1 );
+
+	double radius;
+
+	// based on the forumla in the IP notes (p. 124 of 2009/10 version)
+	// see also HIPR2 on-line
+
+	for(int i = 0; i < dft_Filter->rows; i++)
+	{
+		for(int j = 0; j < dft_Filter->cols; j++)
+		{
+			radius = dft_distance(dft_Filter, i, j);
+			CV_MAT_ELEM(*single, double, i, j) =
+						( 1 / (1 + pow((double) (D /  radius), (double) (2 * n))));
+		}
+	}
+
+	cvMerge(single, single, NULL, NULL, dft_Filter);
+
+	cvReleaseMat(&single);
+}
+/******************************************************************************/
+
+// create a 2-channel butterworth-based homomorphic filter with radius D, order
+// n and homomorphic upper and lower as specified
+
+void create_butterworth_homomorphic_filter(CvMat* dft_Filter,
+int D, int n, float upper, float lower)
+{
+	CvMat* single = cvCreateMat(dft_Filter->rows, dft_Filter->cols, CV_64FC1 );
+
+	double radius;
+
+	// create essentially create a butterworth highpass filter
+	// with additional scaling and offset
+
+	// details based on Gonzalez/Woods 3rd Edition, p293 w/ guidance from
+	// MATLAB implementation on MATLAB File Exchange
+
+	for(int i = 0; i < dft_Filter->rows; i++)
+	{
+		for(int j = 0; j < dft_Filter->cols; j++)
+		{
+			radius = dft_distance(dft_Filter, i, j);
+			CV_MAT_ELEM(*single, double, i, j) =
+			((upper - lower) * ( 1 / (1 + pow((double) (D /  radius), (double) (2 * n))))) + lower;
+		}
+	}
+
+	// N.B. perhaps need to check that all elements of single are within a reasonable range
+	// - NOT DONE
+
+	cvMerge(single, single, NULL, NULL, dft_Filter);
+
+	cvReleaseMat(&single);
+}
+/******************************************************************************/
+
+ButterworthFilterCache* create_butterworth_filter_cache(int type)
+{
+	ButterworthFilterCache* cache = new ButterworthFilterCache;
+
+	cache->type = type;
+	cache->D = cache->n = 0;
+	cache->upper = cache->lower = 0;
+	cache->filter = NULL;
+
+	return cache;
+}
+
+/******************************************************************************/
+
+int update_butterworth_filter(ButterworthFilterCache* cache, CvSize size,
+								int D, int n, float upper, float lower)
+{
+	// nothing to do if the filter already matches
+
+	if ((cache->filter) &&
+		(cache->filter->rows == size.height) && (cache->filter->cols == size.width) &&
+		(cache->D == D) && (cache->n == n) &&
+		((cache->type != IPCV_BUTTERWORTH_HOMOMORPHIC) ||
+		 ((cache->upper == upper) && (cache->lower == lower))))
+	{
+		return 0;
+	}
+
+	// (re-)allocate for a new size and rebuild
+
+	if ((cache->filter) &&
+		((cache->filter->rows != size.height) || (cache->filter->cols != size.width)))
+	{
+		cvReleaseMat(&(cache->filter));
+	}
+	if (!(cache->filter)) {
+		cache->filter = cvCreateMat(size.height, size.width, CV_64FC2);
+	}
+
+	switch (cache->type)
+	{
+		case IPCV_BUTTERWORTH_HIGHPASS:
+			create_butterworth_highpass_filter(cache->filter, D, n);
+			break;
+		case IPCV_BUTTERWORTH_HOMOMORPHIC:
+			create_butterworth_homomorphic_filter(cache->filter, D, n, upper, lower);
+			break;
+		default:
+			create_butterworth_lowpass_filter(cache->filter, D, n);
+			break;
+	}
+
+	cache->D = D;
+	cache->n = n;
+	cache->upper = upper;
+	cache->lower = lower;
+
+	return 1;
+}
+
+/******************************************************************************/
+
+void release_butterworth_filter_cache(ButterworthFilterCache** cache)
+{
+	if ((cache) && (*cache))
+	{
+		if ((*cache)->filter) {
+			cvReleaseMat(&((*cache)->filter));
+		}
+		delete *cache;
+		*cache = NULL;
+	}
+}
+
+/******************************************************************************/
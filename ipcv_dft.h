@@ -0,0 +1,126 @@
+// Module : shared Fourier (DFT) processing functions for the dft_*.cc examples
+// usage: #include "ipcv_dft.h" (link with the ipcv library)
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+#ifndef IPCV_DFT_H
+#define IPCV_DFT_H
+
+#include "cv.h"       // open cv general include file
+
+/******************************************************************************/
+
+// Rearrange the quadrants of Fourier image so that the origin is at
+// the image center
+// src & dst arrays of equal size & type
+
+void cvShiftDFT(CvArr * src_arr, CvArr * dst_arr );
+
+// rearrange the quadrants of a Fourier image in place (with no temporary
+// array) for display - the origin is moved to the image center, or back to
+// the top left if inverse > 0 (N.B. also correct for odd sizes)
+
+void shift_dft_inplace(CvArr* arr, int inverse = 0);
+
+// compute the log(1 + Mag) spectrum magnitude of a DFT scaled for user viewing
+// - in a single pass over the DFT (tracking the min / max as it goes) and a
+// second pass to scale the output image, which is re-used between calls
+
+// dft - input dft (2 channel 32/64-bit, Real + Imaginary fourier image, or 1
+//       channel 32-bit, CCS packed - see the real input DFT path below)
+// rearrange - perform rearrangement of DFT quadrants if > 0
+// display - output image (32-bit), allocated if NULL or of the wrong size
+// return value - *display
+
+IplImage* update_spectrum_magnitude_display(const CvArr* dft, int rearrange,
+											IplImage** display);
+
+// as above, but returning a newly allocated image
+
+// dft_A - input dft (2 channel floating point, Real + Imaginary fourier image)
+// rearrange - perform rearrangement of DFT quadrants if > 0
+// return value - pointer to output spectrum magnitude image scaled for user viewing
+
+IplImage* create_spectrum_magnitude_display(CvMat* dft_A, int rearrange);
+
+/******************************************************************************/
+
+// real input, single precision DFT path - a real image is transformed with a
+// real to complex DFT giving the CCS packed output of cvDFT() (one 32-bit
+// channel of the DFT size, rather than the two 64-bit channels above) and
+// filters are applied to this in packed form using cvMul()
+
+// copy a 1-channel image to the top left of the (DFT sized) 32-bit real
+// array dft_R, zero the padding to the right and take its forward DFT
+
+// flags - cvDFT() flags (e.g. CV_DXT_FORWARD | CV_DXT_SCALE)
+
+void dft_real_forward(const CvArr* src, CvArr* dft_R, int flags = CV_DXT_FORWARD);
+
+// convert a filter in the unshifted layout used by the examples and the
+// create_butterworth_*_filter functions (1 or 2 channel, 32 or 64-bit, the
+// first channel is used) to a CCS packed 32-bit multiplier of the same size
+// N.B. the filter must be real and symmetric (as all the examples are)
+
+void create_packed_filter(const CvArr* filter, CvArr* packed);
+
+/******************************************************************************/
+
+// N.B. all of the filters below (and those the examples build) are in the
+// unshifted layout of the DFT itself, with the zero frequency at the top left,
+// so they can be applied without any rearrangement of the DFT quadrants
+// (use shift_dft_inplace() to display them)
+
+// create a 2-channel butterworth low-pass filter with radius D, order n
+
+void create_butterworth_lowpass_filter(CvMat* dft_Filter, int D, int n);
+
+// create a 2-channel butterworth high-pass filter with radius D, order n
+
+void create_butterworth_highpass_filter(CvMat* dft_Filter, int D, int n);
+
+// create a 2-channel butterworth-based homomorphic filter with radius D, order
+// n and homomorphic upper and lower as specified
+
+void create_butterworth_homomorphic_filter(CvMat* dft_Filter,
+int D, int n, float upper, float lower);
+
+/******************************************************************************/
+
+// cache of a butterworth filter that is only rebuilt when its parameters
+// (or the DFT size) change - e.g. from a trackbar - rather than every frame
+
+#define IPCV_BUTTERWORTH_LOWPASS 0
+#define IPCV_BUTTERWORTH_HIGHPASS 1
+#define IPCV_BUTTERWORTH_HOMOMORPHIC 2
+
+typedef struct ButterworthFilterCache
+{
+	int type;			// IPCV_BUTTERWORTH_{LOWPASS | HIGHPASS | HOMOMORPHIC}
+	int D, n;			// radius and order the filter was built with
+	float upper, lower;	// homomorphic upper / lower (unused otherwise)
+	CvMat* filter;		// 2-channel filter (NULL until first update)
+} ButterworthFilterCache;
+
+// create an (empty) filter cache for the given type of butterworth filter
+
+ButterworthFilterCache* create_butterworth_filter_cache(int type);
+
+// make sure the cached filter matches the parameters given, rebuilding it
+// (using the create_butterworth_*_filter functions above) only if they differ
+
+// cache - filter cache
+// size - DFT size (i.e. size of the filter)
+// D, n, upper, lower - filter parameters (upper, lower for homomorphic only)
+// return value - 1 if the filter was rebuilt (i.e. has changed), 0 otherwise
+
+int update_butterworth_filter(ButterworthFilterCache* cache, CvSize size,
+								int D, int n, float upper = 0, float lower = 0);
+
+// release the filter cache (and the cached filter)
+
+void release_butterworth_filter_cache(ButterworthFilterCache** cache);
+
+/******************************************************************************/
+
+#endif
@@ -0,0 +1,562 @@
+// Module : threaded prefetching frame source for video / camera input
+// usage: see ipcv_frame_source.h
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: the ring works as a simple bounded producer / consumer queue - the
+// decode thread fills slots behind the consumer and the slot last returned by
+// query_frame_source() is only recycled on the following call.
+
+#include "ipcv_frame_source.h"
+#include "ipcv_interface.h"
+#include "ipcv_raw_frames.h"
+#include "ipcv_timing.h"
+
+#include <stdio.h>
+#include <dirent.h>
+#include <string>
+#include <vector>
+#include <algorithm> // contains max() function (amongst others)
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/******************************************************************************/
+
+// base frame source (each source type implements queryFrame())
+
+struct FrameSource
+{
+	virtual ~FrameSource() {}
+
+	// return next frame (valid until the next call) or NULL at end of input
+
+	virtual IplImage* queryFrame() = 0;
+
+	// is the source a single (static) image
+
+	virtual bool isImage() const { return false; }
+};
+
+/******************************************************************************/
+
+// frame source for a single image file (returns the same image every time)
+
+struct ImageFrameSource : public FrameSource
+{
+	IplImage* img;				// loaded image (owned)
+
+	ImageFrameSource(IplImage* image) : img(image) {}
+	~ImageFrameSource() { cvReleaseImage(&img); }
+
+	IplImage* queryFrame() { return img; }
+	bool isImage() const { return true; }
+};
+
+/******************************************************************************/
+
+// frame source for a memory mapped raw frame file (see ipcv_raw_frames.h) -
+// interleaved frames are returned as an image header over the mapped pages
+// (no copy), planar frames are merged into an interleaved buffer
+
+struct RawFrameSource : public FrameSource
+{
+	const RawFrameHeader* file;	// mapped file
+	int64_t next;				// index of next frame
+	IplImage frame;				// image header (over the mapped frame)
+	IplImage planes[4];			// channel headers (planar layout only)
+	IplImage* merged;			// interleaved frame (planar layout only)
+
+	RawFrameSource(const RawFrameHeader* mapped);
+	~RawFrameSource();
+
+	IplImage* queryFrame();
+};
+
+/******************************************************************************/
+
+RawFrameSource::RawFrameSource(const RawFrameHeader* mapped)
+	: file(mapped), next(0), merged(NULL)
+{
+	CvSize size = cvSize(file->width, file->height);
+
+	if (file->layout == IPCV_RAW_PLANAR)
+	{
+		for (int c = 0; c < file->channels; c++)
+		{
+			cvInitImageHeader(&(planes[c]), size, file->depth, 1, file->origin, 4);
+		}
+		merged = cvCreateImage(size, file->depth, file->channels);
+		merged->origin = file->origin;
+	} else {
+		cvInitImageHeader(&frame, size, file->depth, file->channels, file->origin, 4);
+	}
+}
+
+/******************************************************************************/
+
+RawFrameSource::~RawFrameSource()
+{
+	if (merged) {
+		cvReleaseImage(&merged);
+	}
+	unmap_raw_frame_file(&file);
+}
+
+/******************************************************************************/
+
+IplImage* RawFrameSource::queryFrame()
+{
+	if (next >= file->frameCount) {
+		return NULL;	// end of input
+	}
+
+	// the previous frame is no longer in use (so any pages of it drawn on
+	// are released, rather than held until the file is unmapped)
+
+	if (next > 0) {
+		release_raw_frame(file, next - 1);
+	}
+
+	uchar* data = (uchar*) raw_frame_data(file, next);
+	next++;
+
+	if (!merged)
+	{
+		cvSetData(&frame, data, file->step);
+		return &frame;
+	}
+
+	IplImage* p[4] = { NULL, NULL, NULL, NULL };
+	for (int c = 0; c < file->channels; c++)
+	{
+		cvSetData(&(planes[c]), data + ((int64_t) c * file->height * file->step),
+				  file->step);
+		p[c] = &(planes[c]);
+	}
+	if (file->channels == 1) {
+		cvCopy(p[0], merged, NULL);
+	} else {
+		cvMerge(p[0], p[1], p[2], p[3], merged);
+	}
+	return merged;
+}
+
+/******************************************************************************/
+
+// frame source replaying frames held in memory (see create_replay_frame_source)
+
+struct ReplayFrameSource : public FrameSource
+{
+	std::vector<IplImage*> frames;	// recorded frames (owned)
+	IplImage* output;				// copy of the current frame (returned)
+	int loops;						// number of loops (0 = forever)
+	int loop;						// current loop
+	size_t next;					// index of next frame
+	double period;					// simulated frame period (s, 0 = none)
+	std::chrono::steady_clock::time_point due;	// when next frame is due
+
+	ReplayFrameSource(int nLoops, double fps)
+		: output(NULL), loops(nLoops), loop(0), next(0),
+		  period((fps > 0) ? 1.0 / fps : 0) {}
+	~ReplayFrameSource();
+
+	IplImage* queryFrame();
+};
+
+/******************************************************************************/
+
+ReplayFrameSource::~ReplayFrameSource()
+{
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		cvReleaseImage(&(frames[i]));
+	}
+	if (output) {
+		cvReleaseImage(&output);
+	}
+}
+
+/******************************************************************************/
+
+IplImage* ReplayFrameSource::queryFrame()
+{
+	if (next == frames.size())
+	{
+		loop++;
+		if ((loops > 0) && (loop >= loops)) {
+			return NULL;	// end of replay
+		}
+		next = 0;
+	}
+
+	// at a simulated frame rate wait until the frame is due (as a camera)
+
+	if (period > 0)
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if ((loop == 0) && (next == 0)) {
+			due = now;
+		} else {
+			std::this_thread::sleep_until(due);
+		}
+		due += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					std::chrono::duration<double>(period));
+	}
+
+	cvCopy(frames[next], output, NULL);
+	output->origin = frames[next]->origin;
+	next++;
+
+	return output;
+}
+
+/******************************************************************************/
+
+// frame source decoding from a capture object on a background thread
+
+struct PrefetchFrameSource : public FrameSource
+{
+	CvCapture* capture;			// capture object (owned)
+
+	IplImage** buffers;			// ring of pre-allocated frame buffers
+	int nBuffers;				// number of buffers in ring
+
+	int head;					// ring index of next frame for the consumer
+	int count;					// number of decoded frames in the ring
+	bool holding;				// consumer currently holds the head buffer
+	bool finished;				// decode thread has reached end of input
+	bool stopping;				// decode thread has been asked to stop
+
+	std::mutex lock;
+	std::condition_variable frameReady;		// signalled by decode thread
+	std::condition_variable slotFree;		// signalled by consumer
+	std::thread decoder;
+
+	PrefetchFrameSource(CvCapture* cap, IplImage* first, int n);
+	~PrefetchFrameSource();
+
+	IplImage* queryFrame();
+	void decode();
+};
+
+/******************************************************************************/
+
+// set up the ring (sized from the first frame) and start the decode thread
+
+PrefetchFrameSource::PrefetchFrameSource(CvCapture* cap, IplImage* first, int n)
+	: capture(cap), nBuffers(n), head(0), count(1),
+	  holding(false), finished(false), stopping(false)
+{
+	buffers = new IplImage*[nBuffers];
+	for (int i = 0; i < nBuffers; i++)
+	{
+		buffers[i] = cvCreateImage(cvGetSize(first), first->depth, first->nChannels);
+		buffers[i]->origin = first->origin;
+	}
+
+	// the first frame has already been decoded (to get the buffer sizes)
+
+	cvCopy(first, buffers[0], NULL);
+
+	decoder = std::thread(&PrefetchFrameSource::decode, this);
+}
+
+/******************************************************************************/
+
+PrefetchFrameSource::~PrefetchFrameSource()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	slotFree.notify_all();
+	decoder.join();
+
+	for (int i = 0; i < nBuffers; i++)
+	{
+		cvReleaseImage(&(buffers[i]));
+	}
+	delete [] buffers;
+
+	cvReleaseCapture(&capture);
+}
+
+/******************************************************************************/
+
+// decode thread: fill free slots of the ring until end of input (or stopped)
+
+void PrefetchFrameSource::decode()
+{
+	while (true)
+	{
+		int slot;
+
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			slotFree.wait(guard, [this]{ return (stopping || (count < nBuffers)); });
+			if (stopping) {
+				return;
+			}
+			slot = (head + count) % nBuffers;
+		}
+
+		// decode outside of the lock - the consumer never touches a slot
+		// that has not yet been counted as ready
+
+		IplImage* frame = cvQueryFrame(capture);
+
+		if ((!frame) || (frame->width != buffers[slot]->width) ||
+			(frame->height != buffers[slot]->height) ||
+			(frame->nChannels != buffers[slot]->nChannels))
+		{
+			if (frame) {
+				printf("ERROR: frame size changed during capture\n");
+			}
+			std::lock_guard<std::mutex> guard(lock);
+			finished = true;
+			frameReady.notify_all();
+			return;
+		}
+
+		cvCopy(frame, buffers[slot], NULL);
+		buffers[slot]->origin = frame->origin;
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			count++;
+		}
+		frameReady.notify_one();
+	}
+}
+
+/******************************************************************************/
+
+// give the consumer the next decoded frame (recycling the one it last held)
+
+IplImage* PrefetchFrameSource::queryFrame()
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	if (holding)
+	{
+		head = (head + 1) % nBuffers;
+		count--;
+		holding = false;
+		slotFree.notify_one();
+	}
+
+	frameReady.wait(guard, [this]{ return (finished || (count > 0)); });
+
+	if (count == 0) {
+		return NULL;	// end of input
+	}
+
+	holding = true;
+	return buffers[head];
+}
+
+/******************************************************************************/
+
+FrameSource* create_prefetch_frame_source(CvCapture* capture, int nBuffers)
+{
+	if (!capture) {
+		return NULL;
+	}
+
+	// get the first frame synchronously so the ring can be pre-allocated
+
+	IplImage* first = cvQueryFrame(capture);
+	if (!first) {
+		cvReleaseCapture(&capture);
+		return NULL;
+	}
+
+	return new PrefetchFrameSource(capture, first, std::max(2, nBuffers));
+}
+
+/******************************************************************************/
+
+// add a frame to a replay (all frames must be the same size and format)
+
+static bool add_replay_frame(ReplayFrameSource* replay, IplImage* frame,
+							 const char* name)
+{
+	if ((!replay->frames.empty()) &&
+		((frame->width != replay->frames[0]->width) ||
+		 (frame->height != replay->frames[0]->height) ||
+		 (frame->depth != replay->frames[0]->depth) ||
+		 (frame->nChannels != replay->frames[0]->nChannels)))
+	{
+		printf("ERROR: frame %s differs in size / format from the first\n", name);
+		return false;
+	}
+	replay->frames.push_back(frame);
+	return true;
+}
+
+// add a copy of a decoded (or mapped) frame to a replay, named by its index
+
+static bool add_replay_copy(ReplayFrameSource* replay, IplImage* frame)
+{
+	char name[32];
+	sprintf(name, "%lu", (unsigned long) replay->frames.size());
+	IplImage* copy = cvCloneImage(frame);
+	if (!add_replay_frame(replay, copy, name))
+	{
+		cvReleaseImage(&copy);
+		return false;
+	}
+	return true;
+}
+
+/******************************************************************************/
+
+FrameSource* create_replay_frame_source(const char* path, int loops, double fps)
+{
+	ReplayFrameSource* replay = new ReplayFrameSource(loops, fps);
+	DIR* dir = opendir(path);
+
+	if (dir)
+	{
+		// a directory of images (in file name order)
+
+		std::vector<std::string> names;
+		struct dirent* entry;
+		while ((entry = readdir(dir)) != NULL)
+		{
+			std::string name = std::string(path) + "/" + entry->d_name;
+			if ((entry->d_name[0] != '.') && cvHaveImageReader(name.c_str())) {
+				names.push_back(name);
+			}
+		}
+		closedir(dir);
+		std::sort(names.begin(), names.end());
+
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			IplImage* img = cvLoadImage(names[i].c_str(), CV_LOAD_IMAGE_UNCHANGED);
+			if ((!img) || (!add_replay_frame(replay, img, names[i].c_str())))
+			{
+				if (img) { cvReleaseImage(&img); }
+				delete replay;
+				return NULL;
+			}
+		}
+	} else if (is_raw_frame_file(path)) {
+
+		// a raw frame file (see ipcv_raw_frames.h) - each frame is copied out
+		// of the mapping, which is released as it is read
+
+		FrameSource* raw = create_raw_frame_source(path);
+		IplImage* frame;
+		while ((raw) && ((frame = raw->queryFrame()) != NULL))
+		{
+			if (!add_replay_copy(replay, frame)) {
+				break;
+			}
+		}
+		release_frame_source(&raw);
+	} else {
+
+		// a video file (decoded once, up front)
+
+		CvCapture* capture = cvCreateFileCapture(path);
+		IplImage* frame;
+		while ((capture) && ((frame = cvQueryFrame(capture)) != NULL))
+		{
+			if (!add_replay_copy(replay, frame)) {
+				break;
+			}
+		}
+		if (capture) {
+			cvReleaseCapture(&capture);
+		}
+	}
+
+	if (replay->frames.empty())
+	{
+		delete replay;
+		return NULL;
+	}
+
+	replay->output = cvCloneImage(replay->frames[0]);
+
+	printf("Replaying %lu frames from %s (loops = %i, fps = %.1f, 0 = unlimited)\n",
+			(unsigned long) replay->frames.size(), path, loops, fps);
+
+	return replay;
+}
+
+/******************************************************************************/
+
+FrameSource* create_raw_frame_source(const char* filename)
+{
+	const RawFrameHeader* file = map_raw_frame_file(filename);
+	if ((!file) || (file->frameCount == 0))
+	{
+		unmap_raw_frame_file(&file);
+		return NULL;
+	}
+	return new RawFrameSource(file);
+}
+
+/******************************************************************************/
+
+FrameSource* create_input_frame_source(int argc, char** argv, int cameraIndex)
+{
+	IplImage* img = NULL;
+	CvCapture* capture = NULL;
+
+	if (ipcv_replay_path()) {
+		return create_replay_frame_source(ipcv_replay_path(), ipcv_replay_loops(),
+										  ipcv_replay_fps());
+	}
+
+	if ( argc == 2 && is_raw_frame_file(argv[1]) ) {
+		return create_raw_frame_source(argv[1]);
+	}
+
+	if ( argc == 2 && (img = cvLoadImage( argv[1], CV_LOAD_IMAGE_UNCHANGED)) != 0 ) {
+		return new ImageFrameSource(img);
+	}
+
+	if (
+		( argc == 2 && (capture = cvCreateFileCapture( argv[1] )) != 0 ) ||
+		( argc != 2 && (capture = cvCreateCameraCapture( cameraIndex )) != 0 )
+	   )
+	{
+		return create_prefetch_frame_source(capture);
+	}
+
+	return NULL;
+}
+
+/******************************************************************************/
+
+bool frame_source_is_image(FrameSource* source)
+{
+	return source->isImage();
+}
+
+/******************************************************************************/
+
+IplImage* query_frame_source(FrameSource* source)
+{
+	IpcvScopedTimer timer(IPCV_TIMING_CAPTURE);
+	return source->queryFrame();
+}
+
+/******************************************************************************/
+
+void release_frame_source(FrameSource** source)
+{
+	if (*source)
+	{
+		delete *source;
+		*source = NULL;
+	}
+}
+
+/******************************************************************************/
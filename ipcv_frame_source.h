@@ -0,0 +1,102 @@
+// Module : threaded prefetching frame source for video / camera input
+// usage: #include "ipcv_frame_source.h" (link with ipcv_frame_source.cc)
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: a drop-in replacement for the cvQueryFrame() loop used in the
+// examples - frames are decoded on a background thread into a bounded ring of
+// pre-allocated IplImage buffers so that decode and processing overlap.
+
+#ifndef IPCV_FRAME_SOURCE_H
+#define IPCV_FRAME_SOURCE_H
+
+#include "cv.h"       // open cv general include file
+#include "highgui.h"  // open cv GUI include file
+
+/******************************************************************************/
+
+// default number of buffers in the prefetch ring (N.B. one of these is always
+// held by the caller, so N-1 frames can be decoded ahead of the processing)
+
+#define IPCV_PREFETCH_BUFFERS 4
+
+/******************************************************************************/
+
+// opaque frame source object (see ipcv_frame_source.cc)
+
+typedef struct FrameSource FrameSource;
+
+/******************************************************************************/
+
+// create a frame source that prefetches frames from a capture object on a
+// background thread
+
+// capture - capture object (video file or camera) - N.B. the frame source
+//           takes ownership of this and releases it in release_frame_source()
+// nBuffers - number of buffers in the prefetch ring (>= 2)
+// return value - pointer to frame source or NULL on failure (e.g. no frames)
+
+FrameSource* create_prefetch_frame_source(CvCapture* capture,
+											int nBuffers = IPCV_PREFETCH_BUFFERS);
+
+// create a frame source for the input named on the command line, as used by
+// all of the examples - i.e. an image or video file (argc == 2) or the
+// attached camera (otherwise)
+
+// argc, argv - command line arguments (after ipcv_parse_options())
+// cameraIndex - camera to use if no file is given
+// return value - pointer to frame source or NULL if the input cannot be opened
+
+// N.B. an image file gives a source that returns the same image on every
+// query (so examples can re-process it as trackbar parameters change)
+
+// N.B. if --replay has been given (see ipcv_interface.h) the replay frame
+// source below is used instead, whatever the other arguments
+
+FrameSource* create_input_frame_source(int argc, char** argv, int cameraIndex);
+
+// create a replay frame source - all of the frames of a recorded input are
+// loaded into memory up front and then served (as copies, so processing that
+// draws on a frame does not change the recording) without any decode or
+// camera in the loop, for reproducible (offline) performance runs
+
+// path - directory of images (replayed in file name order), raw frame file
+//        (see ipcv_raw_frames.h) or video file
+// loops - number of times to replay the frames (0 = forever)
+// fps - simulated frame rate (frames are served no faster than this, to
+//       model a live camera) or 0 to serve them as fast as they are asked for
+// return value - pointer to frame source or NULL if no frames can be read
+
+FrameSource* create_replay_frame_source(const char* path, int loops = 1,
+										double fps = 0);
+
+// create a frame source reading a raw frame file (see ipcv_raw_frames.h)
+// through mmap() - each frame is returned as an image over the mapped file
+// with no decode or copy (N.B. used by create_input_frame_source() for any
+// raw frame file named on the command line)
+
+// return value - pointer to frame source or NULL on failure
+
+FrameSource* create_raw_frame_source(const char* filename);
+
+// return true if the frame source is a single image (rather than video)
+
+bool frame_source_is_image(FrameSource* source);
+
+// get the next frame from the frame source
+
+// source - frame source
+// return value - pointer to next frame or NULL if the end of the input has been
+//                reached (as for cvQueryFrame() this image is owned by the
+//                frame source and is only valid until the next call)
+
+IplImage* query_frame_source(FrameSource* source);
+
+// stop any background decoding and release the frame source (and any
+// capture object it owns)
+
+void release_frame_source(FrameSource** source);
+
+/******************************************************************************/
+
+#endif
@@ -0,0 +1,428 @@
+// Module : gallery of normalised histograms for histogram based recognition
+// usage: see ipcv_gallery.h
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+#include "ipcv_gallery.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <string>
+#include <algorithm> // contains max() function (amongst others)
+#include <thread>
+#include <atomic>
+
+/******************************************************************************/
+
+// number of gallery rows compared by a thread at a time
+
+#define GALLERY_CHUNK 256
+
+struct HistogramGallery
+{
+	int bins;					// bins per histogram (floats per row)
+	int threads;				// number of threads used to search the gallery
+	std::vector<float> rows;	// histograms, one row of bins each
+	std::vector<double> sums;	// sum of each row
+	std::vector<double> sumsq;	// sum of squares of each row
+};
+
+/******************************************************************************/
+
+HistogramGallery* create_histogram_gallery(int bins, int threads)
+{
+	HistogramGallery* gallery = new HistogramGallery;
+
+	gallery->bins = bins;
+	gallery->threads = (threads > 0) ? threads :
+					   std::max(1, (int) std::thread::hardware_concurrency());
+
+	return gallery;
+}
+
+/******************************************************************************/
+
+// the bins of a 1D histogram (or NULL if it does not have n bins)
+
+static const float* histogram_values(const CvHistogram* hist, int n)
+{
+	CvMat stub;
+	CvMat* mat = cvGetMat(hist->bins, &stub, 0, 1);
+
+	if (((mat->rows * mat->cols) != n) || (CV_MAT_TYPE(mat->type) != CV_32FC1)) {
+		return NULL;
+	}
+	return mat->data.fl;
+}
+
+/******************************************************************************/
+
+// append a row (normalised to sum to 1) and its sums
+
+static void append_row(HistogramGallery* gallery, const float* values)
+{
+	int n = gallery->bins;
+	double sum = 0;
+
+	for (int i = 0; i < n; i++) {
+		sum += values[i];
+	}
+	float scale = (fabs(sum) > DBL_EPSILON) ? (float) (1. / sum) : 0.f;
+
+	size_t start = gallery->rows.size();
+	gallery->rows.resize(start + n);
+	float* row = &(gallery->rows[start]);
+
+	double s = 0, sq = 0;
+	for (int i = 0; i < n; i++)
+	{
+		row[i] = values[i] * scale;
+		s += row[i];
+		sq += row[i] * row[i];
+	}
+	gallery->sums.push_back(s);
+	gallery->sumsq.push_back(sq);
+}
+
+/******************************************************************************/
+
+int add_gallery_histogram(HistogramGallery* gallery, const CvHistogram* hist)
+{
+	const float* values = histogram_values(hist, gallery->bins);
+	if (!values) {
+		return -1;
+	}
+
+	append_row(gallery, values);
+	return gallery_size(gallery) - 1;
+}
+
+/******************************************************************************/
+
+int gallery_size(const HistogramGallery* gallery)
+{
+	return (int) gallery->sums.size();
+}
+
+int gallery_bins(const HistogramGallery* gallery)
+{
+	return gallery->bins;
+}
+
+/******************************************************************************/
+
+void clear_histogram_gallery(HistogramGallery* gallery)
+{
+	gallery->rows.clear();
+	gallery->sums.clear();
+	gallery->sumsq.clear();
+}
+
+/******************************************************************************/
+
+// a query prepared for comparison (with the reciprocal of each bin for the
+// chi-squared measure, 0 for an empty bin, and its sums)
+
+struct GalleryQuery
+{
+	std::vector<float> q;
+	std::vector<float> qinv;
+	double sum;
+	double sumsq;
+};
+
+// compare the query with one row (as cvCompareHist(), with the query as the
+// first histogram) - the four measures in one pass over the bins
+
+static void compare_row(const HistogramGallery* gallery, const GalleryQuery& query,
+						int index, GalleryComparison* c)
+{
+	int n = gallery->bins;
+	const float* q = &(query.q[0]);
+	const float* qinv = &(query.qinv[0]);
+	const float* g = &(gallery->rows[(size_t) index * n]);
+
+	float s12 = 0, chi = 0, inter = 0, bh = 0;
+	for (int i = 0; i < n; i++)
+	{
+		float d = q[i] - g[i];
+		s12 += q[i] * g[i];
+		chi += d * d * qinv[i];
+		inter += std::min(q[i], g[i]);
+		bh += sqrtf(q[i] * g[i]);
+	}
+
+	double gsum = gallery->sums[index];
+	double scale = 1. / n;
+	double num = s12 - (query.sum * gsum * scale);
+	double denom2 = (query.sumsq - (query.sum * query.sum * scale)) *
+					(gallery->sumsq[index] - (gsum * gsum * scale));
+	double bscale = query.sum * gsum;
+	bscale = (fabs(bscale) > FLT_EPSILON) ? 1. / sqrt(bscale) : 1.;
+
+	c->index = index;
+	c->correlation = (fabs(denom2) > DBL_EPSILON) ? num / sqrt(denom2) : 1.;
+	c->chisquared = chi;
+	c->intersect = inter;
+	c->bhattacharyya = sqrt(std::max(1. - (bh * bscale), 0.));
+	c->distance = (1 - c->correlation) + c->chisquared + (1 - c->intersect) +
+				  c->bhattacharyya;
+}
+
+/******************************************************************************/
+
+// prepare a query for comparison (false if it does not have the gallery bins)
+
+static bool prepare_query(const HistogramGallery* gallery, const CvHistogram* hist,
+						  GalleryQuery* q)
+{
+	int n = gallery->bins;
+	const float* values = histogram_values(hist, n);
+	if (!values) {
+		return false;
+	}
+
+	q->q.assign(values, values + n);
+	q->qinv.resize(n);
+	q->sum = 0;
+	q->sumsq = 0;
+	for (int i = 0; i < n; i++)
+	{
+		q->qinv[i] = (fabs(values[i]) > DBL_EPSILON) ? 1.f / values[i] : 0.f;
+		q->sum += values[i];
+		q->sumsq += values[i] * values[i];
+	}
+	return true;
+}
+
+/******************************************************************************/
+
+// the work of one query, shared by the threads
+
+struct GalleryWork
+{
+	const HistogramGallery* gallery;
+	const GalleryQuery* query;
+	std::vector<GalleryComparison>* all;	// (if wanted)
+	std::vector<GalleryComparison> best;	// closest found by each thread
+	std::atomic<int> next;					// next chunk of rows to be started
+};
+
+// compare chunks of rows until all have been started
+
+static void gallery_worker(GalleryWork* work, int id)
+{
+	int count = gallery_size(work->gallery);
+	GalleryComparison& best = work->best[id];
+	GalleryComparison c;
+
+	for (int start = (work->next++) * GALLERY_CHUNK; start < count;
+		 start = (work->next++) * GALLERY_CHUNK)
+	{
+		int end = std::min(count, start + GALLERY_CHUNK);
+		for (int i = start; i < end; i++)
+		{
+			compare_row(work->gallery, *(work->query), i, &c);
+			if (work->all) {
+				(*(work->all))[i] = c;
+			}
+			if ((best.index < 0) || (c.distance < best.distance)) {
+				best = c;
+			}
+		}
+	}
+}
+
+/******************************************************************************/
+
+int match_histogram_gallery(HistogramGallery* gallery, const CvHistogram* query,
+							GalleryComparison* best,
+							std::vector<GalleryComparison>* all)
+{
+	int count = gallery_size(gallery);
+	GalleryQuery q;
+
+	if (all) {
+		all->resize(count);
+	}
+	if ((count == 0) || (!prepare_query(gallery, query, &q))) {
+		return -1;
+	}
+
+	// compare the rows in parallel (each thread taking the next chunk of
+	// rows not yet started, with the calling thread as one of them)
+
+	int chunks = (count + GALLERY_CHUNK - 1) / GALLERY_CHUNK;
+	int threads = std::min(gallery->threads, chunks);
+
+	GalleryWork work;
+	work.gallery = gallery;
+	work.query = &q;
+	work.all = all;
+	work.best.resize(threads);
+	for (int i = 0; i < threads; i++) {
+		work.best[i].index = -1;
+	}
+	work.next = 0;
+	std::vector<std::thread> workers;
+
+	for (int i = 1; i < threads; i++)
+	{
+		workers.push_back(std::thread(gallery_worker, &work, i));
+	}
+	gallery_worker(&work, 0);
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+
+	// closest over all of the threads (the lowest index of any tie, as a
+	// sequential search)
+
+	GalleryComparison* closest = NULL;
+	for (int i = 0; i < threads; i++)
+	{
+		GalleryComparison* c = &(work.best[i]);
+		if ((c->index >= 0) && ((!closest) || (c->distance < closest->distance) ||
+			((c->distance == closest->distance) && (c->index < closest->index)))) {
+			closest = c;
+		}
+	}
+
+	if (best) {
+		*best = *closest;
+	}
+	return closest->index;
+}
+
+/******************************************************************************/
+
+bool compare_gallery_histogram(const HistogramGallery* gallery,
+							   const CvHistogram* query, int index,
+							   GalleryComparison* comparison)
+{
+	GalleryQuery q;
+
+	if ((index < 0) || (index >= gallery_size(gallery)) ||
+		(!prepare_query(gallery, query, &q))) {
+		return false;
+	}
+	compare_row(gallery, q, index, comparison);
+	return true;
+}
+
+/******************************************************************************/
+
+const float* gallery_histogram(const HistogramGallery* gallery, int index)
+{
+	return &(gallery->rows[(size_t) index * gallery->bins]);
+}
+
+/******************************************************************************/
+
+int save_histogram_gallery(const HistogramGallery* gallery, const char* filename)
+{
+	// written to a temporary file, renamed over the gallery file only once
+	// it is complete (so a failed write cannot truncate an existing gallery)
+
+	std::string temporary = std::string(filename) + ".tmp";
+	FILE* file = fopen(temporary.c_str(), "wb");
+	if (!file) {
+		return 0;
+	}
+
+	HistogramGalleryHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, IPCV_GALLERY_MAGIC, 8);
+	h.bins = gallery->bins;
+	h.count = gallery_size(gallery);
+
+	size_t values = gallery->rows.size();
+	bool ok = (fwrite(&h, sizeof(h), 1, file) == 1) &&
+			  ((!values) || (fwrite(&(gallery->rows[0]), sizeof(float), values,
+									file) == values));
+
+	ok = (fclose(file) == 0) && ok;
+
+#ifdef _WIN32
+	if (ok) {
+		remove(filename); // (rename() does not replace a file on windows)
+	}
+#endif
+	if ((!ok) || (rename(temporary.c_str(), filename) != 0))
+	{
+		remove(temporary.c_str());
+		return 0;
+	}
+	return 1;
+}
+
+/******************************************************************************/
+
+HistogramGallery* load_histogram_gallery(const char* filename, int threads)
+{
+	FILE* file = fopen(filename, "rb");
+	if (!file) {
+		return NULL;
+	}
+
+	HistogramGalleryHeader h;
+	if ((fread(&h, sizeof(h), 1, file) != 1) ||
+		(memcmp(h.magic, IPCV_GALLERY_MAGIC, 8)) || (h.bins <= 0) || (h.count < 0))
+	{
+		printf("ERROR: %s is not a histogram gallery file\n", filename);
+		fclose(file);
+		return NULL;
+	}
+
+	// the rows must be exactly the rest of the file (checked before any
+	// memory is reserved for them, so a corrupt count is not trusted)
+
+	long start = ftell(file);
+	long end = ((start >= 0) && (fseek(file, 0, SEEK_END) == 0)) ? ftell(file) : -1;
+	int64_t rowBytes = (int64_t) h.bins * (int64_t) sizeof(float);
+	if ((end < start) || (fseek(file, start, SEEK_SET) != 0) ||
+		(h.count > ((int64_t) (end - start)) / rowBytes) ||
+		((h.count * rowBytes) != (int64_t) (end - start)))
+	{
+		printf("ERROR: %s is not a complete histogram gallery file\n", filename);
+		fclose(file);
+		return NULL;
+	}
+
+	HistogramGallery* gallery = create_histogram_gallery(h.bins, threads);
+	std::vector<float> row(h.bins);
+
+	gallery->rows.reserve((size_t) (h.count * h.bins));
+	gallery->sums.reserve((size_t) h.count);
+	gallery->sumsq.reserve((size_t) h.count);
+
+	for (int64_t i = 0; i < h.count; i++)
+	{
+		if (fread(&(row[0]), sizeof(float), h.bins, file) != (size_t) h.bins)
+		{
+			printf("ERROR: %s is not a complete histogram gallery file\n", filename);
+			release_histogram_gallery(&gallery);
+			break;
+		}
+		append_row(gallery, &(row[0]));
+	}
+	fclose(file);
+
+	return gallery;
+}
+
+/******************************************************************************/
+
+void release_histogram_gallery(HistogramGallery** gallery)
+{
+	if ((gallery) && (*gallery))
+	{
+		delete *gallery;
+		*gallery = NULL;
+	}
+}
+
+/******************************************************************************/
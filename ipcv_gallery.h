@@ -0,0 +1,122 @@
+// Module : gallery of normalised histograms for histogram based recognition
+// usage: #include "ipcv_gallery.h" (link with the ipcv library)
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: the gallery holds each sample histogram (normalised to sum to 1) as
+// one row of a single contiguous float matrix, with no limit on the number of
+// samples. A query is compared against every row by the four measures of
+// histogram_based_recognition.cc (as cvCompareHist() - correlation, chi-squared,
+// intersection and Bhattacharyya) in one pass over the row, with the rows
+// split between threads - rather than four cvCompareHist() calls per sample.
+
+// A gallery can be saved to / loaded from a binary file: a small fixed header
+// (see HistogramGalleryHeader) followed by the rows. (N.B. values are stored
+// in the byte order of the machine that wrote the file)
+
+#ifndef IPCV_GALLERY_H
+#define IPCV_GALLERY_H
+
+#include "cv.h"       // open cv general include file
+
+#include <stdint.h>
+#include <vector>
+
+/******************************************************************************/
+
+#define IPCV_GALLERY_MAGIC "IPCVHGL1"	// first 8 bytes of every gallery file
+
+// file header
+
+typedef struct HistogramGalleryHeader
+{
+	char magic[8];			// IPCV_GALLERY_MAGIC
+	int32_t bins;			// bins per histogram (floats per row)
+	int32_t reserved;
+	int64_t count;			// number of histograms (rows)
+} HistogramGalleryHeader;
+
+// the comparison of a query histogram with one gallery histogram
+
+typedef struct GalleryComparison
+{
+	int index;				// gallery histogram (row)
+	double correlation;		// CV_COMP_CORREL
+	double chisquared;		// CV_COMP_CHISQR
+	double intersect;		// CV_COMP_INTERSECT
+	double bhattacharyya;	// CV_COMP_BHATTACHARYYA
+	double distance;		// combined distance (see match_histogram_gallery)
+} GalleryComparison;
+
+typedef struct HistogramGallery HistogramGallery;
+
+/******************************************************************************/
+
+// create an (empty) gallery
+
+// bins - bins per histogram
+// threads - number of threads used to search the gallery (0 = one per core)
+// return value - pointer to gallery
+
+HistogramGallery* create_histogram_gallery(int bins, int threads = 0);
+
+// add a (1D, bins sized) histogram to the gallery (normalised to sum to 1)
+// return value - index of the histogram, or -1 if the number of bins differ
+
+int add_gallery_histogram(HistogramGallery* gallery, const CvHistogram* hist);
+
+// number of histograms / bins per histogram in the gallery
+
+int gallery_size(const HistogramGallery* gallery);
+int gallery_bins(const HistogramGallery* gallery);
+
+// remove all of the histograms
+
+void clear_histogram_gallery(HistogramGallery* gallery);
+
+// compare a query histogram (normalised to sum to 1) with every gallery
+// histogram and return the closest, where the distance combines the four
+// measures as (1 - correlation) + chisquared + (1 - intersect) + bhattacharyya
+
+// query - query histogram (with the same number of bins as the gallery)
+// best - returned comparison with the closest gallery histogram
+// all - if not NULL, returned comparison with every gallery histogram (in
+//       gallery order)
+// return value - index of the closest histogram, or -1 if the gallery is empty
+
+int match_histogram_gallery(HistogramGallery* gallery, const CvHistogram* query,
+							GalleryComparison* best,
+							std::vector<GalleryComparison>* all = NULL);
+
+// compare a query histogram with one gallery histogram (as above)
+// return value - false if the index is not in the gallery
+
+bool compare_gallery_histogram(const HistogramGallery* gallery,
+							   const CvHistogram* query, int index,
+							   GalleryComparison* comparison);
+
+// return the (normalised) bins of one gallery histogram
+
+const float* gallery_histogram(const HistogramGallery* gallery, int index);
+
+// save the gallery to a file (written to <filename>.tmp and then renamed, so
+// an existing file is only replaced by a complete gallery)
+// return value - 1 on success, 0 on failure
+
+int save_histogram_gallery(const HistogramGallery* gallery, const char* filename);
+
+// load a gallery from a file
+
+// threads - number of threads used to search the gallery (0 = one per core)
+// return value - pointer to gallery, or NULL if the file cannot be read / is
+//                not a (complete) gallery file
+
+HistogramGallery* load_histogram_gallery(const char* filename, int threads = 0);
+
+// release the gallery
+
+void release_histogram_gallery(HistogramGallery** gallery);
+
+/******************************************************************************/
+
+#endif
@@ -0,0 +1,232 @@
+// Module : shared histogram functions for the histogram based examples
+// usage: see ipcv_histogram.h
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+#include "ipcv_histogram.h"
+
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+/******************************************************************************/
+
+GrayHistogram* create_gray_histogram()
+{
+	GrayHistogram* hist = new GrayHistogram;
+
+	memset(hist->bins, 0, sizeof(hist->bins));
+	hist->columnTop = NULL;
+	hist->columns = 0;
+
+	return hist;
+}
+
+/******************************************************************************/
+
+void release_gray_histogram(GrayHistogram** hist)
+{
+	if ((hist) && (*hist))
+	{
+		delete [] (*hist)->columnTop;
+		delete *hist;
+		*hist = NULL;
+	}
+}
+
+/******************************************************************************/
+
+void calc_gray_histogram(GrayHistogram* hist, const IplImage* grayImg)
+{
+	CvMat stub;
+	CvMat* mat = cvGetMat(grayImg, &stub);	// (respects any image ROI)
+
+	if (CV_MAT_TYPE(mat->type) != CV_8UC1){
+		cvError( CV_StsUnsupportedFormat, "calc_gray_histogram",
+				"Image must be 8-bit single channel", __FILE__, __LINE__ );
+	}
+
+	memset(hist->sub, 0, sizeof(hist->sub));
+	unsigned int* c0 = hist->sub[0];
+	unsigned int* c1 = hist->sub[1];
+	unsigned int* c2 = hist->sub[2];
+	unsigned int* c3 = hist->sub[3];
+
+	// a continuous image is counted as one long row
+
+	int rows = mat->rows;
+	int cols = mat->cols;
+	if (CV_IS_MAT_CONT(mat->type)){
+		cols *= rows;
+		rows = 1;
+	}
+
+	for (int i = 0; i < rows; i++)
+	{
+		const uchar* p = mat->data.ptr + (i * mat->step);
+		int j = 0;
+
+		// four pixels at a time, each into its own sub-histogram
+
+		for (; j <= cols - 4; j += 4)
+		{
+			c0[p[j]]++;
+			c1[p[j + 1]]++;
+			c2[p[j + 2]]++;
+			c3[p[j + 3]]++;
+		}
+		for (; j < cols; j++) {
+			c0[p[j]]++;
+		}
+	}
+
+	for (int v = 0; v < 256; v++) {
+		hist->bins[v] = c0[v] + c1[v] + c2[v] + c3[v];
+	}
+}
+
+/******************************************************************************/
+
+void draw_gray_histogram(GrayHistogram* hist, IplImage* histogramImage)
+{
+	int width = histogramImage->width;
+	int height = histogramImage->height;
+
+	if (hist->columns < width)
+	{
+		delete [] hist->columnTop;
+		hist->columnTop = new int[width];
+		hist->columns = width;
+	}
+	int* top = hist->columnTop;
+
+	// bar heights scaled so that the largest bin fills the image height
+
+	unsigned int max_value = 0;
+	for (int i = 0; i < 256; i++) {
+		max_value = std::max(max_value, hist->bins[i]);
+	}
+	double scale = (max_value) ? ((double) height) / max_value : 0;
+
+	// top row of the bar covering each column (bars of adjacent bins share
+	// their boundary column, in which the taller bar is drawn)
+
+	int bin_w = cvRound((double) width / 256);
+	for (int x = 0; x < width; x++) {
+		top[x] = height;
+	}
+	for (int i = 0; i < 256; i++)
+	{
+		int barTop = std::max(0, height - cvRound(hist->bins[i] * scale));
+		int x1 = std::min((i + 1) * bin_w, width - 1);
+		for (int x = i * bin_w; x <= x1; x++) {
+			top[x] = std::min(top[x], barTop);
+		}
+	}
+
+	// write the image row by row (black below the bar tops, white above)
+
+	for (int y = 0; y < height; y++)
+	{
+		uchar* row = (uchar*) (histogramImage->imageData
+												+ (y * histogramImage->widthStep));
+		for (int x = 0; x < width; x++) {
+			row[x] = (y >= top[x]) ? 0 : 255;
+		}
+	}
+}
+
+/******************************************************************************/
+
+void update_histogram_image(GrayHistogram* hist, const IplImage* grayImg,
+							IplImage* histogramImage)
+{
+	calc_gray_histogram(hist, grayImg);
+	draw_gray_histogram(hist, histogramImage);
+}
+
+/******************************************************************************/
+
+// function that takes a gray scale image and draws a histogram
+// image for it in a pre-allocated image
+
+void create_histogram_image(IplImage* grayImg, IplImage* histogramImage){
+
+  GrayHistogram* hist = create_gray_histogram();
+  update_histogram_image(hist, grayImg, histogramImage);
+  release_gray_histogram(&hist);
+}
+
+/******************************************************************************/
+
+// joint bin of a BGR pixel (each channel reduced by shift to bits bits)
+
+static inline int joint_bin(const uchar* p, int shift, int bits)
+{
+	return ((p[0] >> shift) << (2 * bits)) | ((p[1] >> shift) << bits) | (p[2] >> shift);
+}
+
+void calc_joint_colour_histogram(const IplImage* img, int levels, CvHistogram* hist)
+{
+	CvMat stub, binStub;
+	CvMat* mat = cvGetMat(img, &stub);	// (respects any image ROI)
+	CvMat* bins = cvGetMat(hist->bins, &binStub, 0, 1);
+	int n = levels * levels * levels;
+
+	int shift = 0;
+	while ((256 >> shift) > levels) {
+		shift++;
+	}
+
+	if ((CV_MAT_TYPE(mat->type) != CV_8UC3) || ((256 >> shift) != levels) ||
+		((bins->rows * bins->cols) != n)){
+		cvError( CV_StsUnsupportedFormat, "calc_joint_colour_histogram",
+				"Image must be 8-bit 3 channel (and histogram of levels^3 bins)",
+				__FILE__, __LINE__ );
+	}
+
+	// counted as calc_gray_histogram(), each pixel of a group of four into its
+	// own sub-histogram
+
+	std::vector<unsigned int> counts(IPCV_HISTOGRAM_SUBHISTS * n, 0);
+	unsigned int* c0 = &(counts[0]);
+	unsigned int* c1 = c0 + n;
+	unsigned int* c2 = c1 + n;
+	unsigned int* c3 = c2 + n;
+	int bits = 8 - shift;			// (bits per channel in the bin)
+
+	int rows = mat->rows;
+	int cols = mat->cols;
+	if (CV_IS_MAT_CONT(mat->type)){
+		cols *= rows;
+		rows = 1;
+	}
+
+	for (int i = 0; i < rows; i++)
+	{
+		const uchar* p = mat->data.ptr + (i * mat->step);
+		int j = 0;
+
+		for (; j <= cols - 4; j += 4, p += 12)
+		{
+			c0[joint_bin(p, shift, bits)]++;
+			c1[joint_bin(p + 3, shift, bits)]++;
+			c2[joint_bin(p + 6, shift, bits)]++;
+			c3[joint_bin(p + 9, shift, bits)]++;
+		}
+		for (; j < cols; j++, p += 3) {
+			c0[joint_bin(p, shift, bits)]++;
+		}
+	}
+
+	// normalised to sum to 1 (as cvNormalizeHist(hist, 1))
+
+	double total = ((double) mat->rows) * mat->cols;
+	float scale = (total > 0) ? (float) (1. / total) : 0.f;
+	float* h = bins->data.fl;
+	for (int v = 0; v < n; v++) {
+		h[v] = (c0[v] + c1[v] + c2[v] + c3[v]) * scale;
+	}
+}
+
+/******************************************************************************/
@@ -0,0 +1,75 @@
+// Module : shared histogram functions for the histogram based examples
+// usage: #include "ipcv_histogram.h" (link with the ipcv library)
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: the 256 bin gray scale histograms drawn by the histogram examples
+// are held in persistent objects (one per histogram window) that are counted
+// and drawn directly, rather than creating, calculating and releasing a
+// CvHistogram and drawing each bar with cvRectangle() on every frame
+
+#ifndef IPCV_HISTOGRAM_H
+#define IPCV_HISTOGRAM_H
+
+#include "cv.h"       // open cv general include file
+
+/******************************************************************************/
+
+// number of interleaved sub-histograms used when counting (consecutive pixels
+// of the same value then increment different counters, avoiding a stall on
+// the store to load dependency of a single counter)
+
+#define IPCV_HISTOGRAM_SUBHISTS 4
+
+// 256 bin histogram of an 8-bit gray scale image (and the drawing buffer
+// for the histogram image it is displayed in)
+
+typedef struct GrayHistogram
+{
+	unsigned int bins[256];						// histogram counts
+	unsigned int sub[IPCV_HISTOGRAM_SUBHISTS][256];	// counting sub-histograms
+	int* columnTop;		// top row of the (black) bar in each image column
+	int columns;		// number of columns allocated in columnTop
+} GrayHistogram;
+
+/******************************************************************************/
+
+// create / release a histogram object
+
+GrayHistogram* create_gray_histogram();
+void release_gray_histogram(GrayHistogram** hist);
+
+// count the histogram of an 8-bit single channel image (or its ROI)
+
+void calc_gray_histogram(GrayHistogram* hist, const IplImage* grayImg);
+
+// draw the histogram (black bars, scaled to the largest bin, on white) into
+// a pre-allocated 8-bit single channel image - as the original cvRectangle()
+// drawing, bar i spans columns i * bin_w to (i+1) * bin_w inclusive, where
+// bin_w = cvRound(width / 256)
+
+void draw_gray_histogram(GrayHistogram* hist, IplImage* histogramImage);
+
+// calculate and draw the histogram of an image in one call
+
+void update_histogram_image(GrayHistogram* hist, const IplImage* grayImg,
+							IplImage* histogramImage);
+
+// function that takes a gray scale image and draws a histogram
+// image for it in a pre-allocated image (using a temporary histogram object)
+
+void create_histogram_image(IplImage* grayImg, IplImage* histogramImage);
+
+/******************************************************************************/
+
+// joint colour histogram of an 8-bit 3 channel (BGR) image (or its ROI) in a
+// single pass over the interleaved pixels (no cvSplit()), into a 1D histogram
+// of levels^3 bins normalised to sum to 1 - with levels (a power of 2, at most
+// 256) bins per channel, the bin of a pixel is ((b * levels) + g) * levels + r
+// (each channel reduced to levels values)
+
+void calc_joint_colour_histogram(const IplImage* img, int levels, CvHistogram* hist);
+
+/******************************************************************************/
+
+#endif
@@ -0,0 +1,492 @@
+// Module : shared command line / display interface for the examples
+// usage: see ipcv_interface.h
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+#include "ipcv_interface.h"
+#include "ipcv_timing.h"
+#include "ipcv_template.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm> // contains max() function (amongst others)
+
+/******************************************************************************/
+
+// file sink for one (virtual) window in headless mode
+
+struct HeadlessSink
+{
+	std::string name;		// window name
+	int index;				// window index (used to name the output file)
+	CvVideoWriter* writer;	// video writer (NULL until first frame / images)
+	IplImage* scaled;		// 8-bit conversion buffer (for non 8-bit images)
+	IplImage* frame;		// 8-bit 3 channel output frame buffer
+};
+
+// global state (bad pratice yes, but the examples are single windowed loops)
+
+static bool headless = false;				// running in headless mode
+static const char* outputPrefix = "output";	// prefix for headless output files
+static bool singleImageInput = false;		// input is an image (not a video)
+static long frameLimit = 0;					// stop after N frames (0 = all)
+static long frameCount = 0;					// frames processed so far
+static bool realDFT = false;				// use the real input DFT path
+static int templateLevels = 0;				// template matching pyramid levels
+static int trackMargin = 0;					// tracking margin (0 = none)
+static double trackThreshold = 0.9;			// template tracking score threshold
+static int matchEngine = IPCV_TEMPLATE_AUTO;	// template matching engine
+static const char* replayPath = NULL;		// replay input (NULL = none)
+static int replayLoops = 1;					// number of times to replay
+static double replayFPS = 0;				// simulated replay rate (0 = none)
+static bool haveROI = false;				// initial selection given
+static CvRect initialROI;					// initial selection
+static std::vector<HeadlessSink> sinks;		// one sink per named window
+
+#define HEADLESS_OUTPUT_FPS 25	// matches the 40ms EVENT_LOOP_DELAY pacing
+
+/******************************************************************************/
+
+// print usage for the shared options and exit
+
+static void print_option_usage(const char* prog)
+{
+	printf("usage: %s [--headless <output_prefix>] [--frames <N>] [--real-dft] "
+			"[--pyramid <levels>]\n\t[--track <margin> [--track-threshold <score>]] "
+			"[--match-engine <auto|spatial|fft>]\n\t[--timing <file.csv|file.json>] "
+			"[--replay <dir|raw|video> [--replay-fps <fps>] [--loops <N>]]\n\t"
+			"[--roi <x,y,w,h>] ...\n", prog);
+	exit(1);
+}
+
+/******************************************************************************/
+
+// release all file sinks (also run at exit as the examples exit() at the end
+// of a video file without destroying their windows)
+
+static void release_sinks()
+{
+	for (size_t i = 0; i < sinks.size(); i++)
+	{
+		if (sinks[i].writer) {
+			cvReleaseVideoWriter(&(sinks[i].writer));
+		}
+		if (sinks[i].scaled) {
+			cvReleaseImage(&(sinks[i].scaled));
+		}
+		if (sinks[i].frame) {
+			cvReleaseImage(&(sinks[i].frame));
+		}
+	}
+	sinks.clear();
+}
+
+/******************************************************************************/
+
+void ipcv_parse_options(int* argc, char** argv, int flags)
+{
+	int kept = 1;
+
+	for (int i = 1; i < *argc; i++)
+	{
+		if (!strcmp(argv[i], "--headless")) {
+			if (++i >= *argc) { print_option_usage(argv[0]); }
+			headless = true;
+			outputPrefix = argv[i];
+		} else if (!strcmp(argv[i], "--frames")) {
+			if (++i >= *argc) { print_option_usage(argv[0]); }
+			frameLimit = atol(argv[i]);
+		} else if (!strcmp(argv[i], "--real-dft")) {
+			realDFT = true;
+		} else if (!strcmp(argv[i], "--pyramid")) {
+			if (++i >= *argc) { print_option_usage(argv[0]); }
+			templateLevels = atoi(argv[i]);
+		} else if (!strcmp(argv[i], "--track")) {
+			if (++i >= *argc) { print_option_usage(argv[0]); }
+			trackMargin = atoi(argv[i]);
+		} else if (!strcmp(argv[i], "--track-threshold")) {
+			if (++i >= *argc) { print_option_usage(argv[0]); }
+			trackThreshold = atof(argv[i]);
+		} else if (!strcmp(argv[i], "--match-engine")) {
+			if (++i >= *argc) { print_option_usage(argv[0]); }
+			if (!strcmp(argv[i], "spatial")) {
+				matchEngine = IPCV_TEMPLATE_SPATIAL;
+			} else if (!strcmp(argv[i], "fft")) {
+				matchEngine = IPCV_TEMPLATE_FFT;
+			} else if (!strcmp(argv[i], "auto")) {
+				matchEngine = IPCV_TEMPLATE_AUTO;
+			} else {
+				print_option_usage(argv[0]);
+			}
+		} else if (!strcmp(argv[i], "--timing")) {
+			if (++i >= *argc) { print_option_usage(argv[0]); }
+			ipcv_timing_enable(argv[i]);
+		} else if (!strcmp(argv[i], "--replay")) {
+			if (++i >= *argc) { print_option_usage(argv[0]); }
+			if (!(flags & IPCV_REPLAY_INPUT)) {
+
+				// (an example reading its capture object directly would
+				// silently use its usual input instead, unpaced)
+
+				printf("ERROR: --replay is not supported by %s "
+						"(input not read through a frame source)\n", argv[0]);
+				exit(1);
+			}
+			replayPath = argv[i];
+		} else if (!strcmp(argv[i], "--replay-fps")) {
+			if (++i >= *argc) { print_option_usage(argv[0]); }
+			replayFPS = atof(argv[i]);
+		} else if (!strcmp(argv[i], "--loops")) {
+			if (++i >= *argc) { print_option_usage(argv[0]); }
+			replayLoops = atoi(argv[i]);
+		} else if (!strcmp(argv[i], "--roi")) {
+			if ((++i >= *argc) || (sscanf(argv[i], "%i,%i,%i,%i", &initialROI.x,
+				&initialROI.y, &initialROI.width, &initialROI.height) != 4)) {
+				print_option_usage(argv[0]);
+			}
+			haveROI = true;
+		} else {
+			argv[kept++] = argv[i];	// not a shared option - keep it
+		}
+	}
+
+	*argc = kept;
+	argv[kept] = NULL;
+
+	if (headless)
+	{
+		// a single image only needs processing (and writing) once
+
+		singleImageInput = ((!replayPath) && (*argc == 2) &&
+							cvHaveImageReader(argv[1]));
+		if (singleImageInput && (frameLimit == 0)) {
+			frameLimit = 1;
+		}
+
+		atexit(release_sinks);
+
+		printf("Running headless : output written to %s_<window>.%s\n",
+				outputPrefix, singleImageInput ? "png" : "avi");
+	}
+}
+
+/******************************************************************************/
+
+bool ipcv_headless()
+{
+	return headless;
+}
+
+/******************************************************************************/
+
+bool ipcv_real_dft()
+{
+	return realDFT;
+}
+
+/******************************************************************************/
+
+int ipcv_template_levels()
+{
+	return templateLevels;
+}
+
+int ipcv_track_margin()
+{
+	return trackMargin;
+}
+
+double ipcv_template_track_threshold()
+{
+	return trackThreshold;
+}
+
+int ipcv_template_engine()
+{
+	return matchEngine;
+}
+
+/******************************************************************************/
+
+const char* ipcv_replay_path()
+{
+	return replayPath;
+}
+
+int ipcv_replay_loops()
+{
+	return replayLoops;
+}
+
+double ipcv_replay_fps()
+{
+	return replayFPS;
+}
+
+/******************************************************************************/
+
+bool ipcv_initial_roi(CvRect* roi, CvSize frame)
+{
+	if (!haveROI) {
+		return false;
+	}
+
+	// the intersection of the ROI and the frame
+
+	int x0 = std::max(initialROI.x, 0);
+	int y0 = std::max(initialROI.y, 0);
+	int x1 = std::min(initialROI.x + initialROI.width, frame.width);
+	int y1 = std::min(initialROI.y + initialROI.height, frame.height);
+
+	if ((x1 <= x0) || (y1 <= y0))
+	{
+		printf("ERROR: --roi %i,%i,%i,%i is outside of the %ix%i frame\n",
+			   initialROI.x, initialROI.y, initialROI.width, initialROI.height,
+			   frame.width, frame.height);
+		exit(1);
+	}
+
+	*roi = cvRect(x0, y0, x1 - x0, y1 - y0);
+	return true;
+}
+
+/******************************************************************************/
+
+int ipcv_named_window(const char* name, int flags)
+{
+	if (!headless) {
+		return cvNamedWindow(name, flags);
+	}
+
+	for (size_t i = 0; i < sinks.size(); i++)
+	{
+		if (sinks[i].name == name) {
+			return 1;
+		}
+	}
+
+	HeadlessSink sink;
+	sink.name = name;
+	sink.index = (int) sinks.size();
+	sink.writer = NULL;
+	sink.scaled = NULL;
+	sink.frame = NULL;
+	sinks.push_back(sink);
+
+	printf("Window \"%s\" -> %s_%i\n", name, outputPrefix, sink.index);
+
+	return 1;
+}
+
+/******************************************************************************/
+
+// convert an image for output as an 8-bit 3 channel frame (following the same
+// depth scaling conventions that cvShowImage() uses for display)
+
+static IplImage* convert_for_output(HeadlessSink& sink, const CvArr* image)
+{
+	IplImage stub;
+	IplImage* img = cvGetImage(image, &stub);
+	CvSize size = cvGetSize(img);
+
+	// (re-)allocate the conversion buffers (video output keeps its first size)
+
+	if ((!sink.frame) || ((!sink.writer) &&
+		((sink.frame->width != size.width) || (sink.frame->height != size.height))))
+	{
+		if (sink.frame) { cvReleaseImage(&(sink.frame)); }
+		sink.frame = cvCreateImage(size, IPL_DEPTH_8U, 3);
+	}
+
+	if ((!sink.scaled) || (sink.scaled->width != size.width) ||
+		(sink.scaled->height != size.height) ||
+		(sink.scaled->nChannels != img->nChannels))
+	{
+		if (sink.scaled) { cvReleaseImage(&(sink.scaled)); }
+		sink.scaled = cvCreateImage(size, IPL_DEPTH_8U, img->nChannels);
+	}
+
+	// scale to 8-bit (floating point images are assumed to be in range 0->1)
+
+	IplImage* img8 = img;
+	if (img->depth != IPL_DEPTH_8U)
+	{
+		double scale = 1.0;
+		if ((img->depth == IPL_DEPTH_32F) || (img->depth == IPL_DEPTH_64F)) {
+			scale = 255.0;
+		} else if ((img->depth & 255) > 8) {
+			scale = 1.0 / 256.0;	// 16-bit (and 32-bit integer) images
+		}
+		cvConvertScale(img, sink.scaled, scale, 0);
+		img8 = sink.scaled;
+	}
+
+	// convert to 3 channel (resizing if a video output size is already fixed)
+
+	IplImage* colour = (size.width == sink.frame->width) &&
+					   (size.height == sink.frame->height) ? sink.frame : NULL;
+	IplImage* tmp = NULL;
+	if (!colour) {
+		tmp = cvCreateImage(size, IPL_DEPTH_8U, 3);
+		colour = tmp;
+	}
+
+	if (img8->nChannels == 1) {
+		cvCvtColor(img8, colour, CV_GRAY2BGR);
+	} else if (img8->nChannels == 4) {
+		cvCvtColor(img8, colour, CV_BGRA2BGR);
+	} else {
+		cvCopy(img8, colour, NULL);
+	}
+
+	if (tmp) {
+		cvResize(tmp, sink.frame, CV_INTER_LINEAR);
+		cvReleaseImage(&tmp);
+	}
+
+	// as for display, images with a bottom-left origin are flipped
+
+	if (img->origin) {
+		cvFlip(sink.frame, NULL, 0);
+	}
+
+	return sink.frame;
+}
+
+/******************************************************************************/
+
+IplImage* ipcv_query_frame(CvCapture* capture)
+{
+	IpcvScopedTimer timer(IPCV_TIMING_CAPTURE);
+
+	return cvQueryFrame(capture);
+}
+
+/******************************************************************************/
+
+void ipcv_show_image(const char* name, const CvArr* image)
+{
+	IpcvScopedTimer timer(IPCV_TIMING_DISPLAY);
+
+	if (!headless) {
+		cvShowImage(name, image);
+		return;
+	}
+
+	if (!image) {
+		return;		// nothing to display yet (e.g. no template selected)
+	}
+
+	// find the sink for this window (creating one if needed)
+
+	size_t i;
+	for (i = 0; i < sinks.size(); i++)
+	{
+		if (sinks[i].name == name) {
+			break;
+		}
+	}
+	if (i == sinks.size()) {
+		ipcv_named_window(name, 0);
+	}
+	HeadlessSink& sink = sinks[i];
+
+	IplImage* frame = convert_for_output(sink, image);
+
+	char filename[1024];
+	if (singleImageInput)
+	{
+		sprintf(filename, "%.1000s_%i.png", outputPrefix, sink.index);
+		cvSaveImage(filename, frame);
+	} else {
+		if (!sink.writer)
+		{
+			sprintf(filename, "%.1000s_%i.avi", outputPrefix, sink.index);
+			sink.writer = cvCreateVideoWriter(filename, CV_FOURCC('M','J','P','G'),
+								HEADLESS_OUTPUT_FPS, cvGetSize(frame), 1);
+			if (!sink.writer) {
+				printf("ERROR: cannot open video writer for %s\n", filename);
+				exit(1);
+			}
+		}
+		cvWriteFrame(sink.writer, frame);
+	}
+}
+
+/******************************************************************************/
+
+int ipcv_create_trackbar(const char* trackbarName, const char* windowName,
+						 int* value, int count, CvTrackbarCallback onChange)
+{
+	// in headless mode parameters simply keep their initial values
+
+	if (!headless) {
+		return cvCreateTrackbar(trackbarName, windowName, value, count, onChange);
+	}
+	return 1;
+}
+
+/******************************************************************************/
+
+void ipcv_set_mouse_callback(const char* windowName, CvMouseCallback onMouse,
+							 void* param)
+{
+	if (!headless) {
+		cvSetMouseCallback(windowName, onMouse, param);
+	}
+}
+
+/******************************************************************************/
+
+int ipcv_wait_key(int delay)
+{
+	frameCount++;
+
+	// the end of each frame (the wait / GUI event processing is not timed)
+
+	ipcv_timing_end_frame();
+
+	if (!headless) {
+
+		// a replay is not paced by the wall clock (only by --replay-fps)
+
+		if (replayPath && (delay > 0)) {
+			delay = 1;
+		}
+
+		int key = cvWaitKey(delay);
+		ipcv_timing_start_frame();
+		return ((frameLimit > 0) && (frameCount >= frameLimit)) ? 'x' : key;
+	}
+
+	ipcv_timing_start_frame();
+
+	// no GUI event processing or frame pacing in headless mode
+
+	return ((frameLimit > 0) && (frameCount >= frameLimit)) ? 'x' : -1;
+}
+
+/******************************************************************************/
+
+void ipcv_destroy_window(const char* name)
+{
+	if (!headless) {
+		cvDestroyWindow(name);
+	}
+}
+
+/******************************************************************************/
+
+void ipcv_destroy_all_windows()
+{
+	if (!headless) {
+		cvDestroyAllWindows();
+	} else {
+		release_sinks();
+	}
+}
+
+/******************************************************************************/
@@ -0,0 +1,123 @@
+// Module : shared command line / display interface for the examples
+// usage: #include "ipcv_interface.h" (link with ipcv_interface.cc)
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: the ipcv_*() display functions below are drop-in replacements for
+// the highgui calls used in the examples (cvNamedWindow, cvShowImage,
+// cvWaitKey ...). By default they simply call highgui, but in headless mode
+// (--headless on the command line) no GUI is used, there is no frame pacing
+// and every displayed image is written to a file sink instead, so the
+// examples can be run as batch jobs on machines without a display.
+
+#ifndef IPCV_INTERFACE_H
+#define IPCV_INTERFACE_H
+
+#include "cv.h"       // open cv general include file
+#include "highgui.h"  // open cv GUI include file
+
+/******************************************************************************/
+
+// process (and remove) the shared command line options from argc / argv so
+// that the existing "argc == 2" input checks of the examples still work
+
+// options:
+// --headless <prefix> - no GUI; output of window i is written to <prefix>_i.avi
+//                       (or <prefix>_i.png if the input is a single image)
+// --frames <N>        - stop after N frames have been processed
+// --real-dft          - (dft examples) use the single precision, real input
+//                       DFT path with filters applied in CCS packed form
+// --pyramid <levels>  - (template matching) search coarse to fine over this
+//                       many image pyramid levels (default 0 = full search)
+// --track <margin>    - (template matching / camshift) search only within
+//                       margin pixels of the previous match / track window -
+//                       the whole frame is searched if the target is lost (for
+//                       template matching, if the best match scores below
+//                       --track-threshold <score>, default 0.9)
+// --match-engine <auto|spatial|fft> - (template matching) correlate with
+//                       cvMatchTemplate(), by FFT or (default) whichever is
+//                       estimated to be faster for the template size
+// --timing <file>     - time each stage of every frame and write a summary
+//                       (CSV, or JSON for a .json file) at exit (see ipcv_timing.h)
+// --replay <path>     - replay a directory of images, a raw frame file or a
+//                       video file from memory in place of the usual input
+//                       (see ipcv_frame_source.h), with no frame pacing -
+//                       only for the examples that read their input through
+//                       create_input_frame_source() (which pass
+//                       IPCV_REPLAY_INPUT), any other exits with an error
+// --replay-fps <fps>  - replay at a simulated camera frame rate (default 0 =
+//                       as fast as the example processes the frames)
+// --loops <N>         - replay the frames N times (default 1, 0 = forever)
+// --roi <x,y,w,h>     - initial selection for the examples that normally
+//                       take one with the mouse (camshift / template matching)
+//                       - clipped to the first frame
+
+// flags - IPCV_REPLAY_INPUT if the example reads its input through
+//         create_input_frame_source() (and so supports --replay), else 0
+
+#define IPCV_REPLAY_INPUT 1
+
+void ipcv_parse_options(int* argc, char** argv, int flags = 0);
+
+// return true if running in headless (batch) mode
+
+bool ipcv_headless();
+
+// return true if the real input (CCS packed) DFT path has been selected
+
+bool ipcv_real_dft();
+
+// return the number of pyramid levels selected for template matching
+
+int ipcv_template_levels();
+
+// return the tracking margin (0 = no tracking) and the template matching
+// tracking score threshold
+
+int ipcv_track_margin();
+double ipcv_template_track_threshold();
+
+// return the template matching engine (IPCV_TEMPLATE_*, see ipcv_template.h)
+
+int ipcv_template_engine();
+
+// replay settings - path (NULL if --replay has not been given), loops, fps
+
+const char* ipcv_replay_path();
+int ipcv_replay_loops();
+double ipcv_replay_fps();
+
+// return true (and the selection in *roi) if an initial ROI has been given -
+// clipped to a frame of the given size (an ROI entirely outside the frame is
+// an error, and exits)
+
+bool ipcv_initial_roi(CvRect* roi, CvSize frame);
+
+/******************************************************************************/
+
+// highgui replacements (headless aware)
+
+int ipcv_named_window(const char* name, int flags = 1);
+void ipcv_show_image(const char* name, const CvArr* image);
+int ipcv_create_trackbar(const char* trackbarName, const char* windowName,
+						 int* value, int count, CvTrackbarCallback onChange = NULL);
+void ipcv_set_mouse_callback(const char* windowName, CvMouseCallback onMouse,
+							 void* param = NULL);
+void ipcv_destroy_window(const char* name);
+void ipcv_destroy_all_windows();
+
+// get the next frame from a capture object (as cvQueryFrame), timed as the
+// capture stage (see ipcv_timing.h) - for the examples that read their
+// capture object directly rather than through a frame source
+
+IplImage* ipcv_query_frame(CvCapture* capture);
+
+// wait for a key press for delay ms (as cvWaitKey) - in headless mode this
+// returns immediately (no frame pacing) with -1, or with 'x' once the --frames
+// limit (or the end of a single image input) has been reached
+
+int ipcv_wait_key(int delay = 0);
+
+/******************************************************************************/
+
+#endif
@@ -0,0 +1,90 @@
+// Module : 256-entry lookup table (LUT) point transforms for 8-bit images
+// usage: see ipcv_lut.h
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+#include "ipcv_lut.h"
+
+#include <math.h>
+#include <algorithm>
+
+/******************************************************************************/
+
+PointTransformLUT* create_point_transform_lut(PointTransform transform, int nParams)
+{
+	PointTransformLUT* lut = new PointTransformLUT;
+
+	lut->transform = transform;
+	lut->nParams = std::min(std::max(nParams, 0), IPCV_LUT_MAX_PARAMS);
+	for (int i = 0; i < IPCV_LUT_MAX_PARAMS; i++) {
+		lut->params[i] = 0;
+	}
+	lut->built = 0;
+	lut->header = cvMat(1, 256, CV_8UC1, lut->table);
+
+	return lut;
+}
+
+/******************************************************************************/
+
+int update_point_transform_lut(PointTransformLUT* lut, const double* params)
+{
+	// nothing to do if the table already matches
+
+	int changed = !(lut->built);
+	for (int i = 0; i < lut->nParams; i++)
+	{
+		if (lut->params[i] != params[i]) {
+			changed = 1;
+		}
+	}
+	if (!changed) {
+		return 0;
+	}
+
+	// evaluate the transform once for each of the 256 possible input values
+
+	for (int i = 0; i < lut->nParams; i++) {
+		lut->params[i] = params[i];
+	}
+	for (int value = 0; value < 256; value++) {
+		lut->table[value] = (uchar) lut->transform(value, lut->params);
+	}
+	lut->built = 1;
+
+	return 1;
+}
+
+/******************************************************************************/
+
+void apply_point_transform_lut(PointTransformLUT* lut, const CvArr* src, CvArr* dst)
+{
+	cvLUT(src, dst, &(lut->header));
+}
+
+/******************************************************************************/
+
+void release_point_transform_lut(PointTransformLUT** lut)
+{
+	if ((lut) && (*lut))
+	{
+		delete *lut;
+		*lut = NULL;
+	}
+}
+
+/******************************************************************************/
+
+double exponential_transform(int value, const double* params)
+{
+	return params[0] * (pow((1 + params[1]), value) - 1);
+}
+
+/******************************************************************************/
+
+double logarithmic_transform(int value, const double* params)
+{
+	return params[0] * log(1 + ((exp(params[1]) - 1) * value));
+}
+
+/******************************************************************************/
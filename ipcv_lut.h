@@ -0,0 +1,79 @@
+// Module : 256-entry lookup table (LUT) point transforms for 8-bit images
+// usage: #include "ipcv_lut.h" (link with the ipcv library)
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: an 8-bit image has only 256 possible input values, so any point
+// transform (exponential, logarithmic, thresholding, contrast stretching ...)
+// can be evaluated once per value into a table, rebuilt only when the
+// transform parameters change, and then applied to the image with a single
+// row-major table lookup pass (cvLUT) rather than per pixel pow() / log() calls
+
+#ifndef IPCV_LUT_H
+#define IPCV_LUT_H
+
+#include "cv.h"       // open cv general include file
+
+/******************************************************************************/
+
+// maximum number of parameters of a point transform
+
+#define IPCV_LUT_MAX_PARAMS 4
+
+// point transform function - returns the output for the 8-bit input value
+// given the parameters (the result is converted to 8-bit as for assignment
+// to a uchar, as in the original per pixel examples)
+
+typedef double (*PointTransform)(int value, const double* params);
+
+// lookup table for a point transform (and the parameters it was built with)
+
+typedef struct PointTransformLUT
+{
+	PointTransform transform;			// transform function
+	int nParams;						// number of parameters it takes
+	double params[IPCV_LUT_MAX_PARAMS];	// parameters of the current table
+	int built;							// table has been built (> 0)
+	uchar table[256];					// output value for each input value
+	CvMat header;						// 1 x 256 matrix header for table
+} PointTransformLUT;
+
+/******************************************************************************/
+
+// create a lookup table for a point transform with nParams parameters
+
+PointTransformLUT* create_point_transform_lut(PointTransform transform, int nParams);
+
+// make sure the table matches the parameters given, rebuilding it only if
+// they differ from those it was last built with
+
+// return value - 1 if the table was rebuilt, 0 otherwise
+
+int update_point_transform_lut(PointTransformLUT* lut, const double* params);
+
+// apply the table to an 8-bit image (src and dst may be the same, any number
+// of channels - each is transformed in the same way)
+
+void apply_point_transform_lut(PointTransformLUT* lut, const CvArr* src, CvArr* dst);
+
+// release the lookup table
+
+void release_point_transform_lut(PointTransformLUT** lut);
+
+/******************************************************************************/
+
+// point transforms of the examples (as per formula in lecture 8)
+
+// exponential.cc: constant * ((1 + alpha)^value - 1)
+// params - {constant, alpha}
+
+double exponential_transform(int value, const double* params);
+
+// logarithmic.cc: constant * log(1 + ((e^omega - 1) * value))
+// params - {constant, omega}
+
+double logarithmic_transform(int value, const double* params);
+
+/******************************************************************************/
+
+#endif
@@ -0,0 +1,387 @@
+// Module : incremental (streaming) PCA model of images for the eigen image
+//          based recognition example
+// usage: see ipcv_pca.h
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+#include "ipcv_pca.h"
+
+#include <math.h>
+#include <float.h>
+#include <algorithm> // contains max() function (amongst others)
+
+/******************************************************************************/
+
+struct IncrementalPCA
+{
+	int dims;					// values (pixels) per sample
+	int components;				// eigenvectors kept (at most)
+	int block;					// samples per update (at most)
+	int count;					// samples in the model
+	int k;						// eigenvectors in use
+	CvMat* mean;				// mean sample (1 x dims)
+	CvMat* basis;				// eigenvectors (components x dims, first k in use)
+	CvMat view;					// (header of the first k rows of basis)
+	std::vector<float> sigma;	// singular value of each eigenvector
+	std::vector<float> coeffs;	// coefficients, one row of components per sample
+};
+
+/******************************************************************************/
+
+IncrementalPCA* create_incremental_pca(int dims, int components, int block)
+{
+	IncrementalPCA* pca = new IncrementalPCA;
+
+	pca->dims = dims;
+	pca->components = std::max(components, 1);
+	pca->block = std::max(block, 1);
+	pca->count = 0;
+	pca->k = 0;
+	pca->mean = cvCreateMat(1, dims, CV_32FC1);
+	pca->basis = cvCreateMat(pca->components, dims, CV_32FC1);
+	pca->sigma.assign(pca->components, 0.f);
+
+	cvZero(pca->mean);
+
+	return pca;
+}
+
+/******************************************************************************/
+
+// copy a (single channel, 8-bit) image into a row of floats (row by row, so
+// any padding at the end of each image row is skipped)
+
+static void image_row(const IplImage* img, float* row)
+{
+	for (int y = 0; y < img->height; y++)
+	{
+		const uchar* p = (const uchar*) (img->imageData + (y * img->widthStep));
+		for (int x = 0; x < img->width; x++) {
+			*row++ = p[x];
+		}
+	}
+}
+
+// is the image a sample of the model (single channel, 8-bit, of dims pixels)
+
+static bool valid_image(const IncrementalPCA* pca, const IplImage* img)
+{
+	return (img) && (img->nChannels == 1) && (img->depth == IPL_DEPTH_8U) &&
+		   ((img->width * img->height) == pca->dims);
+}
+
+/******************************************************************************/
+
+// update the model with a block of samples (one per row, modified)
+
+static void update_block(IncrementalPCA* pca, CvMat* samples)
+{
+	int d = pca->dims;
+	int m = samples->rows;
+	int n = pca->count;
+	int k = pca->k;
+	int r = k + m + ((n > 0) ? 1 : 0);
+
+	// mean of the block and the new mean of the model
+
+	std::vector<float> blockMean(d, 0.f);
+	for (int j = 0; j < m; j++)
+	{
+		const float* x = (const float*) (samples->data.ptr + (j * samples->step));
+		for (int i = 0; i < d; i++) {
+			blockMean[i] += x[i];
+		}
+	}
+	for (int i = 0; i < d; i++) {
+		blockMean[i] /= m;
+	}
+
+	std::vector<float> oldMean(pca->mean->data.fl, pca->mean->data.fl + d);
+	float* mean = pca->mean->data.fl;
+	for (int i = 0; i < d; i++) {
+		mean[i] = (float) (((n * (double) oldMean[i]) + (m * (double) blockMean[i])) / (n + m));
+	}
+
+	// stack the old basis (scaled by its singular values), the block (less
+	// its mean) and the shift of the mean (weighted) as the rows of A
+
+	CvMat* A = cvCreateMat(r, d, CV_32FC1);
+
+	for (int j = 0; j < k; j++)
+	{
+		const float* u = (const float*) (pca->basis->data.ptr + (j * pca->basis->step));
+		float* a = (float*) (A->data.ptr + (j * A->step));
+		for (int i = 0; i < d; i++) {
+			a[i] = pca->sigma[j] * u[i];
+		}
+	}
+	for (int j = 0; j < m; j++)
+	{
+		const float* x = (const float*) (samples->data.ptr + (j * samples->step));
+		float* a = (float*) (A->data.ptr + ((k + j) * A->step));
+		for (int i = 0; i < d; i++) {
+			a[i] = x[i] - blockMean[i];
+		}
+	}
+	if (n > 0)
+	{
+		float w = (float) sqrt(((double) n * m) / (n + m));
+		float* a = (float*) (A->data.ptr + ((r - 1) * A->step));
+		for (int i = 0; i < d; i++) {
+			a[i] = w * (blockMean[i] - oldMean[i]);
+		}
+	}
+
+	// the SVD of A from the eigen decomposition of its Gram matrix A A^T
+	// (eigenvalues in descending order) - the new eigenvectors are the rows
+	// of V^T A scaled by the reciprocal of each singular value
+
+	CvMat* gram = cvCreateMat(r, r, CV_32FC1);
+	CvMat* gram64 = cvCreateMat(r, r, CV_64FC1);
+	CvMat* evects = cvCreateMat(r, r, CV_64FC1);
+	CvMat* evals = cvCreateMat(r, 1, CV_64FC1);
+
+	cvMulTransposed(A, gram, 0);
+	cvConvert(gram, gram64);
+	cvEigenVV(gram64, evects, evals);
+
+	double tolerance = std::max(evals->data.db[0], 0.) * r * FLT_EPSILON;
+	int knew = 0;
+	while ((knew < std::min(r, pca->components)) &&
+		   (evals->data.db[knew] > tolerance) && (evals->data.db[knew] > 0)) {
+		knew++;
+	}
+
+	CvMat* basis = NULL;
+	if (knew > 0)
+	{
+		CvMat* v = cvCreateMat(knew, r, CV_32FC1);
+		for (int j = 0; j < knew; j++)
+		{
+			double scale = 1. / sqrt(evals->data.db[j]);
+			for (int i = 0; i < r; i++) {
+				CV_MAT_ELEM(*v, float, j, i) =
+					(float) (CV_MAT_ELEM(*evects, double, j, i) * scale);
+			}
+		}
+		basis = cvCreateMat(knew, d, CV_32FC1);
+		cvGEMM(v, A, 1, NULL, 0, basis, 0);
+		cvReleaseMat(&v);
+	}
+
+	// carry the coefficients of the existing samples over to the new basis,
+	// c' = (U' U^T) c + U' (mean - mean'), and project the new samples
+
+	int nc = pca->components;
+	std::vector<float> coeffs((size_t) (n + m) * nc, 0.f);
+
+	if ((n > 0) && (knew > 0))
+	{
+		std::vector<float> shift(d);
+		for (int i = 0; i < d; i++) {
+			shift[i] = oldMean[i] - mean[i];
+		}
+		std::vector<float> offset(knew);
+		for (int a = 0; a < knew; a++)
+		{
+			const float* u = (const float*) (basis->data.ptr + (a * basis->step));
+			float s = 0;
+			for (int i = 0; i < d; i++) {
+				s += u[i] * shift[i];
+			}
+			offset[a] = s;
+		}
+
+		CvMat* transform = NULL;
+		if (k > 0)
+		{
+			CvMat old;
+			cvGetRows(pca->basis, &old, 0, k);
+			transform = cvCreateMat(knew, k, CV_32FC1);
+			cvGEMM(basis, &old, 1, NULL, 0, transform, CV_GEMM_B_T);
+		}
+
+		for (int s = 0; s < n; s++)
+		{
+			const float* c = &(pca->coeffs[(size_t) s * nc]);
+			float* c2 = &(coeffs[(size_t) s * nc]);
+			for (int a = 0; a < knew; a++)
+			{
+				float v = offset[a];
+				for (int b = 0; b < k; b++) {
+					v += CV_MAT_ELEM(*transform, float, a, b) * c[b];
+				}
+				c2[a] = v;
+			}
+		}
+		cvReleaseMat(&transform);
+	}
+
+	if (knew > 0)
+	{
+		for (int j = 0; j < m; j++)
+		{
+			float* x = (float*) (samples->data.ptr + (j * samples->step));
+			for (int i = 0; i < d; i++) {
+				x[i] -= mean[i];
+			}
+		}
+		CvMat* projected = cvCreateMat(m, knew, CV_32FC1);
+		cvGEMM(samples, basis, 1, NULL, 0, projected, CV_GEMM_B_T);
+		for (int j = 0; j < m; j++) {
+			for (int a = 0; a < knew; a++) {
+				coeffs[(size_t) (n + j) * nc + a] = CV_MAT_ELEM(*projected, float, j, a);
+			}
+		}
+		cvReleaseMat(&projected);
+
+		CvMat rows;
+		cvGetRows(pca->basis, &rows, 0, knew);
+		cvCopy(basis, &rows, NULL);
+		cvGetRows(pca->basis, &(pca->view), 0, knew);
+	}
+
+	for (int j = 0; j < nc; j++) {
+		pca->sigma[j] = (j < knew) ? (float) sqrt(evals->data.db[j]) : 0.f;
+	}
+	pca->coeffs.swap(coeffs);
+	pca->k = knew;
+	pca->count = n + m;
+
+	cvReleaseMat(&basis);
+	cvReleaseMat(&evals);
+	cvReleaseMat(&evects);
+	cvReleaseMat(&gram64);
+	cvReleaseMat(&gram);
+	cvReleaseMat(&A);
+}
+
+/******************************************************************************/
+
+int add_pca_images(IncrementalPCA* pca, IplImage* const* images, int count)
+{
+	for (int i = 0; i < count; i++) {
+		if (!valid_image(pca, images[i])) {
+			return -1;
+		}
+	}
+
+	// update the model a block of samples at a time
+
+	int first = pca->count;
+	CvMat* samples = cvCreateMat(std::min(std::max(count, 1), pca->block),
+								 pca->dims, CV_32FC1);
+
+	for (int start = 0; start < count; start += pca->block)
+	{
+		int m = std::min(pca->block, count - start);
+		CvMat block;
+		cvGetRows(samples, &block, 0, m);
+		for (int j = 0; j < m; j++) {
+			image_row(images[start + j],
+					  (float*) (block.data.ptr + (j * block.step)));
+		}
+		update_block(pca, &block);
+	}
+	cvReleaseMat(&samples);
+
+	return first;
+}
+
+/******************************************************************************/
+
+int pca_sample_count(const IncrementalPCA* pca)
+{
+	return pca->count;
+}
+
+int pca_components(const IncrementalPCA* pca)
+{
+	return pca->k;
+}
+
+/******************************************************************************/
+
+void project_pca_image(const IncrementalPCA* pca, const IplImage* img,
+					   std::vector<float>* coeffs)
+{
+	int d = pca->dims;
+	std::vector<float> row(d);
+
+	coeffs->assign(pca->k, 0.f);
+	if (!valid_image(pca, img)) {
+		return;
+	}
+
+	image_row(img, &(row[0]));
+	const float* mean = pca->mean->data.fl;
+	for (int i = 0; i < d; i++) {
+		row[i] -= mean[i];
+	}
+	for (int a = 0; a < pca->k; a++)
+	{
+		const float* u = (const float*) (pca->basis->data.ptr + (a * pca->basis->step));
+		float s = 0;
+		for (int i = 0; i < d; i++) {
+			s += u[i] * row[i];
+		}
+		(*coeffs)[a] = s;
+	}
+}
+
+/******************************************************************************/
+
+int nearest_pca_sample(const IncrementalPCA* pca, const IplImage* img,
+					   double* distance)
+{
+	std::vector<float> q;
+	project_pca_image(pca, img, &q);
+
+	int closest = -1;
+	double closestDistance = DBL_MAX;
+	for (int s = 0; s < pca->count; s++)
+	{
+		const float* c = &(pca->coeffs[(size_t) s * pca->components]);
+		double diff = 0;
+		for (int a = 0; a < pca->k; a++) {
+			diff += fabs(c[a] - q[a]);
+		}
+		if (diff < closestDistance)
+		{
+			closestDistance = diff;
+			closest = s;
+		}
+	}
+
+	if ((distance) && (closest >= 0)) {
+		*distance = closestDistance;
+	}
+	return closest;
+}
+
+/******************************************************************************/
+
+const CvMat* pca_mean(const IncrementalPCA* pca)
+{
+	return pca->mean;
+}
+
+const CvMat* pca_eigenvectors(const IncrementalPCA* pca)
+{
+	return (pca->k > 0) ? &(pca->view) : NULL;
+}
+
+/******************************************************************************/
+
+void release_incremental_pca(IncrementalPCA** pca)
+{
+	if ((pca) && (*pca))
+	{
+		cvReleaseMat(&((*pca)->mean));
+		cvReleaseMat(&((*pca)->basis));
+		delete *pca;
+		*pca = NULL;
+	}
+}
+
+/******************************************************************************/
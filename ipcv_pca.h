@@ -0,0 +1,85 @@
+// Module : incremental (streaming) PCA model of images for the eigen image
+//          based recognition example
+// usage: #include "ipcv_pca.h" (link with the ipcv library)
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: rather than cvCalcPCA() over every sample at once, the model holds
+// only the mean, the first (truncated) eigenvectors and their singular values
+// and is updated by each new block of samples (the sequential Karhunen-Loeve
+// update): the old basis (scaled by its singular values), the new samples
+// (less their mean) and the shift of the mean are stacked as the rows of one
+// small matrix whose SVD - found from its (rows x rows) Gram matrix - gives
+// the new mean and basis. An update costs O((components + block)^2 * pixels)
+// whatever the number of samples already in the model, and a large set of
+// samples is added block by block (a truncated solver, linear in the number
+// of samples) rather than as one (samples x samples) problem.
+
+// The coefficients of the samples already in the model are carried over to
+// each new basis by a (components x components) transform rather than by
+// projecting the samples again (so the sample images are not needed).
+
+#ifndef IPCV_PCA_H
+#define IPCV_PCA_H
+
+#include "cv.h"       // open cv general include file
+
+#include <vector>
+
+/******************************************************************************/
+
+#define IPCV_PCA_BLOCK 16	// samples per model update (default)
+
+typedef struct IncrementalPCA IncrementalPCA;
+
+/******************************************************************************/
+
+// create an (empty) model
+
+// dims - number of values (pixels) per sample
+// components - number of eigenvectors (at most) kept by the model
+// block - number of samples (at most) per model update
+// return value - pointer to model
+
+IncrementalPCA* create_incremental_pca(int dims, int components,
+									   int block = IPCV_PCA_BLOCK);
+
+// add sample images (single channel, of dims pixels) to the model, updating
+// the mean, the eigenvectors and the coefficients of every sample
+// return value - index of the first sample added, or -1 if the sizes differ
+
+int add_pca_images(IncrementalPCA* pca, IplImage* const* images, int count);
+
+// number of samples / eigenvectors (in use) of the model
+
+int pca_sample_count(const IncrementalPCA* pca);
+int pca_components(const IncrementalPCA* pca);
+
+// project an image (single channel, of dims pixels) into the eigen space
+// coeffs - returned coefficients (pca_components() values)
+
+void project_pca_image(const IncrementalPCA* pca, const IplImage* img,
+					   std::vector<float>* coeffs);
+
+// find the sample closest to an image (by the L1 distance of coefficients)
+
+// distance - if not NULL, returned distance
+// return value - index of the closest sample, or -1 if the model is empty
+
+int nearest_pca_sample(const IncrementalPCA* pca, const IplImage* img,
+					   double* distance);
+
+// the mean (1 x dims) and eigenvectors (components x dims, one per row) of
+// the model (32-bit float - no eigenvectors, NULL, until the model has
+// samples that differ)
+
+const CvMat* pca_mean(const IncrementalPCA* pca);
+const CvMat* pca_eigenvectors(const IncrementalPCA* pca);
+
+// release the model
+
+void release_incremental_pca(IncrementalPCA** pca);
+
+/******************************************************************************/
+
+#endif
@@ -0,0 +1,289 @@
+// Module : raw (uncompressed) frame container for repeated runs over footage
+// usage: see ipcv_raw_frames.h
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+#include "ipcv_raw_frames.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <algorithm> // contains min() function (amongst others)
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+/******************************************************************************/
+
+// round up to a multiple of IPCV_RAW_ALIGN
+
+static int64_t raw_align(int64_t n)
+{
+	return ((n + IPCV_RAW_ALIGN - 1) / IPCV_RAW_ALIGN) * IPCV_RAW_ALIGN;
+}
+
+/******************************************************************************/
+
+struct RawFrameWriter
+{
+	FILE* file;
+	RawFrameHeader header;
+	std::vector<uchar> buffer;	// one frame in the file layout (inc. padding)
+	IplImage* planes[4];		// channels of a frame (planar layout only)
+};
+
+/******************************************************************************/
+
+RawFrameWriter* create_raw_frame_writer(const char* filename, CvSize size,
+										int depth, int channels, int origin,
+										int layout)
+{
+	FILE* file = fopen(filename, "wb");
+	if (!file) {
+		return NULL;
+	}
+
+	RawFrameWriter* writer = new RawFrameWriter;
+	RawFrameHeader& h = writer->header;
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, IPCV_RAW_MAGIC, 8);
+	h.width = size.width;
+	h.height = size.height;
+	h.channels = channels;
+	h.depth = depth;
+	h.origin = origin;
+	h.layout = layout;
+
+	// rows aligned to 4 bytes (as the default IplImage widthStep) so that a
+	// mapped frame can be used directly as an image
+
+	int bytesPerValue = (depth & 255) / 8;
+	int rowValues = (layout == IPCV_RAW_PLANAR) ? size.width : size.width * channels;
+	h.step = (((rowValues * bytesPerValue) + 3) / 4) * 4;
+
+	int64_t dataSize = ((int64_t) h.step) * size.height *
+						((layout == IPCV_RAW_PLANAR) ? channels : 1);
+	h.frameSize = raw_align(dataSize);
+	h.dataOffset = raw_align(sizeof(RawFrameHeader));
+	h.frameCount = 0;
+
+	writer->file = file;
+	writer->buffer.assign((size_t) h.frameSize, 0);
+	for (int c = 0; c < 4; c++)
+	{
+		writer->planes[c] = ((layout == IPCV_RAW_PLANAR) && (c < channels)) ?
+							cvCreateImage(size, depth, 1) : NULL;
+	}
+
+	// header (frame count is filled in on release) padded to the first frame
+
+	std::vector<uchar> headerPage((size_t) h.dataOffset, 0);
+	memcpy(&(headerPage[0]), &h, sizeof(h));
+	fwrite(&(headerPage[0]), 1, headerPage.size(), file);
+
+	return writer;
+}
+
+/******************************************************************************/
+
+int write_raw_frame(RawFrameWriter* writer, const IplImage* frame)
+{
+	RawFrameHeader& h = writer->header;
+
+	if ((frame->width != h.width) || (frame->height != h.height) ||
+		(frame->depth != h.depth) || (frame->nChannels != h.channels)) {
+		return 0;
+	}
+
+	uchar* out = &(writer->buffer[0]);
+
+	if (h.layout == IPCV_RAW_PLANAR)
+	{
+		IplImage** p = writer->planes;
+		if (h.channels == 1) {
+			cvCopy(frame, p[0], NULL);
+		} else {
+			cvSplit(frame, p[0], p[1], p[2], p[3]);
+		}
+		for (int c = 0; c < h.channels; c++)
+		{
+			for (int y = 0; y < h.height; y++)
+			{
+				memcpy(out + (((int64_t) (c * h.height) + y) * h.step),
+					   p[c]->imageData + (y * p[c]->widthStep), h.step);
+			}
+		}
+	} else {
+		int rowBytes = std::min(h.step, frame->widthStep);
+		for (int y = 0; y < h.height; y++)
+		{
+			memcpy(out + ((int64_t) y * h.step),
+				   frame->imageData + (y * frame->widthStep), rowBytes);
+		}
+	}
+
+	if (fwrite(out, 1, (size_t) h.frameSize, writer->file) != (size_t) h.frameSize) {
+		return 0;
+	}
+	h.frameCount++;
+	return 1;
+}
+
+/******************************************************************************/
+
+void release_raw_frame_writer(RawFrameWriter** writer)
+{
+	if ((writer) && (*writer))
+	{
+		fseek((*writer)->file, 0, SEEK_SET);
+		fwrite(&((*writer)->header), 1, sizeof(RawFrameHeader), (*writer)->file);
+		fclose((*writer)->file);
+		for (int c = 0; c < 4; c++)
+		{
+			if ((*writer)->planes[c]) {
+				cvReleaseImage(&((*writer)->planes[c]));
+			}
+		}
+		delete *writer;
+		*writer = NULL;
+	}
+}
+
+/******************************************************************************/
+
+bool is_raw_frame_file(const char* filename)
+{
+	char magic[8];
+	FILE* file = fopen(filename, "rb");
+	if (!file) {
+		return false;
+	}
+	bool raw = ((fread(magic, 1, 8, file) == 8) && (!memcmp(magic, IPCV_RAW_MAGIC, 8)));
+	fclose(file);
+	return raw;
+}
+
+/******************************************************************************/
+
+// check that the header describes frames that fit within frameSize and a file
+// of the given size (so no frame can be read beyond the mapping), guarding
+// each multiplication against overflow
+
+static bool valid_raw_header(const RawFrameHeader& h, int64_t fileSize)
+{
+	int bytesPerValue = (h.depth & 255) / 8;
+
+	if ((h.width <= 0) || (h.height <= 0) || (h.channels < 1) || (h.channels > 4) ||
+		((bytesPerValue != 1) && (bytesPerValue != 2) && (bytesPerValue != 4) &&
+		 (bytesPerValue != 8)) ||
+		((h.layout != IPCV_RAW_INTERLEAVED) && (h.layout != IPCV_RAW_PLANAR)) ||
+		(h.frameCount < 0) || (h.frameSize <= 0) ||
+		(h.dataOffset < (int64_t) sizeof(RawFrameHeader)) || (h.dataOffset > fileSize)) {
+		return false;
+	}
+
+	int64_t rowValues = (h.layout == IPCV_RAW_PLANAR) ? (int64_t) h.width :
+						(int64_t) h.width * h.channels;
+	int64_t planes = (h.layout == IPCV_RAW_PLANAR) ? h.channels : 1;
+
+	if ((h.step < rowValues * bytesPerValue) ||
+		((int64_t) h.step * h.height > h.frameSize / planes)) {
+		return false;	// (step * height * planes > frameSize)
+	}
+	return (h.frameCount <= (fileSize - h.dataOffset) / h.frameSize);
+}
+
+/******************************************************************************/
+
+const RawFrameHeader* map_raw_frame_file(const char* filename)
+{
+#ifdef _WIN32
+	printf("ERROR: raw frame files need mmap() (not available on windows)\n");
+	return NULL;
+#else
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	// check the header before mapping the header and frames
+
+	RawFrameHeader header;
+	struct stat st;
+	if ((read(fd, &header, sizeof(header)) != (ssize_t) sizeof(header)) ||
+		(memcmp(header.magic, IPCV_RAW_MAGIC, 8)) || (fstat(fd, &st) != 0) ||
+		(!valid_raw_header(header, (int64_t) st.st_size)))
+	{
+		printf("ERROR: %s is not a (complete) raw frame file\n", filename);
+		close(fd);
+		return NULL;
+	}
+	size_t length = (size_t) (header.dataOffset +
+							  (header.frameCount * header.frameSize));
+
+	// a private writable mapping - frames can be drawn on (as frames from
+	// cvQueryFrame() often are) with the changes never reaching the file (and
+	// the private copies of pages this makes are dropped by release_raw_frame)
+
+	void* map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		return NULL;
+	}
+
+	// frames are (normally) read in order
+
+	madvise(map, length, MADV_SEQUENTIAL);
+
+	return (const RawFrameHeader*) map;
+#endif
+}
+
+/******************************************************************************/
+
+const uchar* raw_frame_data(const RawFrameHeader* file, int64_t i)
+{
+	return ((const uchar*) file) + file->dataOffset + (i * file->frameSize);
+}
+
+/******************************************************************************/
+
+void release_raw_frame(const RawFrameHeader* file, int64_t i)
+{
+#ifndef _WIN32
+
+	// the whole pages the frame touches (any part of the next frame this
+	// includes has not yet been used, so simply reverts to the file)
+
+	int64_t page = sysconf(_SC_PAGESIZE);
+	int64_t start = file->dataOffset + (i * file->frameSize);
+	int64_t end = start + file->frameSize;
+	start = (start / page) * page;
+	end = std::min(((end + page - 1) / page) * page,
+				   file->dataOffset + (file->frameCount * file->frameSize));
+	if (end > start) {
+		madvise((uchar*) file + start, (size_t) (end - start), MADV_DONTNEED);
+	}
+#endif
+}
+
+/******************************************************************************/
+
+void unmap_raw_frame_file(const RawFrameHeader** file)
+{
+#ifndef _WIN32
+	if ((file) && (*file))
+	{
+		munmap((void*) *file, (size_t) ((*file)->dataOffset +
+				((*file)->frameCount * (*file)->frameSize)));
+		*file = NULL;
+	}
+#endif
+}
+
+/******************************************************************************/
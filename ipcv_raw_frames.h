@@ -0,0 +1,104 @@
+// Module : raw (uncompressed) frame container for repeated runs over footage
+// usage: #include "ipcv_raw_frames.h" (link with the ipcv library)
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: a raw frame file is a small fixed header (see RawFrameHeader) padded
+// to one page, followed by the frames as uncompressed image rows (each frame
+// starting on a page boundary). It is read through mmap() so a frame is just
+// an IplImage header over the mapped pages (no decode and no copy) - decode
+// a video once with raw_convert (raw_convert.cc) and every later run reads it
+// at memory speed. (N.B. values are stored in the byte order of the machine
+// that wrote the file; reading requires a POSIX system, i.e. not windows)
+
+#ifndef IPCV_RAW_FRAMES_H
+#define IPCV_RAW_FRAMES_H
+
+#include "cv.h"       // open cv general include file
+
+#include <stdint.h>
+
+/******************************************************************************/
+
+#define IPCV_RAW_MAGIC "IPCVRAW1"	// first 8 bytes of every raw frame file
+#define IPCV_RAW_ALIGN 4096			// alignment of header / frames (bytes)
+
+// frame layouts - interleaved (as IplImage, BGRBGR...) or planar (all of the
+// first channel, then all of the second ...)
+
+#define IPCV_RAW_INTERLEAVED 0
+#define IPCV_RAW_PLANAR 1
+
+// file header
+
+typedef struct RawFrameHeader
+{
+	char magic[8];			// IPCV_RAW_MAGIC
+	int32_t width;			// frame width
+	int32_t height;			// frame height
+	int32_t channels;		// number of channels
+	int32_t depth;			// IplImage depth (IPL_DEPTH_8U ...)
+	int32_t origin;			// IplImage origin (0 = top left)
+	int32_t layout;			// IPCV_RAW_{INTERLEAVED | PLANAR}
+	int32_t step;			// bytes per row (of a frame or plane)
+	int32_t reserved;
+	int64_t frameCount;		// number of frames
+	int64_t frameSize;		// bytes per frame (inc. padding to IPCV_RAW_ALIGN)
+	int64_t dataOffset;		// offset of the first frame in the file
+} RawFrameHeader;
+
+/******************************************************************************/
+
+// writing (frames are written interleaved unless a planar layout is asked for)
+
+typedef struct RawFrameWriter RawFrameWriter;
+
+// create a raw frame file for frames of the given size / depth / channels
+
+RawFrameWriter* create_raw_frame_writer(const char* filename, CvSize size,
+										int depth, int channels, int origin = 0,
+										int layout = IPCV_RAW_INTERLEAVED);
+
+// append a frame (which must match the size / depth / channels of the file)
+// return value - 1 on success, 0 on failure
+
+int write_raw_frame(RawFrameWriter* writer, const IplImage* frame);
+
+// complete the file (the frame count is written to the header) and release
+
+void release_raw_frame_writer(RawFrameWriter** writer);
+
+/******************************************************************************/
+
+// reading
+
+// return true if the named file is a raw frame file (by its header)
+
+bool is_raw_frame_file(const char* filename);
+
+// map a raw frame file into memory
+
+// return value - pointer to the (read only) header of the mapped file, or
+//                NULL if it cannot be opened / is not a raw frame file
+
+const RawFrameHeader* map_raw_frame_file(const char* filename);
+
+// return a pointer to the data of frame i of a mapped file
+
+const uchar* raw_frame_data(const RawFrameHeader* file, int64_t i);
+
+// release frame i of a mapped file once it is no longer in use - any changes
+// made to it (e.g. drawing) are discarded and the memory they took is freed,
+// so playing a long file does not accumulate private copies of its frames
+// (N.B. this includes the start of frame i + 1 if it shares a page with the
+// end of frame i, so frames must be released in order, after their use)
+
+void release_raw_frame(const RawFrameHeader* file, int64_t i);
+
+// unmap a raw frame file
+
+void unmap_raw_frame_file(const RawFrameHeader** file);
+
+/******************************************************************************/
+
+#endif
@@ -0,0 +1,448 @@
+// Module : uniform "process(frame) -> frame" processing stages
+// usage: see ipcv_stage.h
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+#include "ipcv_stage.h"
+#include "ipcv_dft.h"
+#include "ipcv_lut.h"
+#include "ipcv_timing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <algorithm> // contains max() function (amongst others)
+
+/******************************************************************************/
+
+IplImage* ProcessingStage::reuse_image(IplImage** buffer, CvSize size,
+									   int depth, int channels, int origin)
+{
+	if ((*buffer) && (((*buffer)->width != size.width) ||
+		((*buffer)->height != size.height) || ((*buffer)->depth != depth) ||
+		((*buffer)->nChannels != channels)))
+	{
+		cvReleaseImage(buffer);
+	}
+	if (!(*buffer)) {
+		*buffer = cvCreateImage(size, depth, channels);
+	}
+	(*buffer)->origin = origin;
+	return *buffer;
+}
+
+/******************************************************************************/
+
+StageChain::~StageChain()
+{
+	for (size_t i = 0; i < stages.size(); i++)
+	{
+		delete stages[i];
+	}
+}
+
+void StageChain::add(ProcessingStage* stage)
+{
+	stages.push_back(stage);
+	timingStages.push_back(ipcv_timing_stage(stage->name()));
+}
+
+IplImage* StageChain::process(IplImage* frame)
+{
+	for (size_t i = 0; i < stages.size(); i++)
+	{
+		IpcvScopedTimer timer(timingStages[i]);
+		frame = stages[i]->process(frame);
+	}
+	return frame;
+}
+
+/******************************************************************************/
+
+// force a window / neighbourhood size to be odd and within [minimum, maximum]
+
+static int odd_size(int n, int minimum, int maximum)
+{
+	n = std::min(std::max(n, minimum), maximum);
+	return ((n % 2) == 0) ? n + 1 : n;
+}
+
+/******************************************************************************/
+
+// convert to grayscale (as at the start of most examples)
+
+class GrayscaleStage : public ProcessingStage
+{
+public:
+	GrayscaleStage() : gray(NULL) {}
+	~GrayscaleStage() { if (gray) { cvReleaseImage(&gray); } }
+
+	IplImage* process(IplImage* frame)
+	{
+		if (frame->nChannels == 1) {
+			return frame;
+		}
+		reuse_image(&gray, cvGetSize(frame), frame->depth, 1, frame->origin);
+		cvCvtColor(frame, gray, CV_BGR2GRAY);
+		return gray;
+	}
+	const char* name() const { return "gray"; }
+
+private:
+	IplImage* gray;
+};
+
+/******************************************************************************/
+
+// gaussian / median smoothing (as gaussian.cc / median.cc)
+
+class SmoothStage : public ProcessingStage
+{
+public:
+	SmoothStage(int type, int n) : smoothType(type), windowSize(n), smooth(NULL) {}
+	~SmoothStage() { if (smooth) { cvReleaseImage(&smooth); } }
+
+	IplImage* process(IplImage* frame)
+	{
+		reuse_image(&smooth, cvGetSize(frame), frame->depth, frame->nChannels,
+					frame->origin);
+		if (smoothType == CV_GAUSSIAN) {
+			cvSmooth(frame, smooth, CV_GAUSSIAN, windowSize, windowSize);
+		} else {
+			cvSmooth(frame, smooth, CV_MEDIAN, windowSize, 0);
+		}
+		return smooth;
+	}
+	const char* name() const
+	{
+		return (smoothType == CV_GAUSSIAN) ? "gaussian" : "median";
+	}
+
+private:
+	int smoothType;
+	int windowSize;
+	IplImage* smooth;
+};
+
+/******************************************************************************/
+
+// sobel / laplace edges (as sobel.cc / laplace.cc) via a 16-bit signed
+// intermediate image, converted back to 8-bit for display / chaining
+
+class EdgeStage : public ProcessingStage
+{
+public:
+	EdgeStage(bool isSobel, int n) : sobel(isSobel), neighbourhoodSize(n),
+									 edges16(NULL), edges(NULL) {}
+	~EdgeStage()
+	{
+		if (edges16) { cvReleaseImage(&edges16); }
+		if (edges) { cvReleaseImage(&edges); }
+	}
+
+	IplImage* process(IplImage* frame)
+	{
+		reuse_image(&edges16, cvGetSize(frame), IPL_DEPTH_16S, frame->nChannels,
+					frame->origin);
+		reuse_image(&edges, cvGetSize(frame), IPL_DEPTH_8U, frame->nChannels,
+					frame->origin);
+		if (sobel) {
+			cvSobel(frame, edges16, 1, 1, neighbourhoodSize);
+		} else {
+			cvLaplace(frame, edges16, neighbourhoodSize);
+		}
+		cvConvertScaleAbs(edges16, edges, 1, 0);
+		return edges;
+	}
+	const char* name() const { return (sobel) ? "sobel" : "laplace"; }
+
+private:
+	bool sobel;
+	int neighbourhoodSize;
+	IplImage* edges16;
+	IplImage* edges;
+};
+
+/******************************************************************************/
+
+// canny edge detection (as canny.cc) - input converted to grayscale if needed
+
+class CannyStage : public ProcessingStage
+{
+public:
+	CannyStage(int lower, int upper, int n) : lowerThreshold(lower),
+		upperThreshold(upper), windowSize(n), edges(NULL) {}
+	~CannyStage() { if (edges) { cvReleaseImage(&edges); } }
+
+	IplImage* process(IplImage* frame)
+	{
+		IplImage* gray = toGray.process(frame);
+		reuse_image(&edges, cvGetSize(gray), IPL_DEPTH_8U, 1, frame->origin);
+		cvCanny(gray, edges, lowerThreshold, upperThreshold, windowSize);
+		return edges;
+	}
+	const char* name() const { return "canny"; }
+
+private:
+	GrayscaleStage toGray;
+	int lowerThreshold;
+	int upperThreshold;
+	int windowSize;
+	IplImage* edges;
+};
+
+/******************************************************************************/
+
+// fixed / adaptive thresholding (as threshold.cc / adaptive_threshold.cc)
+
+class ThresholdStage : public ProcessingStage
+{
+public:
+	ThresholdStage(bool isAdaptive, int t, int n, int c) : adaptive(isAdaptive),
+		threshold(t), windowSize(n), constant(c), thresholded(NULL) {}
+	~ThresholdStage() { if (thresholded) { cvReleaseImage(&thresholded); } }
+
+	IplImage* process(IplImage* frame)
+	{
+		IplImage* gray = toGray.process(frame);
+		reuse_image(&thresholded, cvGetSize(gray), IPL_DEPTH_8U, 1, frame->origin);
+		if (adaptive) {
+			cvAdaptiveThreshold(gray, thresholded, 255, CV_ADAPTIVE_THRESH_MEAN_C,
+								CV_THRESH_BINARY, windowSize, constant);
+		} else {
+			cvThreshold(gray, thresholded, threshold, 255, CV_THRESH_BINARY);
+		}
+		return thresholded;
+	}
+	const char* name() const
+	{
+		return (adaptive) ? "adaptive_threshold" : "threshold";
+	}
+
+private:
+	GrayscaleStage toGray;
+	bool adaptive;
+	int threshold;
+	int windowSize;
+	int constant;
+	IplImage* thresholded;
+};
+
+/******************************************************************************/
+
+// exponential / logarithmic point transforms (as exponential.cc /
+// logarithmic.cc) applied via a 256 entry lookup table
+
+class PointTransformStage : public ProcessingStage
+{
+public:
+	PointTransformStage(bool isLogarithmic, int C, double rate) :
+		logarithmic(isLogarithmic), transformed(NULL)
+	{
+		lut = create_point_transform_lut((logarithmic) ? logarithmic_transform
+												: exponential_transform, 2);
+		double params[2] = {(double) C, rate};
+		update_point_transform_lut(lut, params);
+	}
+	~PointTransformStage()
+	{
+		if (transformed) { cvReleaseImage(&transformed); }
+		release_point_transform_lut(&lut);
+	}
+
+	IplImage* process(IplImage* frame)
+	{
+		IplImage* gray = toGray.process(frame);
+		reuse_image(&transformed, cvGetSize(gray), IPL_DEPTH_8U, 1, frame->origin);
+		apply_point_transform_lut(lut, gray, transformed);
+		return transformed;
+	}
+	const char* name() const
+	{
+		return (logarithmic) ? "logarithmic" : "exponential";
+	}
+
+private:
+	GrayscaleStage toGray;
+	bool logarithmic;
+	PointTransformLUT* lut;
+	IplImage* transformed;
+};
+
+/******************************************************************************/
+
+// butterworth low / high pass filtering in the Fourier domain (as
+// dft_butterworth_lowpass.cc / dft_butterworth_highpass.cc) - output is the
+// 8-bit filtered image scaled to the full range
+
+// N.B. this always uses the real input, single precision DFT path (see
+// ipcv_dft.h) with the filter applied in CCS packed form
+
+class ButterworthStage : public ProcessingStage
+{
+public:
+	ButterworthStage(bool isHighpass, int D, int n) : highpass(isHighpass),
+		radius(D), order(n), dft_R(NULL), output(NULL), dft_Packed(NULL),
+		filterCache(create_butterworth_filter_cache((isHighpass) ?
+					IPCV_BUTTERWORTH_HIGHPASS : IPCV_BUTTERWORTH_LOWPASS)) {}
+	~ButterworthStage();
+
+	IplImage* process(IplImage* frame);
+	const char* name() const
+	{
+		return (highpass) ? "butterworth_highpass" : "butterworth_lowpass";
+	}
+
+private:
+	GrayscaleStage toGray;
+	bool highpass;
+	int radius;
+	int order;
+	IplImage* dft_R;						// real input DFT (CCS packed)
+	IplImage* output;
+	CvMat* dft_Packed;						// filter (CCS packed)
+	ButterworthFilterCache* filterCache;	// filter (built on first frame)
+};
+
+ButterworthStage::~ButterworthStage()
+{
+	if (dft_R) { cvReleaseImage(&dft_R); }
+	if (output) { cvReleaseImage(&output); }
+	if (dft_Packed) { cvReleaseMat(&dft_Packed); }
+	release_butterworth_filter_cache(&filterCache);
+}
+
+IplImage* ButterworthStage::process(IplImage* frame)
+{
+	IplImage* gray = toGray.process(frame);
+	CvSize size = cvGetSize(gray);
+	double m, M;
+
+	reuse_image(&output, size, IPL_DEPTH_8U, 1, frame->origin);
+
+	// (re-)allocate the DFT sized arrays if the input size has changed
+
+	int dft_M = cvGetOptimalDFTSize( size.height - 1 );
+	int dft_N = cvGetOptimalDFTSize( size.width - 1 );
+
+	if ((!dft_Packed) || (dft_Packed->rows != dft_M) || (dft_Packed->cols != dft_N))
+	{
+		if (dft_Packed) { cvReleaseMat(&dft_Packed); }
+		dft_Packed = cvCreateMat( dft_M, dft_N, CV_32FC1 );
+	}
+	reuse_image(&dft_R, cvSize(dft_N, dft_M), IPL_DEPTH_32F, 1, frame->origin);
+
+	// set up filter (only rebuilt, and re-packed, if the DFT size has changed)
+
+	if (update_butterworth_filter(filterCache, cvSize(dft_N, dft_M), radius, order))
+	{
+		create_packed_filter(filterCache->filter, dft_Packed);
+	}
+
+	// forward transform, filter and invert
+
+	cvResetImageROI( dft_R );
+	dft_real_forward( gray, dft_R );
+	cvMul( dft_R, dft_Packed, dft_R, 1 );
+	cvDFT( dft_R, dft_R, CV_DXT_INVERSE, size.height );
+
+	// take the (un-padded) result scaled for display
+
+	cvSetImageROI( dft_R, cvRect(0, 0, size.width, size.height) );
+	cvMinMaxLoc(dft_R, &m, &M, NULL, NULL, NULL);
+	double range = std::max(M - m, 1e-10);
+	cvConvertScale(dft_R, output, 255.0 / range, -m * 255.0 / range);
+	cvResetImageROI( dft_R );
+
+	return output;
+}
+
+/******************************************************************************/
+
+// get the integer parameter i (0 ...) from a parsed specification (or default)
+
+static int param(const std::vector<std::string>& params, size_t i, int defaultValue)
+{
+	return ((i + 1) < params.size()) ? atoi(params[i + 1].c_str()) : defaultValue;
+}
+
+/******************************************************************************/
+
+ProcessingStage* create_stage(const char* spec)
+{
+	// split "name:param:param ..."
+
+	std::vector<std::string> params;
+	std::string s(spec);
+	size_t start = 0, end;
+	while ((end = s.find(':', start)) != std::string::npos)
+	{
+		params.push_back(s.substr(start, end - start));
+		start = end + 1;
+	}
+	params.push_back(s.substr(start));
+
+	const std::string& name = params[0];
+
+	if (name == "gray") {
+		return new GrayscaleStage();
+	} else if (name == "gaussian") {
+		return new SmoothStage(CV_GAUSSIAN, odd_size(param(params, 0, 3), 1, 255));
+	} else if (name == "median") {
+		return new SmoothStage(CV_MEDIAN, odd_size(param(params, 0, 3), 1, 255));
+	} else if (name == "sobel") {
+		return new EdgeStage(true, odd_size(param(params, 0, 3), 3, 7));
+	} else if (name == "laplace") {
+		return new EdgeStage(false, odd_size(param(params, 0, 3), 1, 7));
+	} else if (name == "canny") {
+		return new CannyStage(param(params, 0, 50), param(params, 1, 200),
+							  odd_size(param(params, 2, 3), 3, 7));
+	} else if (name == "threshold") {
+		return new ThresholdStage(false, param(params, 0, 150), 0, 0);
+	} else if (name == "adaptive_threshold") {
+		return new ThresholdStage(true, 0, odd_size(param(params, 0, 3), 3, 255),
+								  param(params, 1, 0));
+	} else if (name == "exponential") {
+		return new PointTransformStage(false, param(params, 0, 10),
+									   0.001 * param(params, 1, 1));
+	} else if (name == "logarithmic") {
+		return new PointTransformStage(true, param(params, 0, 10),
+									   0.01 * param(params, 1, 1));
+	} else if (name == "butterworth_lowpass") {
+		return new ButterworthStage(false, std::max(1, param(params, 0, 30)),
+									param(params, 1, 2));
+	} else if (name == "butterworth_highpass") {
+		return new ButterworthStage(true, std::max(1, param(params, 0, 30)),
+									param(params, 1, 2));
+	}
+
+	printf("ERROR: unknown processing stage \"%s\"\n", spec);
+	return NULL;
+}
+
+/******************************************************************************/
+
+StageChain* create_stage_chain(const char* specs)
+{
+	StageChain* chain = new StageChain();
+	std::string s(specs);
+	size_t start = 0, end;
+
+	do {
+		end = s.find(',', start);
+		std::string spec = s.substr(start, (end == std::string::npos) ?
+										   std::string::npos : end - start);
+		ProcessingStage* stage = create_stage(spec.c_str());
+		if (!stage) {
+			delete chain;
+			return NULL;
+		}
+		chain->add(stage);
+		start = end + 1;
+	} while (end != std::string::npos);
+
+	return chain;
+}
+
+/******************************************************************************/
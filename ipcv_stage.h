@@ -0,0 +1,96 @@
+// Module : uniform "process(frame) -> frame" processing stages
+// usage: #include "ipcv_stage.h" (link with the ipcv library)
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: each stage wraps the core operation of one of the examples and owns
+// (and re-uses between frames) its output buffers, so stages can be chained
+// within one process rather than piping video between the example programs.
+
+#ifndef IPCV_STAGE_H
+#define IPCV_STAGE_H
+
+#include "cv.h"       // open cv general include file
+
+#include <vector>
+
+/******************************************************************************/
+
+// base class for all processing stages
+
+class ProcessingStage
+{
+public:
+	virtual ~ProcessingStage() {}
+
+	// process a frame - the returned image is owned by the stage (and is only
+	// valid until the next call); the input frame is never modified
+
+	virtual IplImage* process(IplImage* frame) = 0;
+
+	// name of stage (for display / reporting)
+
+	virtual const char* name() const = 0;
+
+protected:
+
+	// return an image buffer of the given size/depth/channels, re-using the
+	// existing *buffer unless the format has changed (origin is always set)
+
+	static IplImage* reuse_image(IplImage** buffer, CvSize size, int depth,
+								 int channels, int origin);
+};
+
+/******************************************************************************/
+
+// a sequence of stages applied in order (itself a stage) - the chain takes
+// ownership of the stages added to it (and, with --timing, times each stage
+// under its own name)
+
+class StageChain : public ProcessingStage
+{
+public:
+	~StageChain();
+
+	void add(ProcessingStage* stage);
+	int size() const { return (int) stages.size(); }
+	ProcessingStage* stage(int i) const { return stages[i]; }
+
+	IplImage* process(IplImage* frame);
+	const char* name() const { return "chain"; }
+
+private:
+	std::vector<ProcessingStage*> stages;
+	std::vector<int> timingStages;	// timing identifier of each stage
+};
+
+/******************************************************************************/
+
+// create a stage from a specification string "name[:param[:param ...]]"
+
+// supported stages (parameters default to those of the corresponding example):
+// gray                              - convert to grayscale (as all examples)
+// gaussian[:N]                      - gaussian.cc, NxN window
+// median[:N]                        - median.cc, NxN window
+// sobel[:N]                         - sobel.cc, NxN neighbourhood
+// laplace[:N]                       - laplace.cc, NxN neighbourhood
+// canny[:lower[:upper[:N]]]         - canny.cc
+// threshold[:T]                     - threshold.cc
+// adaptive_threshold[:N[:C]]        - adaptive_threshold.cc
+// exponential[:C[:alpha_mult]]      - exponential.cc (alpha = 0.001 x mult)
+// logarithmic[:C[:omega_mult]]      - logarithmic.cc (omega = 0.01 x mult)
+// butterworth_lowpass[:D[:n]]       - dft_butterworth_lowpass.cc
+// butterworth_highpass[:D[:n]]      - dft_butterworth_highpass.cc
+
+// return value - new stage or NULL if the specification is not recognised
+
+ProcessingStage* create_stage(const char* spec);
+
+// create a chain of stages from a comma separated list of specifications
+// (e.g. "gray,gaussian:5,canny:50:200") or NULL if any are not recognised
+
+StageChain* create_stage_chain(const char* specs);
+
+/******************************************************************************/
+
+#endif
@@ -0,0 +1,832 @@
+// Module : normalised cross correlation template matching for
+//          template_matching.cc (coarse to fine over image pyramids)
+// usage: see ipcv_template.h
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+#include "ipcv_template.h"
+#include "ipcv_dft.h"
+
+#include <math.h>
+#include <float.h>
+#include <algorithm> // contains max() function (amongst others)
+#include <thread>
+#include <atomic>
+
+/******************************************************************************/
+
+// (rough) cost of one FFT butterfly relative to one multiply-add of the
+// spatial correlation, for the estimate of IPCV_TEMPLATE_AUTO
+
+static const double FFT_COST = 2.0;
+
+/******************************************************************************/
+
+// return a matrix header of the given size over *buffer, only re-allocating
+// the buffer if it is too small (so a search window of varying size does not
+// cause an allocation every frame)
+
+static CvMat* reuse_mat(CvMat** buffer, CvMat* header, int rows, int cols)
+{
+	if ((*buffer) && (((*buffer)->rows * (*buffer)->cols) < (rows * cols)))
+	{
+		cvReleaseMat(buffer);
+	}
+	if (!(*buffer)) {
+		*buffer = cvCreateMat(rows, cols, CV_32FC1);
+	}
+	return cvInitMatHeader(header, rows, cols, CV_32FC1, (*buffer)->data.ptr);
+}
+
+// re-use (or allocate) a matrix of exactly the given size and type
+
+static CvMat* reuse_exact_mat(CvMat** m, int rows, int cols, int type)
+{
+	if ((*m) && (((*m)->rows != rows) || ((*m)->cols != cols) ||
+		(CV_MAT_TYPE((*m)->type) != type)))
+	{
+		cvReleaseMat(m);
+	}
+	if (!(*m)) {
+		*m = cvCreateMat(rows, cols, type);
+	}
+	return *m;
+}
+
+// re-use (or allocate) an image of exactly the given size, depth and channels
+
+static IplImage* reuse_image(IplImage** img, CvSize size, int depth, int channels)
+{
+	if ((*img) && (((*img)->width != size.width) ||
+		((*img)->height != size.height) || ((*img)->depth != depth) ||
+		((*img)->nChannels != channels)))
+	{
+		cvReleaseImage(img);
+	}
+	if (!(*img)) {
+		*img = cvCreateImage(size, depth, channels);
+	}
+	return *img;
+}
+
+/******************************************************************************/
+
+TemplateMatcher* create_template_matcher(const IplImage* templ, int levels)
+{
+	TemplateMatcher* matcher = new TemplateMatcher;
+
+	matcher->response = NULL;
+	matcher->refine = NULL;
+	matcher->responseBuffer = NULL;
+	matcher->refineBuffer = NULL;
+	for (int l = 0; l <= IPCV_TEMPLATE_MAX_LEVELS; l++)
+	{
+		matcher->templ[l] = NULL;
+		matcher->frame[l] = NULL;
+	}
+	matcher->margin = 0;
+	matcher->threshold = IPCV_TEMPLATE_TRACK_THRESHOLD;
+
+	matcher->engine = IPCV_TEMPLATE_AUTO;
+	for (int l = 0; l <= IPCV_TEMPLATE_MAX_LEVELS; l++)
+	{
+		for (int c = 0; c < 4; c++) { matcher->spectrum[l][c] = NULL; }
+	}
+	for (int c = 0; c < 4; c++) { matcher->planes[c] = NULL; }
+	matcher->frameSpectrum = NULL;
+	matcher->correlation = NULL;
+	matcher->product = NULL;
+	matcher->sum = NULL;
+	matcher->sqsum = NULL;
+
+	set_matcher_template(matcher, templ, levels);
+
+	return matcher;
+}
+
+/******************************************************************************/
+
+void set_matcher_template(TemplateMatcher* matcher, const IplImage* templ, int levels)
+{
+	for (int l = 0; l <= IPCV_TEMPLATE_MAX_LEVELS; l++)
+	{
+		if (matcher->templ[l]) { cvReleaseImage(&(matcher->templ[l])); }
+		for (int c = 0; c < 4; c++)
+		{
+			if (matcher->spectrum[l][c]) { cvReleaseMat(&(matcher->spectrum[l][c])); }
+		}
+		matcher->spectrumSize[l] = cvSize(0, 0);
+	}
+
+	matcher->templ[0] = cvCloneImage(templ);
+
+	// build the template pyramid (only down to the minimum template size)
+
+	levels = std::min(std::max(levels, 0), IPCV_TEMPLATE_MAX_LEVELS);
+	int l;
+	for (l = 1; l <= levels; l++)
+	{
+		IplImage* prev = matcher->templ[l - 1];
+		CvSize size = cvSize((prev->width + 1) / 2, (prev->height + 1) / 2);
+		if ((size.width < IPCV_TEMPLATE_MIN_SIZE) ||
+			(size.height < IPCV_TEMPLATE_MIN_SIZE)) {
+			break;
+		}
+		matcher->templ[l] = cvCreateImage(size, prev->depth, prev->nChannels);
+		cvPyrDown(prev, matcher->templ[l], CV_GAUSSIAN_5x5);
+	}
+	matcher->levels = l - 1;
+
+	// the template energy (for the normalisation of the FFT correlation)
+
+	for (l = 0; l <= matcher->levels; l++)
+	{
+		matcher->templSqSum[l] = cvDotProduct(matcher->templ[l], matcher->templ[l]);
+	}
+
+	// no previous match for the new template
+
+	matcher->found = false;
+	matcher->global = true;
+	matcher->window = cvRect(0, 0, 0, 0);
+}
+
+/******************************************************************************/
+
+void set_template_tracking(TemplateMatcher* matcher, int margin, double threshold)
+{
+	matcher->margin = std::max(margin, 0);
+	matcher->threshold = threshold;
+}
+
+/******************************************************************************/
+
+void set_template_engine(TemplateMatcher* matcher, int engine)
+{
+	matcher->engine = engine;
+}
+
+/******************************************************************************/
+
+// build the frame pyramid (re-using the buffers) - level 0 is the frame
+
+static void build_frame_pyramid(TemplateMatcher* matcher, IplImage* frame)
+{
+	matcher->frame[0] = frame;
+
+	for (int l = 1; l <= matcher->levels; l++)
+	{
+		IplImage* prev = matcher->frame[l - 1];
+		CvSize size = cvSize((prev->width + 1) / 2, (prev->height + 1) / 2);
+
+		cvPyrDown(prev, reuse_image(&(matcher->frame[l]), size, prev->depth,
+									prev->nChannels), CV_GAUSSIAN_5x5);
+	}
+}
+
+/******************************************************************************/
+
+// return the window of a level to search for a template positioned (top left)
+// at location, give or take radius pixels - clipped to the level, but always
+// at least the size of the template
+
+static CvRect search_window(IplImage* level, IplImage* templ, CvPoint location,
+							int radius)
+{
+	int x0 = std::max(0, location.x - radius);
+	int y0 = std::max(0, location.y - radius);
+	int x1 = std::min(level->width, location.x + templ->width + radius);
+	int y1 = std::min(level->height, location.y + templ->height + radius);
+
+	x0 = std::max(0, std::min(x0, level->width - templ->width));
+	y0 = std::max(0, std::min(y0, level->height - templ->height));
+	x1 = std::max(x1, x0 + templ->width);
+	y1 = std::max(y1, y0 + templ->height);
+
+	return cvRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+/******************************************************************************/
+
+// return true if a search of region for templ is to be made by FFT (with the
+// given engine)
+
+static bool use_fft(int engine, CvRect region, IplImage* templ)
+{
+	if (engine != IPCV_TEMPLATE_AUTO) {
+		return (engine == IPCV_TEMPLATE_FFT);
+	}
+	if ((templ->width < IPCV_TEMPLATE_FFT_MIN_SIZE) ||
+		(templ->height < IPCV_TEMPLATE_FFT_MIN_SIZE)) {
+		return false;
+	}
+
+	// multiply-adds of the spatial correlation against one forward DFT per
+	// channel and one inverse DFT of the search region (padded)
+
+	double n = ((double) cvGetOptimalDFTSize(region.width)) *
+				cvGetOptimalDFTSize(region.height);
+	double spatial = ((double) (region.width - templ->width + 1)) *
+					 (region.height - templ->height + 1) *
+					 templ->width * templ->height * templ->nChannels;
+	double fft = FFT_COST * n * (log(n) / log(2.0)) * (templ->nChannels + 1);
+
+	return (fft < spatial);
+}
+
+/******************************************************************************/
+
+// compute the spectra (CCS packed, per channel) of a template for a DFT size
+
+static void compute_template_spectra(IplImage* templ, CvSize dftSize, CvMat** spectra)
+{
+	IplImage* planes[4] = {NULL, NULL, NULL, NULL};
+
+	if (templ->nChannels > 1)
+	{
+		for (int c = 0; c < templ->nChannels; c++)
+		{
+			planes[c] = cvCreateImage(cvGetSize(templ), templ->depth, 1);
+		}
+		cvSplit(templ, planes[0], planes[1], planes[2], planes[3]);
+	} else {
+		planes[0] = templ;
+	}
+
+	for (int c = 0; c < templ->nChannels; c++)
+	{
+		dft_real_forward(planes[c], reuse_exact_mat(&(spectra[c]),
+						 dftSize.height, dftSize.width, CV_32FC1), CV_DXT_FORWARD);
+	}
+
+	if (templ->nChannels > 1)
+	{
+		for (int c = 0; c < templ->nChannels; c++) { cvReleaseImage(&planes[c]); }
+	}
+}
+
+// compute (or re-use) the spectra of the template channels at a level for a
+// given DFT size
+
+static void update_template_spectrum(TemplateMatcher* matcher, int l, CvSize dftSize)
+{
+	if ((matcher->spectrumSize[l].width != dftSize.width) ||
+		(matcher->spectrumSize[l].height != dftSize.height))
+	{
+		compute_template_spectra(matcher->templ[l], dftSize, matcher->spectrum[l]);
+		matcher->spectrumSize[l] = dftSize;
+	}
+}
+
+/******************************************************************************/
+
+// add the correlation (in the frequency domain) of channel c of a template
+// to the sum over the channels in correlation - the correlation of a channel
+// is the product of the frame spectrum and the conjugate of the template
+// spectrum, summed over the channels before the (single) inverse DFT
+
+static void add_channel_correlation(const CvMat* frameSpectrum,
+									const CvMat* templSpectrum, int c,
+									CvMat* correlation, CvMat* product)
+{
+	cvMulSpectrums(frameSpectrum, templSpectrum, (c == 0) ? correlation : product,
+				   CV_DXT_MUL_CONJ);
+	if (c > 0) {
+		cvAdd(correlation, product, correlation, NULL);
+	}
+}
+
+// normalise a (spatial domain) correlation as CV_TM_CCORR_NORMED into the
+// response, with the sum of squares of each window (over all channels) from
+// the integral image sqsum of the frame (region) searched
+
+static void normalise_correlation(const CvMat* correlation, const CvMat* sqsum,
+								  double templSqSum, CvSize templSize, int cn,
+								  CvMat* response)
+{
+	int tw = templSize.width * cn;
+	int th = templSize.height;
+
+	for (int y = 0; y < response->rows; y++)
+	{
+		const double* top = (const double*) (sqsum->data.ptr + (y * sqsum->step));
+		const double* bottom = (const double*) (sqsum->data.ptr +
+												((y + th) * sqsum->step));
+		const float* corr = (const float*) (correlation->data.ptr +
+											(y * correlation->step));
+		float* out = (float*) (response->data.ptr + (y * response->step));
+
+		for (int x = 0; x < response->cols; x++)
+		{
+			double windowSqSum = 0;
+			for (int c = x * cn; c < (x * cn) + cn; c++)
+			{
+				windowSqSum += bottom[c + tw] - bottom[c] - top[c + tw] + top[c];
+			}
+			double denom = sqrt(templSqSum * std::max(windowSqSum, 0.0));
+			out[x] = (denom > DBL_EPSILON) ?
+					 (float) std::min(std::max(corr[x] / denom, -1.0), 1.0) : 0;
+		}
+	}
+}
+
+/******************************************************************************/
+
+// correlate the template with a region of one pyramid level by FFT and
+// normalise (as CV_TM_CCORR_NORMED) into *response
+
+static void correlate_region_fft(TemplateMatcher* matcher, int l, CvRect region,
+								 CvMat* response)
+{
+	IplImage* frame = matcher->frame[l];
+	IplImage* templ = matcher->templ[l];
+	int cn = frame->nChannels;
+	CvSize dftSize = cvSize(cvGetOptimalDFTSize(region.width),
+							cvGetOptimalDFTSize(region.height));
+
+	update_template_spectrum(matcher, l, dftSize);
+
+	reuse_exact_mat(&(matcher->frameSpectrum), dftSize.height, dftSize.width, CV_32FC1);
+	reuse_exact_mat(&(matcher->correlation), dftSize.height, dftSize.width, CV_32FC1);
+	reuse_exact_mat(&(matcher->product), dftSize.height, dftSize.width, CV_32FC1);
+	reuse_exact_mat(&(matcher->sum), region.height + 1, region.width + 1, CV_64FC(cn));
+	reuse_exact_mat(&(matcher->sqsum), region.height + 1, region.width + 1, CV_64FC(cn));
+
+	cvSetImageROI(frame, region);
+
+	if (cn > 1)
+	{
+		for (int c = 0; c < cn; c++)
+		{
+			reuse_image(&(matcher->planes[c]), cvSize(region.width, region.height),
+						frame->depth, 1);
+		}
+		cvSplit(frame, matcher->planes[0], matcher->planes[1], matcher->planes[2],
+				matcher->planes[3]);
+	}
+
+	for (int c = 0; c < cn; c++)
+	{
+		dft_real_forward((cn > 1) ? (CvArr*) matcher->planes[c] : (CvArr*) frame,
+						 matcher->frameSpectrum, CV_DXT_FORWARD);
+		add_channel_correlation(matcher->frameSpectrum, matcher->spectrum[l][c], c,
+								matcher->correlation, matcher->product);
+	}
+	cvDFT(matcher->correlation, matcher->correlation, CV_DXT_INV_SCALE,
+		  response->rows);
+
+	// sum of squares of each window (all channels) from the integral image
+
+	cvIntegral(frame, matcher->sum, matcher->sqsum, NULL);
+	cvResetImageROI(frame);
+
+	normalise_correlation(matcher->correlation, matcher->sqsum,
+						  matcher->templSqSum[l], cvGetSize(templ), cn, response);
+}
+
+/******************************************************************************/
+
+// match the template over a region of one pyramid level, returning the
+// score (and location within the level) of the best match - the response
+// is sized to the region
+
+static double match_region(TemplateMatcher* matcher, int l, CvRect region,
+						   CvMat** buffer, CvMat* header, CvMat** response,
+						   CvPoint* location)
+{
+	IplImage* frame = matcher->frame[l];
+	IplImage* templ = matcher->templ[l];
+	double minVal, maxVal;
+	CvPoint minLoc, maxLoc;
+
+	*response = reuse_mat(buffer, header, region.height - templ->height + 1,
+						  region.width - templ->width + 1);
+
+	if (use_fft(matcher->engine, region, templ))
+	{
+		correlate_region_fft(matcher, l, region, *response);
+	} else {
+		cvSetImageROI(frame, region);
+		cvMatchTemplate(frame, templ, *response, CV_TM_CCORR_NORMED);
+		cvResetImageROI(frame);
+	}
+
+	cvMinMaxLoc(*response, &minVal, &maxVal, &minLoc, &maxLoc, NULL);
+
+	location->x = region.x + maxLoc.x;
+	location->y = region.y + maxLoc.y;
+	return maxVal;
+}
+
+/******************************************************************************/
+
+// search a region of the coarsest level and refine the best match in a small
+// window at each finer level
+
+static double match_coarse_to_fine(TemplateMatcher* matcher, CvRect region,
+								   CvPoint* location)
+{
+	int l = matcher->levels;
+	CvPoint loc;
+	double score = match_region(matcher, l, region, &(matcher->responseBuffer),
+								&(matcher->responseHeader), &(matcher->response), &loc);
+
+	for (l = l - 1; l >= 0; l--)
+	{
+		CvRect window = search_window(matcher->frame[l], matcher->templ[l],
+							cvPoint(2 * loc.x, 2 * loc.y), IPCV_TEMPLATE_REFINE_RADIUS);
+
+		score = match_region(matcher, l, window, &(matcher->refineBuffer),
+							 &(matcher->refineHeader), &(matcher->refine), &loc);
+	}
+
+	*location = loc;
+	return score;
+}
+
+/******************************************************************************/
+
+double match_template(TemplateMatcher* matcher, IplImage* frame, CvPoint* location)
+{
+	build_frame_pyramid(matcher, frame);
+
+	int l = matcher->levels;
+	IplImage* coarse = matcher->frame[l];
+	double score = 0;
+	CvPoint loc;
+
+	// in tracking mode first search the window around the previous match
+	// (the margin being scaled to the coarsest level)
+
+	matcher->global = true;
+	if ((matcher->margin > 0) && (matcher->found))
+	{
+		int radius = std::max(1, (matcher->margin + (1 << l) - 1) >> l);
+		CvRect region = search_window(coarse, matcher->templ[l],
+							cvPoint(matcher->previous.x >> l, matcher->previous.y >> l),
+							radius);
+
+		score = match_coarse_to_fine(matcher, region, &loc);
+		matcher->global = (score < matcher->threshold);
+		matcher->window = cvRect(region.x << l, region.y << l,
+								 region.width << l, region.height << l);
+	}
+
+	// otherwise (or if the target has been lost) search the whole frame
+
+	if (matcher->global)
+	{
+		score = match_coarse_to_fine(matcher,
+							cvRect(0, 0, coarse->width, coarse->height), &loc);
+		matcher->window = cvRect(0, 0, frame->width, frame->height);
+	}
+
+	matcher->found = (score >= matcher->threshold);
+	matcher->previous = loc;
+
+	matcher->frame[0] = NULL;	// (not owned)
+
+	*location = loc;
+	return score;
+}
+
+/******************************************************************************/
+
+void release_template_matcher(TemplateMatcher** matcher)
+{
+	if ((matcher) && (*matcher))
+	{
+		for (int l = 0; l <= IPCV_TEMPLATE_MAX_LEVELS; l++)
+		{
+			if ((*matcher)->templ[l]) { cvReleaseImage(&((*matcher)->templ[l])); }
+			for (int c = 0; c < 4; c++)
+			{
+				if ((*matcher)->spectrum[l][c]) {
+					cvReleaseMat(&((*matcher)->spectrum[l][c]));
+				}
+			}
+			if ((l > 0) && ((*matcher)->frame[l])) {
+				cvReleaseImage(&((*matcher)->frame[l]));
+			}
+		}
+		if ((*matcher)->responseBuffer) { cvReleaseMat(&((*matcher)->responseBuffer)); }
+		if ((*matcher)->refineBuffer) { cvReleaseMat(&((*matcher)->refineBuffer)); }
+		for (int c = 0; c < 4; c++)
+		{
+			if ((*matcher)->planes[c]) { cvReleaseImage(&((*matcher)->planes[c])); }
+		}
+		if ((*matcher)->frameSpectrum) { cvReleaseMat(&((*matcher)->frameSpectrum)); }
+		if ((*matcher)->correlation) { cvReleaseMat(&((*matcher)->correlation)); }
+		if ((*matcher)->product) { cvReleaseMat(&((*matcher)->product)); }
+		if ((*matcher)->sum) { cvReleaseMat(&((*matcher)->sum)); }
+		if ((*matcher)->sqsum) { cvReleaseMat(&((*matcher)->sqsum)); }
+		delete *matcher;
+		*matcher = NULL;
+	}
+}
+
+/******************************************************************************/
+
+// one template of a template bank and its per template buffers
+
+struct BankTemplate
+{
+	IplImage* templ;		// template
+	double sqSum;			// template sum of squares
+	CvSize spectrumSize;	// DFT size of the cached template spectra
+	CvMat* spectrum[4];		// template spectra (CCS packed, per channel)
+	CvMat* correlation;		// correlation (FFT) buffers
+	CvMat* product;
+	CvMat* response;		// normalised correlation (whole frame)
+	std::vector<TemplateDetection> detections;	// matches in the last frame
+};
+
+struct TemplateBank
+{
+	int engine;				// IPCV_TEMPLATE_{AUTO | SPATIAL | FFT}
+	int threads;			// number of templates correlated at once
+	std::vector<BankTemplate> templates;
+
+	// per frame work shared by all of the templates
+
+	IplImage* planes[4];	// channels of the frame
+	CvMat* frameSpectrum[4];	// spectrum of each channel (FFT only)
+	CvMat* sum;				// integral images of the frame (FFT only)
+	CvMat* sqsum;
+};
+
+/******************************************************************************/
+
+TemplateBank* create_template_bank(int engine, int threads)
+{
+	TemplateBank* bank = new TemplateBank;
+
+	bank->engine = engine;
+	bank->threads = (threads > 0) ? threads :
+					std::max(1, (int) std::thread::hardware_concurrency());
+	for (int c = 0; c < 4; c++)
+	{
+		bank->planes[c] = NULL;
+		bank->frameSpectrum[c] = NULL;
+	}
+	bank->sum = NULL;
+	bank->sqsum = NULL;
+
+	return bank;
+}
+
+/******************************************************************************/
+
+int add_bank_template(TemplateBank* bank, const IplImage* templ)
+{
+	BankTemplate t;
+
+	// (copying only the ROI, if set)
+
+	t.templ = cvCreateImage(cvGetSize(templ), templ->depth, templ->nChannels);
+	cvCopy(templ, t.templ, NULL);
+	t.sqSum = cvDotProduct(t.templ, t.templ);
+	t.spectrumSize = cvSize(0, 0);
+	for (int c = 0; c < 4; c++) { t.spectrum[c] = NULL; }
+	t.correlation = NULL;
+	t.product = NULL;
+	t.response = NULL;
+
+	bank->templates.push_back(t);
+	return (int) bank->templates.size() - 1;
+}
+
+/******************************************************************************/
+
+int bank_template_count(const TemplateBank* bank)
+{
+	return (int) bank->templates.size();
+}
+
+/******************************************************************************/
+
+void clear_template_bank(TemplateBank* bank)
+{
+	for (size_t i = 0; i < bank->templates.size(); i++)
+	{
+		BankTemplate& t = bank->templates[i];
+
+		cvReleaseImage(&(t.templ));
+		for (int c = 0; c < 4; c++)
+		{
+			if (t.spectrum[c]) { cvReleaseMat(&(t.spectrum[c])); }
+		}
+		if (t.correlation) { cvReleaseMat(&(t.correlation)); }
+		if (t.product) { cvReleaseMat(&(t.product)); }
+		if (t.response) { cvReleaseMat(&(t.response)); }
+	}
+	bank->templates.clear();
+}
+
+/******************************************************************************/
+
+// correlate one template of the bank with the frame and find its best (up to
+// k) matches - only the buffers of the template itself are written, so the
+// templates can be processed in parallel
+
+static void match_bank_template(TemplateBank* bank, BankTemplate& t, IplImage* frame,
+								bool fft, CvSize dftSize, int k, double minScore)
+{
+	int cn = frame->nChannels;
+
+	t.detections.clear();
+	if ((t.templ->width > frame->width) || (t.templ->height > frame->height)) {
+		return;
+	}
+
+	reuse_exact_mat(&(t.response), frame->height - t.templ->height + 1,
+					frame->width - t.templ->width + 1, CV_32FC1);
+
+	if (fft)
+	{
+		if ((t.spectrumSize.width != dftSize.width) ||
+			(t.spectrumSize.height != dftSize.height))
+		{
+			compute_template_spectra(t.templ, dftSize, t.spectrum);
+			t.spectrumSize = dftSize;
+		}
+		reuse_exact_mat(&(t.correlation), dftSize.height, dftSize.width, CV_32FC1);
+		reuse_exact_mat(&(t.product), dftSize.height, dftSize.width, CV_32FC1);
+
+		for (int c = 0; c < cn; c++)
+		{
+			add_channel_correlation(bank->frameSpectrum[c], t.spectrum[c], c,
+									t.correlation, t.product);
+		}
+		cvDFT(t.correlation, t.correlation, CV_DXT_INV_SCALE, t.response->rows);
+		normalise_correlation(t.correlation, bank->sqsum, t.sqSum,
+							  cvGetSize(t.templ), cn, t.response);
+	} else {
+		cvMatchTemplate(frame, t.templ, t.response, CV_TM_CCORR_NORMED);
+	}
+
+	// best k matches - masking out (with a score of -1) the area around each
+	// match within which another match would overlap it by more than half
+
+	for (int i = 0; i < k; i++)
+	{
+		double minVal, maxVal;
+		CvPoint minLoc, maxLoc;
+		CvMat mask;
+
+		cvMinMaxLoc(t.response, &minVal, &maxVal, &minLoc, &maxLoc, NULL);
+		if (maxVal < minScore) {
+			break;
+		}
+
+		TemplateDetection d;
+		d.templ = 0;
+		d.location = maxLoc;
+		d.size = cvGetSize(t.templ);
+		d.score = maxVal;
+		t.detections.push_back(d);
+
+		int x0 = std::max(0, maxLoc.x - (d.size.width / 2));
+		int y0 = std::max(0, maxLoc.y - (d.size.height / 2));
+		int x1 = std::min(t.response->cols, maxLoc.x + (d.size.width / 2) + 1);
+		int y1 = std::min(t.response->rows, maxLoc.y + (d.size.height / 2) + 1);
+		cvGetSubRect(t.response, &mask, cvRect(x0, y0, x1 - x0, y1 - y0));
+		cvSet(&mask, cvScalarAll(-1), NULL);
+	}
+}
+
+/******************************************************************************/
+
+// the work of one frame of a template bank, shared by the threads
+
+struct BankWork
+{
+	TemplateBank* bank;
+	IplImage* frame;
+	const std::vector<char>* fft;	// use FFT for each template
+	CvSize dftSize;
+	int k;
+	double minScore;
+	std::atomic<int> next;			// next template to be started
+};
+
+// match templates of the bank until all have been started
+
+static void bank_worker(BankWork* work)
+{
+	int n = (int) work->bank->templates.size();
+
+	for (int i = work->next++; i < n; i = work->next++)
+	{
+		match_bank_template(work->bank, work->bank->templates[i], work->frame,
+							(*(work->fft))[i] != 0, work->dftSize, work->k,
+							work->minScore);
+	}
+}
+
+/******************************************************************************/
+
+int match_template_bank(TemplateBank* bank, IplImage* frame, int k, double minScore,
+						std::vector<TemplateDetection>* detections)
+{
+	int cn = frame->nChannels;
+	int n = (int) bank->templates.size();
+	CvRect whole = cvRect(0, 0, frame->width, frame->height);
+	CvSize dftSize = cvSize(cvGetOptimalDFTSize(frame->width),
+							cvGetOptimalDFTSize(frame->height));
+
+	// choose the engine for each template (all search the whole frame)
+
+	std::vector<char> fft(n, 0);
+	bool anyFFT = false;
+	for (int i = 0; i < n; i++)
+	{
+		fft[i] = use_fft(bank->engine, whole, bank->templates[i].templ);
+		anyFFT = anyFFT || fft[i];
+	}
+
+	// shared per frame work - the frame channels, their spectra and the
+	// integral image of the frame are needed only once for all the templates
+
+	if (anyFFT)
+	{
+		if (cn > 1)
+		{
+			for (int c = 0; c < cn; c++)
+			{
+				reuse_image(&(bank->planes[c]), cvGetSize(frame), frame->depth, 1);
+			}
+			cvSplit(frame, bank->planes[0], bank->planes[1], bank->planes[2],
+					bank->planes[3]);
+		}
+		for (int c = 0; c < cn; c++)
+		{
+			dft_real_forward((cn > 1) ? (CvArr*) bank->planes[c] : (CvArr*) frame,
+							 reuse_exact_mat(&(bank->frameSpectrum[c]), dftSize.height,
+											 dftSize.width, CV_32FC1), CV_DXT_FORWARD);
+		}
+		reuse_exact_mat(&(bank->sum), frame->height + 1, frame->width + 1, CV_64FC(cn));
+		reuse_exact_mat(&(bank->sqsum), frame->height + 1, frame->width + 1, CV_64FC(cn));
+		cvIntegral(frame, bank->sum, bank->sqsum, NULL);
+	}
+
+	// correlate the templates in parallel (each thread taking the next
+	// template not yet started, with the calling thread as one of them)
+
+	BankWork work;
+	work.bank = bank;
+	work.frame = frame;
+	work.fft = &fft;
+	work.dftSize = dftSize;
+	work.k = k;
+	work.minScore = minScore;
+	work.next = 0;
+	std::vector<std::thread> threads;
+
+	for (int i = 1; i < std::min(bank->threads, n); i++)
+	{
+		threads.push_back(std::thread(bank_worker, &work));
+	}
+	bank_worker(&work);
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+
+	// gather the matches in template order
+
+	detections->clear();
+	for (int i = 0; i < n; i++)
+	{
+		std::vector<TemplateDetection>& d = bank->templates[i].detections;
+		for (size_t j = 0; j < d.size(); j++)
+		{
+			d[j].templ = i;
+			detections->push_back(d[j]);
+		}
+	}
+	return (int) detections->size();
+}
+
+/******************************************************************************/
+
+void release_template_bank(TemplateBank** bank)
+{
+	if ((bank) && (*bank))
+	{
+		clear_template_bank(*bank);
+		for (int c = 0; c < 4; c++)
+		{
+			if ((*bank)->planes[c]) { cvReleaseImage(&((*bank)->planes[c])); }
+			if ((*bank)->frameSpectrum[c]) {
+				cvReleaseMat(&((*bank)->frameSpectrum[c]));
+			}
+		}
+		if ((*bank)->sum) { cvReleaseMat(&((*bank)->sum)); }
+		if ((*bank)->sqsum) { cvReleaseMat(&((*bank)->sqsum)); }
+		delete *bank;
+		*bank = NULL;
+	}
+}
+
+/******************************************************************************/
@@ -0,0 +1,188 @@
+// Module : normalised cross correlation template matching for
+//          template_matching.cc (coarse to fine over image pyramids)
+// usage: #include "ipcv_template.h" (link with the ipcv library)
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: with pyramid levels > 0 the template is matched over the whole of a
+// downsampled (cvPyrDown) copy of the frame and the best match is then only
+// refined in a small window around the candidate at each finer level, rather
+// than matched over the whole of the full resolution frame. In tracking mode
+// (set_template_tracking()) the search is further limited to a window around
+// the previous match - so its cost depends on the motion of the target, not
+// the size of the frame - falling back to a search of the whole frame when
+// the score of the best match in the window is below a threshold.
+
+// Each search is either spatial (cvMatchTemplate) or by FFT - the correlation
+// of each channel is computed as the product of the spectrum of the frame and
+// the (cached) spectrum of the template, and normalised with the sum of squares
+// of each window from an integral image - chosen (by default) on an estimate
+// of the cost of each for the size of the template and of the search.
+
+// A template bank (TemplateBank) matches many templates against each frame,
+// doing the work shared by the templates (channel split, integral image and
+// frame spectra) once per frame and the correlation of the templates in
+// parallel - returning the best k matches of each template (whole frame,
+// full resolution search only)
+
+#ifndef IPCV_TEMPLATE_H
+#define IPCV_TEMPLATE_H
+
+#include "cv.h"       // open cv general include file
+
+#include <vector>
+
+/******************************************************************************/
+
+#define IPCV_TEMPLATE_MAX_LEVELS 6		// maximum number of pyramid levels
+#define IPCV_TEMPLATE_MIN_SIZE 8		// minimum template width / height at
+										// the coarsest level (in pixels)
+#define IPCV_TEMPLATE_REFINE_RADIUS 3	// search radius at each finer level
+#define IPCV_TEMPLATE_TRACK_THRESHOLD 0.9	// default tracking score threshold
+
+// matching engines
+
+#define IPCV_TEMPLATE_AUTO 0		// choose per search (by estimated cost)
+#define IPCV_TEMPLATE_SPATIAL 1		// always cvMatchTemplate()
+#define IPCV_TEMPLATE_FFT 2			// always FFT correlation
+
+#define IPCV_TEMPLATE_FFT_MIN_SIZE 16	// smallest template (width / height)
+										// for which FFT is considered by AUTO
+
+// template matcher - the template pyramid is built once (when the template
+// is selected); the frame pyramid and response buffers are re-used (also
+// over a change of template)
+
+typedef struct TemplateMatcher
+{
+	int levels;				// pyramid levels used (0 = full resolution only)
+	IplImage* templ[IPCV_TEMPLATE_MAX_LEVELS + 1];	// template pyramid
+	IplImage* frame[IPCV_TEMPLATE_MAX_LEVELS + 1];	// frame pyramid (level 0
+													// is the frame itself)
+	CvMat* response;		// response of the (coarsest level) search - of the
+							// whole frame or of the tracking window
+	CvMat* refine;			// response of the search at the finer levels
+
+	CvMat responseHeader;	// (headers over the buffers, sized to the search)
+	CvMat refineHeader;
+	CvMat* responseBuffer;	// buffers (only ever grown)
+	CvMat* refineBuffer;
+
+	int margin;				// tracking margin in pixels (0 = no tracking)
+	double threshold;		// score below which to search the whole frame
+	bool found;				// previous match within tracking (above threshold)
+	CvPoint previous;		// location of the previous match
+	bool global;			// last search was of the whole frame
+	CvRect window;			// last search window (full resolution)
+
+	int engine;				// IPCV_TEMPLATE_{AUTO | SPATIAL | FFT}
+	CvSize spectrumSize[IPCV_TEMPLATE_MAX_LEVELS + 1];	// DFT size of the cached
+	CvMat* spectrum[IPCV_TEMPLATE_MAX_LEVELS + 1][4];	// template spectra (CCS
+														// packed, per channel)
+	double templSqSum[IPCV_TEMPLATE_MAX_LEVELS + 1];	// template sum of squares
+	IplImage* planes[4];	// FFT work buffers - channels of the search region,
+	CvMat* frameSpectrum;	// the spectrum of one channel, the (summed) product
+	CvMat* correlation;		// of the spectra / correlation and the integral
+	CvMat* product;			// images of the search region
+	CvMat* sum;
+	CvMat* sqsum;
+} TemplateMatcher;
+
+/******************************************************************************/
+
+// create a template matcher for a template (which is copied)
+
+// templ - template image (same depth / channels as the frames to search)
+// levels - number of pyramid levels to use (reduced, if needed, so that the
+//          template is at least IPCV_TEMPLATE_MIN_SIZE at the coarsest level)
+// return value - pointer to template matcher
+
+TemplateMatcher* create_template_matcher(const IplImage* templ, int levels = 0);
+
+// change the template of a matcher (as create_template_matcher(), but the
+// frame pyramid and response buffers are kept), clearing any tracking state
+
+void set_matcher_template(TemplateMatcher* matcher, const IplImage* templ, int levels = 0);
+
+// select tracking mode - search only within margin pixels of the previous
+// match, searching the whole frame if the best score there is below threshold
+
+// matcher - template matcher
+// margin - tracking margin in pixels (0 = search the whole of every frame)
+// threshold - normalised cross correlation score for a match to be tracked
+
+void set_template_tracking(TemplateMatcher* matcher, int margin,
+						   double threshold = IPCV_TEMPLATE_TRACK_THRESHOLD);
+
+// select the matching engine (IPCV_TEMPLATE_AUTO by default)
+
+void set_template_engine(TemplateMatcher* matcher, int engine);
+
+// find the best (CV_TM_CCORR_NORMED) match of the template in the frame
+
+// matcher - template matcher
+// frame - image to search (at least as large as the template)
+// location - returned top left position of the best match in the frame
+// return value - normalised cross correlation score of the best match
+
+double match_template(TemplateMatcher* matcher, IplImage* frame, CvPoint* location);
+
+// release the template matcher
+
+void release_template_matcher(TemplateMatcher** matcher);
+
+/******************************************************************************/
+
+// detection of a template of a template bank
+
+typedef struct TemplateDetection
+{
+	int templ;				// index of the template (in order of addition)
+	CvPoint location;		// top left position of the match in the frame
+	CvSize size;			// size of the template
+	double score;			// normalised cross correlation score
+} TemplateDetection;
+
+typedef struct TemplateBank TemplateBank;
+
+// create an (empty) template bank
+
+// engine - IPCV_TEMPLATE_{AUTO | SPATIAL | FFT} (per template, as above)
+// threads - number of templates correlated at once (0 = one per core)
+// return value - pointer to template bank
+
+TemplateBank* create_template_bank(int engine = IPCV_TEMPLATE_AUTO, int threads = 0);
+
+// add a template (which is copied) to the bank
+// return value - index of the template
+
+int add_bank_template(TemplateBank* bank, const IplImage* templ);
+
+// return the number of templates in the bank
+
+int bank_template_count(const TemplateBank* bank);
+
+// remove all of the templates (the per frame buffers are kept)
+
+void clear_template_bank(TemplateBank* bank);
+
+// find the best (up to k) matches of each template in the frame - a match
+// masks out the matches overlapping it by more than half the template size
+
+// bank - template bank
+// frame - image to search (same depth / channels as the templates)
+// k - maximum number of matches per template
+// minScore - minimum normalised cross correlation score of a match
+// detections - returned matches, in template order (best first for each)
+// return value - number of matches
+
+int match_template_bank(TemplateBank* bank, IplImage* frame, int k, double minScore,
+						std::vector<TemplateDetection>* detections);
+
+// release the template bank
+
+void release_template_bank(TemplateBank** bank);
+
+/******************************************************************************/
+
+#endif
@@ -0,0 +1,259 @@
+// Module : per frame, per stage timing instrumentation for the examples
+// usage: see ipcv_timing.h
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+#include "ipcv_timing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm> // contains sort() function (amongst others)
+
+/******************************************************************************/
+
+// timing state for one stage
+
+struct TimingStage
+{
+	std::string name;				// stage name
+	int64 frameTicks;				// ticks so far in the current frame
+	bool timedThisFrame;			// stage has been timed in the current frame
+	std::vector<double> samples;	// per frame times (ms)
+};
+
+// global state (as ipcv_interface.cc, the examples are single threaded loops)
+
+bool ipcvTimingEnabled = false;				// timing enabled
+static const char* reportFile = NULL;		// file for the summary
+static std::vector<TimingStage> stages;		// standard + named stages
+static std::vector<double> frameSamples;	// per frame total times (ms)
+static int64 frameStart = 0;				// start of frame (0 = not started)
+static bool reported = false;				// summary already written
+
+/******************************************************************************/
+
+// add a new stage
+
+static int add_stage(const char* name)
+{
+	TimingStage stage;
+	stage.name = name;
+	stage.frameTicks = 0;
+	stage.timedThisFrame = false;
+	stages.push_back(stage);
+	return (int) stages.size() - 1;
+}
+
+// register the standard stages (always the first IPCV_TIMING_STANDARD_STAGES)
+
+static void add_standard_stages()
+{
+	if (stages.empty())
+	{
+		add_stage("capture");
+		add_stage("convert");
+		add_stage("process");
+		add_stage("display");
+	}
+}
+
+/******************************************************************************/
+
+// summary statistics of a set of per frame times (percentiles by nearest rank)
+
+struct TimingSummary
+{
+	size_t frames;
+	double mean, p50, p95, p99, max;
+};
+
+// p-th percentile (nearest rank) of a sorted set of (at least one) times
+
+static double percentile(const std::vector<double>& sorted, double p)
+{
+	size_t rank = (size_t) ceil(p * sorted.size());
+	return sorted[std::min(std::max(rank, (size_t) 1), sorted.size()) - 1];
+}
+
+static TimingSummary summarise(std::vector<double> samples)
+{
+	TimingSummary s;
+	memset(&s, 0, sizeof(s));
+
+	s.frames = samples.size();
+	if (samples.empty()) {
+		return s;
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0;
+	for (size_t i = 0; i < samples.size(); i++) {
+		sum += samples[i];
+	}
+	s.mean = sum / samples.size();
+
+	s.p50 = percentile(samples, 0.50);
+	s.p95 = percentile(samples, 0.95);
+	s.p99 = percentile(samples, 0.99);
+	s.max = samples.back();
+
+	return s;
+}
+
+/******************************************************************************/
+
+// atexit() handler (the examples exit() at the end of a video file)
+
+static void report_at_exit()
+{
+	ipcv_timing_report();
+}
+
+/******************************************************************************/
+
+void ipcv_timing_enable(const char* filename)
+{
+	add_standard_stages();
+
+	if (!ipcvTimingEnabled) {
+		atexit(report_at_exit);
+	}
+
+	ipcvTimingEnabled = true;
+	reportFile = filename;
+}
+
+/******************************************************************************/
+
+int ipcv_timing_stage(const char* name)
+{
+	add_standard_stages();
+
+	for (size_t i = 0; i < stages.size(); i++)
+	{
+		if (stages[i].name == name) {
+			return (int) i;
+		}
+	}
+	return add_stage(name);
+}
+
+/******************************************************************************/
+
+void ipcv_timing_add(int stage, int64 ticks)
+{
+	if ((!ipcvTimingEnabled) || (stage < 0) || (stage >= (int) stages.size())) {
+		return;
+	}
+
+	stages[stage].frameTicks += ticks;
+	stages[stage].timedThisFrame = true;
+}
+
+/******************************************************************************/
+
+void ipcv_timing_end_frame()
+{
+	if (!ipcvTimingEnabled) {
+		return;
+	}
+
+	double msPerTick = 1000.0 / cv::getTickFrequency();
+
+	for (size_t i = 0; i < stages.size(); i++)
+	{
+		if (stages[i].timedThisFrame) {
+			stages[i].samples.push_back(stages[i].frameTicks * msPerTick);
+		}
+		stages[i].frameTicks = 0;
+		stages[i].timedThisFrame = false;
+	}
+
+	// the first frame has no start time (and includes the set up of the
+	// example) so its total is not recorded
+
+	if (frameStart) {
+		frameSamples.push_back((cv::getTickCount() - frameStart) * msPerTick);
+	}
+	frameStart = 0;
+}
+
+/******************************************************************************/
+
+void ipcv_timing_start_frame()
+{
+	if (ipcvTimingEnabled) {
+		frameStart = cv::getTickCount();
+	}
+}
+
+/******************************************************************************/
+
+void ipcv_timing_report()
+{
+	if ((!ipcvTimingEnabled) || reported) {
+		return;
+	}
+	reported = true;
+
+	FILE* file = fopen(reportFile, "w");
+	if (!file) {
+		printf("ERROR: cannot open timing output file %s\n", reportFile);
+		return;
+	}
+
+	size_t len = strlen(reportFile);
+	bool json = ((len >= 5) && (!strcmp(reportFile + len - 5, ".json")));
+
+	if (json) {
+		fprintf(file, "{\n  \"units\": \"ms\",\n  \"stages\": [\n");
+	} else {
+		fprintf(file, "stage,frames,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n");
+	}
+
+	// each stage that has been timed followed by the frame total
+
+	bool first = true;
+	for (size_t i = 0; i <= stages.size(); i++)
+	{
+		const char* name = (i < stages.size()) ? stages[i].name.c_str() : "frame";
+		TimingSummary s =
+			summarise((i < stages.size()) ? stages[i].samples : frameSamples);
+
+		if (s.frames == 0) {
+			continue;
+		}
+
+		if (json) {
+			fprintf(file, "%s    {\"stage\": \"%s\", \"frames\": %lu, "
+					"\"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, "
+					"\"p99\": %.4f, \"max\": %.4f}",
+					first ? "" : ",\n", name, (unsigned long) s.frames,
+					s.mean, s.p50, s.p95, s.p99, s.max);
+		} else {
+			fprintf(file, "%s,%lu,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+					name, (unsigned long) s.frames,
+					s.mean, s.p50, s.p95, s.p99, s.max);
+		}
+
+		printf("Timing %-10s : mean %8.3f ms  p50 %8.3f  p95 %8.3f  p99 %8.3f\n",
+				name, s.mean, s.p50, s.p95, s.p99);
+
+		first = false;
+	}
+
+	if (json) {
+		fprintf(file, "\n  ]\n}\n");
+	}
+
+	fclose(file);
+
+	printf("Timing summary written to %s\n", reportFile);
+}
+
+/******************************************************************************/
@@ -0,0 +1,110 @@
+// Module : per frame, per stage timing instrumentation for the examples
+// usage: #include "ipcv_timing.h" (link with the ipcv library)
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: timing is enabled with --timing <file> on the command line (see
+// ipcv_parse_options()). Each frame (ended by ipcv_wait_key()) the time spent
+// in each stage is summed and at exit the per frame times are summarised as
+// mean / p50 / p95 / p99 / max (in ms) and written to <file> as CSV (or JSON
+// if <file> ends in .json). When disabled a scoped timer is a single test of
+// a global flag, so the instrumentation can be left in place.
+
+// capture (query_frame_source() or ipcv_query_frame()) and display
+// (ipcv_show_image()) are timed automatically; examples time their colour
+// conversion and core processing with IpcvScopedTimer (or, for a span of code
+// that is not one scope, ipcv_timing_start() / ipcv_timing_stop()) as below
+
+#ifndef IPCV_TIMING_H
+#define IPCV_TIMING_H
+
+#include "cv.h"       // open cv general include file
+
+/******************************************************************************/
+
+// the standard stages of an example's main loop (further named stages can be
+// added with ipcv_timing_stage())
+
+enum
+{
+	IPCV_TIMING_CAPTURE = 0,	// getting the next frame (decode / camera)
+	IPCV_TIMING_CONVERT,		// colour conversion of the frame
+	IPCV_TIMING_PROCESS,		// the core algorithm of the example
+	IPCV_TIMING_DISPLAY,		// displaying (or writing) the output images
+	IPCV_TIMING_STANDARD_STAGES
+};
+
+/******************************************************************************/
+
+// enable timing, with the summary written to filename at exit
+
+void ipcv_timing_enable(const char* filename);
+
+// return true if timing is enabled
+
+extern bool ipcvTimingEnabled;
+inline bool ipcv_timing_enabled() { return ipcvTimingEnabled; }
+
+// return the identifier of the named stage (registering it if new)
+
+int ipcv_timing_stage(const char* name);
+
+// add ticks (as cv::getTickCount()) to the total of a stage for this frame
+
+void ipcv_timing_add(int stage, int64 ticks);
+
+// end the current frame - its stage totals (and the total time since the end
+// of the previous frame) are recorded (N.B. called by ipcv_wait_key(), which
+// then restarts the frame timer so the wait itself is not counted)
+
+void ipcv_timing_end_frame();
+void ipcv_timing_start_frame();
+
+// write the summary now (rather than at exit)
+
+void ipcv_timing_report();
+
+/******************************************************************************/
+
+// times the enclosing scope as part of a stage, e.g.
+
+// { IpcvScopedTimer t(IPCV_TIMING_CONVERT); cvCvtColor(img, gray, CV_BGR2GRAY); }
+
+class IpcvScopedTimer
+{
+public:
+	explicit IpcvScopedTimer(int stage)
+		: stageId(stage), start(ipcvTimingEnabled ? cv::getTickCount() : 0) {}
+	~IpcvScopedTimer()
+	{
+		if (start) {
+			ipcv_timing_add(stageId, cv::getTickCount() - start);
+		}
+	}
+
+private:
+	int stageId;
+	int64 start;
+};
+
+// times a span of code (that is not one scope) as part of a stage, e.g.
+
+// int64 start = ipcv_timing_start();
+// ...
+// ipcv_timing_stop(IPCV_TIMING_PROCESS, start);
+
+inline int64 ipcv_timing_start()
+{
+	return ipcvTimingEnabled ? cv::getTickCount() : 0;
+}
+
+inline void ipcv_timing_stop(int stage, int64 start)
+{
+	if (start) {
+		ipcv_timing_add(stage, cv::getTickCount() - start);
+	}
+}
+
+/******************************************************************************/
+
+#endif
@@ -9,6 +9,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -30,6 +33,10 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
   IplImage* jpeg = NULL;      // image object
   CvCapture* capture = NULL; // capture object
@@ -56,10 +63,10 @@ int main( int argc, char** argv )
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowNameSrc, 0);
-	  cvNamedWindow(windowNameJPEG, 0);
-	  cvNamedWindow(windowNameDiff, 0);
-	  cvCreateTrackbar("Scale", windowNameDiff, &scaleFactor, 255, NULL);
+      ipcv_named_window(windowNameSrc, 0);
+	  ipcv_named_window(windowNameJPEG, 0);
+	  ipcv_named_window(windowNameDiff, 0);
+	  ipcv_create_trackbar("Scale", windowNameDiff, &scaleFactor, 255, NULL);
 
 	  // print out image size
 
@@ -67,10 +74,10 @@ int main( int argc, char** argv )
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -97,10 +104,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame is just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -120,6 +127,8 @@ int main( int argc, char** argv )
 
 		  // save image as JPEG and then reload it
 
+		  int64 processStart = ipcv_timing_start(); // (timing of JPEG compression)
+
 		  cvSaveImage("output.jpg", img);
 		  jpeg = cvLoadImage("output.jpg", CV_LOAD_IMAGE_UNCHANGED);
 
@@ -129,11 +138,13 @@ int main( int argc, char** argv )
 		  cvAbsDiff(img, jpeg, diff);
           cvConvertScale(diff, diff, scaleFactor, 0);
 
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 		  // display image in window
 
-		  cvShowImage( windowNameSrc, img );
-		  cvShowImage( windowNameJPEG, jpeg );
-		  cvShowImage( windowNameDiff, diff );
+		  ipcv_show_image( windowNameSrc, img );
+		  ipcv_show_image( windowNameJPEG, jpeg );
+		  ipcv_show_image( windowNameDiff, diff );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
@@ -142,7 +153,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -157,7 +168,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
@@ -9,6 +9,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -30,6 +33,10 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
   IplImage*	LABimg = NULL;   // HAV image object
   CvCapture* capture = NULL; // capture object
@@ -55,20 +62,20 @@ int main( int argc, char** argv )
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
-	  cvNamedWindow(windowNameL, 0);
-	  cvNamedWindow(windowNameA, 0);
-	  cvNamedWindow(windowNameB, 0);
+      ipcv_named_window(windowName, 0);
+	  ipcv_named_window(windowNameL, 0);
+	  ipcv_named_window(windowNameA, 0);
+	  ipcv_named_window(windowNameB, 0);
 
 	  // define required channel images for display processing
 	  // (if using a capture object we need to get a frame first to get the size)
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -105,10 +112,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -128,18 +135,22 @@ int main( int argc, char** argv )
 
 		  // colour transform images
 
+		  int64 processStart = ipcv_timing_start(); // (timing of colour space conversion)
+
 		  cvCvtColor(img, LABimg, CV_BGR2Lab);
 
 		  // split image into channels remembering BGR ordering of OpenCV
 
 		  cvSplit(LABimg, l_channel, a_channel, b_channel, NULL);
 
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 		  // display images in windows
 
-		  cvShowImage( windowName, img );
-		  cvShowImage( windowNameL, l_channel );
-		  cvShowImage( windowNameA, a_channel );
-		  cvShowImage( windowNameB, b_channel );
+		  ipcv_show_image( windowName, img );
+		  ipcv_show_image( windowNameL, l_channel );
+		  ipcv_show_image( windowNameA, a_channel );
+		  ipcv_show_image( windowNameB, b_channel );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 4 ms roughly equates to 100ms/25fps = 4ms per frame
@@ -148,7 +159,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -163,7 +174,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
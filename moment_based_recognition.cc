@@ -7,10 +7,21 @@
 // Copyright (c) 2010 School of Engineering, Cranfield University
 // License : LGPL - http://www.gnu.org/licenses/lgpl.html
 
+// Notes: the Hu moments of each colour channel of a sample image are computed
+// once, when it is captured, so that recognition compares the 21 stored
+// moments of each sample with those of the current image (exactly as
+// cvMatchShapes() with CV_CONTOURS_MATCH_I2) - rather than splitting every
+// sample image and computing its moments again for every comparison
+
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>    // standard C/C++ includes
+#include <math.h>
+#include <vector>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
 
@@ -28,6 +39,69 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 
 /******************************************************************************/
 
+// moments of magnitude below this are not compared (as cvMatchShapes())
+
+#define HU_MOMENT_EPS 1.e-5
+
+// the 7 Hu moments of each of the 3 colour channels of an image, stored as
+// compared by cvMatchShapes(CV_CONTOURS_MATCH_I2), i.e. sign(h) log10(|h|)
+
+typedef struct ColourHuMoments
+{
+	double m[3][7];			// sign(h) log10(|h|) of each moment h
+	bool used[3][7];		// |h| > HU_MOMENT_EPS
+} ColourHuMoments;
+
+/******************************************************************************/
+
+// calculate the Hu moments of each channel of a colour image (each channel
+// selected as the channel of interest, so no cvSplit() is needed)
+
+void calc_colour_hu_moments(IplImage* img, ColourHuMoments* hu)
+{
+	for (int c = 0; c < 3; c++)
+	{
+		CvMoments moments;
+		CvHuMoments huMoments;
+
+		cvSetImageCOI(img, c + 1);
+		cvMoments(img, &moments, 0);
+		cvGetHuMoments(&moments, &huMoments);
+
+		double h[7] = {huMoments.hu1, huMoments.hu2, huMoments.hu3, huMoments.hu4,
+					   huMoments.hu5, huMoments.hu6, huMoments.hu7};
+		for (int i = 0; i < 7; i++)
+		{
+			double a = fabs(h[i]);
+			hu->used[c][i] = (a > HU_MOMENT_EPS);
+			hu->m[c][i] = (hu->used[c][i]) ? ((h[i] > 0) ? 1 : -1) * log10(a) : 0;
+		}
+	}
+	cvSetImageCOI(img, 0);
+}
+
+// distance between the moments of two images - the sum over the channels of
+// cvMatchShapes(CV_CONTOURS_MATCH_I2), SUM(|m_a - m_b|) over the moments
+// used in both
+
+double match_colour_hu_moments(const ColourHuMoments* a, const ColourHuMoments* b)
+{
+	double diff = 0;
+
+	for (int c = 0; c < 3; c++)
+	{
+		for (int i = 0; i < 7; i++)
+		{
+			if ((a->used[c][i]) && (b->used[c][i])) {
+				diff += fabs(b->m[c][i] - a->m[c][i]);
+			}
+		}
+	}
+	return diff;
+}
+
+/******************************************************************************/
+
 void printhelp(){
 	printf("\nControls: \n");
 	printf("\tspace = capture a sample image\n");
@@ -42,6 +116,10 @@ void printhelp(){
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
   CvCapture* capture = NULL; // capture object
 
@@ -51,13 +129,11 @@ int main( int argc, char** argv )
   char key;						// user input
   int  EVENT_LOOP_DELAY = 40;	// delay for GUI window
                                 // 40 ms equates to 1000ms/25fps = 40ms per frame
-  // max sample images
-
-  #define MAX_NUMBER_OF_SAMPLE_IMAGES 255
-
-  // input images
+  // input images (and their Hu moments)
 
-  IplImage* input[MAX_NUMBER_OF_SAMPLE_IMAGES];
+  std::vector<IplImage*> input;
+  std::vector<ColourHuMoments> inputMoments;
+  ColourHuMoments currentMoments;
 
 
   int imagesCollected = 0;			// number of sample images collected
@@ -79,7 +155,7 @@ int main( int argc, char** argv )
 
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
+      ipcv_named_window(windowName, 0);
 
 	  // set up font structure
 
@@ -91,10 +167,10 @@ int main( int argc, char** argv )
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -112,21 +188,6 @@ int main( int argc, char** argv )
 		exit(1);
 	  }
 
-	  // create 2 sets of RGB colour channels for comparision
-
-	  IplImage* channelR =
-	  			cvCreateImage(cvSize(img->width,img->height), img->depth, 1);
-	  IplImage* channelG =
-	  			cvCreateImage(cvSize(img->width,img->height), img->depth, 1);
-	  IplImage* channelB =
-	  			cvCreateImage(cvSize(img->width,img->height), img->depth, 1);
-	  IplImage* channelR_2 =
-	  			cvCreateImage(cvSize(img->width,img->height), img->depth, 1);
-	  IplImage* channelG_2 =
-	  			cvCreateImage(cvSize(img->width,img->height), img->depth, 1);
-	  IplImage* channelB_2 =
-	  			cvCreateImage(cvSize(img->width,img->height), img->depth, 1);
-
 	  // start main loop
 
 	  while (keepProcessing) {
@@ -138,10 +199,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame is just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -162,7 +223,7 @@ int main( int argc, char** argv )
 			cvPutText(img, "RECOGNITION",
 			  		cvPoint(10,img->height - 20), &font, CV_RGB(255, 0 ,0));
 		  }
-		  cvShowImage( windowName, img );
+		  ipcv_show_image( windowName, img );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
@@ -171,7 +232,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -186,20 +247,16 @@ int main( int argc, char** argv )
 	   		// if user presses " " then capture a sample image
 
 			if (!recognitionStage) {
-				 if (imagesCollected < MAX_NUMBER_OF_SAMPLE_IMAGES)
-				 {
-					// copy image and store it
 
-				    input[imagesCollected] = cvCloneImage(img);
+					// copy image and store it (with its Hu moments)
+
+				    input.push_back(cvCloneImage(img));
+					calc_colour_hu_moments(img, &currentMoments);
+					inputMoments.push_back(currentMoments);
 
 					imagesCollected++;
 
 					printf("Sample image collected - %i\n", imagesCollected);
-
-				 } else {
-					printf("ERROR: Maximum sample images (%d) collected.\n",
-													 imagesCollected);
-				 }
 		   }
 
 		  } else if ((key == '\n') || (key == 'm')) { // use "m" in windows
@@ -216,9 +273,11 @@ int main( int argc, char** argv )
 
 			// if user presses "r" then do recognition
 
-			  // get the colour channels (rememeber - BGR!)
+			  int64 processStart = ipcv_timing_start(); // (timing of recognition)
+
+			  // get the Hu moments of the colour channels
 
-			  cvSplit(img, channelB, channelG, channelR, NULL);
+			  calc_colour_hu_moments(img, &currentMoments);
 
 			  // compare images using Hu moments of colour image channels
 
@@ -231,22 +290,14 @@ int main( int argc, char** argv )
 
 				for (int i = 0; i < imagesCollected; i++)
 				{
-					// get the colour channels (rememeber - BGR!)
-
-					cvSplit(input[i], channelB_2, channelG_2, channelR_2, NULL);
-
 					// see opencv manual for how cvMatchShapes() works but essentially
 					// we are doing SUM(Mi1 - Mi2) for images for Hu moment i = {1 ... 7}
-					// and images 1 to 7
+					// and images 1 to 7 (here from the stored moments of each)
 					// Hu moments are position, orientation and scale invarient
 					// moments of shape derived from the central normalised moments
 
-					double diff = (cvMatchShapes(channelB, channelB_2,
-                      								CV_CONTOURS_MATCH_I2, 0 ) +
-								  cvMatchShapes(channelG, channelG_2,
-                      								CV_CONTOURS_MATCH_I2, 0 ) +
-								  cvMatchShapes(channelR, channelR_2,
-                      								CV_CONTOURS_MATCH_I2, 0 ));
+					double diff = match_colour_hu_moments(&currentMoments,
+														  &(inputMoments[i]));
 
 					printf("Comparison image %i = %.3f\n", i, diff);
 
@@ -257,6 +308,8 @@ int main( int argc, char** argv )
 					}
 				}
 
+				ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 				printf("\n");
 
 				// output the result in a window
@@ -264,10 +317,10 @@ int main( int argc, char** argv )
 				printf("Recognition - closest matching image = %d\n", closestImage);
 				printf("Press any key to clear. \n\n");
 
-				cvNamedWindow("Recognition Result", 1 );
-                cvShowImage("Recognition Result", input[closestImage]);
-				cvWaitKey(0);
-				cvDestroyWindow("Recognition Result");
+				ipcv_named_window("Recognition Result", 1 );
+                ipcv_show_image("Recognition Result", input[closestImage]);
+				ipcv_wait_key(0);
+				ipcv_destroy_window("Recognition Result");
 
 			} else {
 				printf("ERROR - need to enter recognition stage first.\n");
@@ -278,7 +331,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image objects (if it does not originate from a capture object)
 
@@ -287,13 +340,6 @@ int main( int argc, char** argv )
 	  } else {
 		  cvReleaseCapture ( &capture );
 	  }
-	  cvReleaseImage(&channelB);
-	  cvReleaseImage(&channelG);
-	  cvReleaseImage(&channelR);
-	  cvReleaseImage(&channelB_2);
-	  cvReleaseImage(&channelG_2);
-	  cvReleaseImage(&channelR_2);
-
 	  for (int i = 0; i < imagesCollected; i++)
 		  {
 			  cvReleaseImage( &(input[i]));
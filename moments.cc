@@ -9,6 +9,10 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+#include "ipcv_contours.h" // shared contour functions
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -27,46 +31,13 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 
 /******************************************************************************/
 
-// find the largest contour (by area) from a sequence of contours and return a
-// pointer to that item in the sequence
-
-CvSeq* findLargestContour(CvSeq* contours){
-
-  CvSeq* current_contour = contours;
-  double largestArea = 0;
-  CvSeq* largest_contour = NULL;
-
-  // check we at least have some contours
-
-  if (contours == NULL){return NULL;}
-
-  // for each contour compare it to current largest area on
-  // record and remember the contour with the largest area
-  // (note the use of fabs() for the cvContourArea() function)
-
-  while (current_contour != NULL){
-
-	  double area = fabs(cvContourArea(current_contour));
-
-	  if(area > largestArea){
-		  largestArea = area;
-		  largest_contour = current_contour;
-	  }
-
-	  current_contour = current_contour->h_next;
-  }
-
-  // return pointer to largest
-
-  return largest_contour;
-
-}
-
-/******************************************************************************/
-
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img;  			 		// input image object
   IplImage* grayImg = NULL;  		// tmp image object
   IplImage* thresholdedImg = NULL;  // thresholded image object
@@ -110,14 +81,14 @@ int main( int argc, char** argv )
     {
       // create window objects
 
-      cvNamedWindow(windowName1, 0 );
-      cvNamedWindow(windowName2, 0 );
+      ipcv_named_window(windowName1, 0 );
+      ipcv_named_window(windowName2, 0 );
 
 	  // add adjustable trackbar for threshold parameter
 
-      cvCreateTrackbar("Neighbourhood (N)", windowName1, &windowSize, 255, NULL);
-	  cvCreateTrackbar("Constant (C)", windowName1, &constant, 50, NULL);
-	  cvCreateTrackbar("Closing", windowName1, &iterations, 25, NULL);
+      ipcv_create_trackbar("Neighbourhood (N)", windowName1, &windowSize, 255, NULL);
+	  ipcv_create_trackbar("Constant (C)", windowName1, &constant, 50, NULL);
+	  ipcv_create_trackbar("Closing", windowName1, &iterations, 25, NULL);
 
 	  // set up font structure
 
@@ -129,10 +100,10 @@ int main( int argc, char** argv )
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -167,10 +138,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -185,11 +156,14 @@ int main( int argc, char** argv )
 		  // if input is not already grayscale, convert to grayscale
 
 		  if (img->nChannels > 1){
+			 IpcvScopedTimer timer(IPCV_TIMING_CONVERT);
 			 cvCvtColor(img, grayImg, CV_BGR2GRAY);
 	      } else {
 			grayImg = img;
 		  }
 
+		  int64 processStart = ipcv_timing_start(); // (timing of segmentation)
+
 		  // check that the window size is always odd and > 3
 
 		  if ((windowSize > 3) && (fmod((double) windowSize, 2) == 0)) {
@@ -213,13 +187,17 @@ int main( int argc, char** argv )
 		   cvMorphologyEx(thresholdedImg, closeImage, NULL, structuringElement,
 		  											CV_MOP_CLOSE, iterations);
 
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 
 		  // display image in window
 
-		  cvShowImage( windowName1, closeImage );
+		  ipcv_show_image( windowName1, closeImage );
 
 		  // find the contours
 
+		  processStart = ipcv_timing_start();
+
 		  cvFindContours( closeImage, storage,
 		  		&contours, sizeof(CvContour), CV_RETR_EXTERNAL,
 		   		CV_CHAIN_APPROX_SIMPLE );
@@ -263,9 +241,11 @@ int main( int argc, char** argv )
 				cvClearSeq(contours);
 		  }
 
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 		  // display image in window
 
-		  cvShowImage( windowName2, output );
+		  ipcv_show_image( windowName2, output );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 40ms per frame
@@ -274,7 +254,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -289,7 +269,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
@@ -0,0 +1,324 @@
+// Example : CAMSIFT based tracking of multiple objects for video / camera
+// usage: prog [--track <margin>] [--roi <x,y,w,h>] {<video_name>}
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: as camshift_tracking.cc, but with any number of targets (each region
+// selected with the mouse adds one) each with its own hue histogram and track
+// window, held by a CAMSHIFT tracker (see ipcv_camshift.h) - the hue channel
+// and mask are computed once per frame for all of the targets and the targets
+// are tracked in parallel (each only within --track <margin> pixels of its
+// track window, if given, which is much faster for many small targets)
+
+#include "cv.h"       // open cv general include file
+#include "highgui.h"  // open cv GUI include file
+
+#include "ipcv_frame_source.h" // threaded prefetching frame source
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+#include "ipcv_camshift.h" // multiple target CAMSHIFT tracker
+
+#include <stdio.h>
+#include <algorithm>
+using namespace std;
+using namespace cv;
+
+/******************************************************************************/
+// setup the cameras properly based on OS platform
+
+// 0 in linux gives first camera for v4l
+//-1 in windows gives first device or user dialog selection
+
+#ifdef linux
+	#define CAMERA_INDEX 0
+#else
+	#define CAMERA_INDEX -1
+#endif
+
+/******************************************************************************/
+
+// global variables (bad pratice yes, but an easy option for a simple demo)
+
+static CvRect selection;		// the area selected by the mouse
+static int select_object = 0;	// has an area been selected
+static CvPoint origin;			// the origin of the selection
+static int image_height;		// height of image
+static int image_origin;		// image origin
+
+// colours for each target (in turn)
+
+static const CvScalar colours[] = {CV_RGB(255, 0, 0), CV_RGB(0, 255, 0),
+	CV_RGB(0, 0, 255), CV_RGB(255, 255, 0), CV_RGB(0, 255, 255),
+	CV_RGB(255, 0, 255), CV_RGB(255, 128, 0), CV_RGB(128, 0, 255)};
+
+/******************************************************************************/
+
+// Mouse callback function: records a selected ROI in the image
+// parameters:
+// event - opencv mouse event type
+// x - x position of mouse event
+// y - y position of mouse event
+// param - unused
+
+// Notes: based on OpenCV 1.0 camshiftdemo.c example
+
+void set_selected_roi( int event, int x, int y, int flags, void* param )
+{
+	// if we have already clicked and are selecting a region update
+	// the global variable selection
+
+	// first flip the y co-ordinate so we get the correct point
+	// in the image (dependent on image origin)
+
+	if (image_origin)
+		y = image_height - y;
+
+    if( select_object )
+    {
+        selection.x = min(x,origin.x);
+        selection.y = min(y,origin.y);
+        selection.width = selection.x + CV_IABS(x - origin.x);
+        selection.height = selection.y + CV_IABS(y - origin.y);
+
+        selection.x = max( selection.x, 0 );
+        selection.y = max( selection.y, 0 );
+        selection.width -= selection.x;
+        selection.height -= selection.y;
+    }
+
+    switch( event )
+    {
+    case CV_EVENT_LBUTTONDOWN:
+        origin = cvPoint(x,y);
+        selection = cvRect(x,y,0,0);
+        select_object = 1;
+        break;
+    case CV_EVENT_LBUTTONUP:
+        select_object = 0;
+        break;
+    }
+}
+
+/******************************************************************************/
+
+int main( int argc, char** argv )
+{
+
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv, IPCV_REPLAY_INPUT);
+
+  IplImage* img = NULL;      // image object (main)
+
+  FrameSource* source = NULL; // frame source (video, camera or replay)
+  CamshiftTracker* tracker = NULL; // tracker (all of the targets)
+
+  char const * windowName = "Multiple Object CAMSHIFT Tracking"; // window name
+  char const * windowName2 = "Variance / Saturation Mask"; // window name
+
+  bool keepProcessing = true;	// loop control flag
+  char key;						// user input
+  int  EVENT_LOOP_DELAY = 40;	// delay for GUI window
+                                // 40 ms equates to 1000ms/25fps = 40ms per frame
+
+  int vmin = 10, vmax = 256, smin = 30; // min/max values for Variance/Saturation mask
+
+  // if command line arguments are provided try to read image/video_name
+  // otherwise default to capture from attached H/W camera
+
+    if ((source = create_input_frame_source(argc, argv, CAMERA_INDEX)) != 0)
+    {
+      // create window object (use flag=0 to allow resize, 1 to auto fix size)
+
+      ipcv_named_window(windowName, 0);
+	  ipcv_named_window(windowName2, 0);
+
+	  ipcv_create_trackbar( "Vmin", windowName2, &vmin, 256, 0 );
+      ipcv_create_trackbar( "Vmax", windowName2, &vmax, 256, 0 );
+      ipcv_create_trackbar( "Smin", windowName2, &smin, 256, 0 );
+
+	  printf("\nSelect a region to add a target, press 'c' to clear all targets\n\n");
+
+	  // setup mouse callback
+
+	  ipcv_set_mouse_callback(windowName, set_selected_roi, 0 );
+
+	  // set initial selection to zero
+
+	  selection.width = 0;
+	  selection.height = 0;
+
+	 // do initial capture to get all the buffer sizes
+
+	  img = query_frame_source(source);
+	  if(!img){
+			if (argc == 2){
+					printf("End of video file reached\n");
+			} else {
+					printf("ERROR: cannot get next fram from camera\n");
+			}
+					exit(1);
+	  }
+
+	  // (or to that given on the command line, clipped to the frame)
+
+	  ipcv_initial_roi(&selection, cvGetSize(img));
+
+       // allocate all the required buffers
+
+            IplImage* hue = cvCreateImage( cvGetSize(img), 8, 1 );
+			hue->origin = img->origin;
+            IplImage* mask = cvCloneImage(hue);
+
+	  // create the tracker (searching within the tracking margin, if given,
+	  // of each target and with one thread per core)
+
+	  tracker = create_camshift_tracker(16, ipcv_track_margin());
+
+	  // start main loop
+
+	  while (keepProcessing) {
+
+          int64 timeStart = getTickCount(); // get time at start of loop
+
+		  // capture object in use (i.e. video/camera)
+		  // get image from capture object
+
+			  img = query_frame_source(source);
+			  if(!img){
+				if (argc == 2){
+					printf("End of video file reached\n");
+				} else {
+					printf("ERROR: cannot get next fram from camera\n");
+				}
+				exit(0);
+			  }
+			  image_origin = img->origin;
+			  image_height = img->height;
+
+		  // *** CAMSIFT Histogram based tracking code
+
+		    // the hue channel and mask of the whole frame (once, for all of
+		    // the targets)
+
+			 int64 convertStart = ipcv_timing_start(); // (timing of conversion)
+
+			 hue_and_mask( img, hue, mask, cvRect(0, 0, img->width, img->height),
+						   smin, vmin, vmax );
+
+			ipcv_timing_stop(IPCV_TIMING_CONVERT, convertStart);
+
+			// if we have selected a new target area within the image add it
+			// to the tracker (with the histogram of its hue channel)
+
+			if ( (!(select_object)) && (selection.width > 0) && (selection.height > 0))
+			{
+				selection.width = min( selection.width, img->width - selection.x );
+        		selection.height = min( selection.height, img->height - selection.y );
+
+				int t = add_camshift_target(tracker, hue, mask, selection);
+				printf("Target %i added\n", t);
+
+				selection.width = 0;
+				selection.height = 0;
+			}
+
+			// track all of the targets
+
+			{
+				IpcvScopedTimer timer(IPCV_TIMING_PROCESS);
+
+				track_camshift_targets(tracker, hue, mask);
+			}
+
+			// draw the targets tracked (taking into account image origin)
+
+			for (size_t i = 0; i < tracker->targets.size(); i++)
+			{
+				CamshiftTarget& t = tracker->targets[i];
+				if (t.tracked)
+				{
+					CvBox2D box = t.box;
+					if( img->origin ) {
+						box.angle = -box.angle;
+					}
+					cvEllipseBox( img, box,
+								  colours[i % (sizeof(colours) / sizeof(colours[0]))],
+								  3, CV_AA, 0 );
+				}
+			}
+
+		    // if we have a selection then mark it on the image as
+		    // we make it with the mouse
+
+        	if( select_object && (selection.width > 0) && (selection.height > 0) )
+       		{
+				selection.width = min( selection.width, img->width );
+        		selection.height = min( selection.height, img->height );
+
+            	cvSetImageROI( img, selection );
+            	cvXorS( img, cvScalarAll(255), img, 0 );
+            	cvResetImageROI( img );
+        	}
+
+		  // ***
+
+		  // display image in window
+
+		  ipcv_show_image( windowName, img );
+		  ipcv_show_image( windowName2, mask );
+
+		  // start event processing loop (very important,in fact essential for GUI)
+	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
+
+		  // here we take account of processing time for the loop by subtracting the time
+          // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
+          // we get a +ve wait time
+
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
+                        (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
+
+		  if (key == 'x'){
+
+	   		// if user presses "x" then exit
+
+	   			printf("Keyboard exit requested : exiting now - bye!\n");
+	   			keepProcessing = false;
+		  } else if (key == 'c'){
+
+	   		// if user presses "c" then remove all of the targets
+
+				printf("\nTargets cleared by user request\n");
+
+				clear_camshift_targets(tracker);
+				selection.width = 0;
+				selection.height = 0;
+		  }
+	  }
+
+      // destroy window objects
+      // (triggered by event loop *only* window is closed)
+
+      ipcv_destroy_all_windows();
+
+      // destroy image objects (if it does not originate from a capture object)
+
+	  cvReleaseImage ( &mask  );
+	  cvReleaseImage ( &hue);
+
+	  release_camshift_tracker(&tracker);
+
+	  // release frame source (and capture device)
+
+	  release_frame_source(&source);
+
+      // all OK : main returns 0
+
+      return 0;
+    }
+
+    // not OK : main returns -1
+
+    return -1;
+}
+/******************************************************************************/
@@ -0,0 +1,349 @@
+// Example : multiple template matching for video / camera
+// usage: prog [--top <k>] [--min-score <score>] [--templates <image>[,<image> ...]]
+//             [--roi <x,y,w,h>] {<video_name>}
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: as template_matching.cc, but with any number of templates (loaded
+// from image files and / or selected with the mouse) matched against each
+// frame by a template bank (see ipcv_template.h) - the frame is prepared once
+// for all of the templates and the templates are correlated in parallel, with
+// the best k matches of each drawn
+
+#include "cv.h"       // open cv general include file
+#include "highgui.h"  // open cv GUI include file
+
+#include "ipcv_frame_source.h" // threaded prefetching frame source
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_template.h" // template bank
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+using namespace std;
+#include <algorithm> // contains max() function (amongst others)
+using namespace cv; // use c++ namespace so the timing stuff works consistently
+
+/******************************************************************************/
+// setup the cameras properly based on OS platform
+
+// 0 in linux gives first camera for v4l
+//-1 in windows gives first device or user dialog selection
+
+#ifdef linux
+	#define CAMERA_INDEX 0
+#else
+	#define CAMERA_INDEX -1
+#endif
+
+/******************************************************************************/
+
+// global variables (bad pratice yes, but an easy option for a simple demo)
+
+static CvRect selection;		// the area selected by the mouse
+static int select_object = 0;	// has an area been selected
+static CvPoint origin;			// the origin of the selection
+static int image_height;		// height of image
+static int image_origin;		// image origin
+
+// colours for the matches of each template (in turn)
+
+static const CvScalar colours[] = {CV_RGB(255, 0, 0), CV_RGB(0, 255, 0),
+	CV_RGB(0, 0, 255), CV_RGB(255, 255, 0), CV_RGB(0, 255, 255),
+	CV_RGB(255, 0, 255), CV_RGB(255, 128, 0), CV_RGB(128, 0, 255)};
+
+/******************************************************************************/
+
+// Mouse callback function: records a selected ROI in the image
+// parameters:
+// event - opencv mouse event type
+// x - x position of mouse event
+// y - y position of mouse event
+// param - unused
+
+// Notes: based on OpenCV 1.0 camshiftdemo.c example
+
+void set_selected_roi( int event, int x, int y, int flags, void* param )
+{
+	// if we have already clicked and are selecting a region update
+	// the global variable selection
+
+	// first flip the y co-ordinate so we get the correct point
+	// in the image (dependent on image origin)
+
+	if (image_origin)
+		y = image_height - y;
+
+    if( select_object )
+    {
+        selection.x = min(x,origin.x);
+        selection.y = min(y,origin.y);
+        selection.width = selection.x + CV_IABS(x - origin.x);
+        selection.height = selection.y + CV_IABS(y - origin.y);
+
+        selection.x = max( selection.x, 0 );
+        selection.y = max( selection.y, 0 );
+        selection.width -= selection.x;
+        selection.height -= selection.y;
+    }
+
+    switch( event )
+    {
+    case CV_EVENT_LBUTTONDOWN:
+        origin = cvPoint(x,y);
+        selection = cvRect(x,y,0,0);
+        select_object = 1;
+        break;
+    case CV_EVENT_LBUTTONUP:
+        select_object = 0;
+        break;
+    }
+}
+
+/******************************************************************************/
+
+int main( int argc, char** argv )
+{
+
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv, IPCV_REPLAY_INPUT);
+
+  IplImage* img = NULL;      // image object (main)
+  IplImage* img_copy = NULL;      // image object (copy)
+
+  FrameSource* source = NULL; // frame source (video, camera or replay)
+  TemplateBank* bank = NULL; // template bank (all of the templates)
+  std::vector<TemplateDetection> detections; // matches in the current frame
+
+  char const * windowName = "Multiple Template Matching"; // window name
+
+  bool keepProcessing = true;	// loop control flag
+  char key;						// user input
+  int  EVENT_LOOP_DELAY = 40;	// delay for GUI window
+                                // 40 ms equates to 1000ms/25fps = 40ms per frame
+
+  int top = 1;					// matches drawn per template
+  double minScore = 0.9;		// minimum score of a match
+  const char* templateFiles = NULL;	// template images (comma separated)
+
+  CvFont font;
+  cvInitFont(&font, CV_FONT_HERSHEY_PLAIN, 1.0, 1.0, 0, 1, 8);
+
+  // matching options (the remaining argument, if any, is the video)
+
+  int kept = 1;
+  for (int i = 1; i < argc; i++)
+  {
+	  if ((!strcmp(argv[i], "--top")) && (i + 1 < argc)) {
+		  top = std::max(1, atoi(argv[++i]));
+	  } else if ((!strcmp(argv[i], "--min-score")) && (i + 1 < argc)) {
+		  minScore = atof(argv[++i]);
+	  } else if ((!strcmp(argv[i], "--templates")) && (i + 1 < argc)) {
+		  templateFiles = argv[++i];
+	  } else {
+		  argv[kept++] = argv[i];
+	  }
+  }
+  argc = kept;
+
+  // if command line arguments are provided try to read image/video_name
+  // otherwise default to capture from attached H/W camera
+
+    if ((source = create_input_frame_source(argc, argv, CAMERA_INDEX)) != 0)
+    {
+      // create the template bank (correlating spatially, by FFT or either
+      // (--match-engine) with one thread per core)
+
+      bank = create_template_bank(ipcv_template_engine());
+
+      // load any templates given on the command line
+
+      if (templateFiles)
+      {
+		  std::string list(templateFiles);
+		  size_t start = 0;
+		  while (start <= list.size())
+		  {
+			  size_t end = list.find(',', start);
+			  if (end == std::string::npos) {
+				  end = list.size();
+			  }
+			  std::string name = list.substr(start, end - start);
+			  IplImage* templateImg = cvLoadImage(name.c_str(), CV_LOAD_IMAGE_COLOR);
+			  if (templateImg){
+				  add_bank_template(bank, templateImg);
+				  cvReleaseImage( &templateImg );
+			  } else if (!name.empty()) {
+				  printf("ERROR: cannot load template %s\n", name.c_str());
+			  }
+			  start = end + 1;
+		  }
+      }
+
+      // create window object (use flag=0 to allow resize, 1 to auto fix size)
+
+      ipcv_named_window(windowName, 0);
+
+	  printf("\nSelect a region to add a template, press 'c' to clear all templates\n\n");
+
+	  // setup mouse callback
+
+	  ipcv_set_mouse_callback(windowName, set_selected_roi, 0 );
+
+	  // set initial selection to zero (or to that given on the command line,
+	  // clipped to the first frame)
+
+	  selection.width = 0;
+	  selection.height = 0;
+	  bool firstFrame = true;
+
+	  // start main loop
+
+	  while (keepProcessing) {
+
+          int64 timeStart = getTickCount(); // get time at start of loop
+
+		  // capture object in use (i.e. video/camera)
+		  // get image from capture object
+
+			  img = query_frame_source(source);
+			  if(!img){
+				if (argc == 2){
+					printf("End of video file reached\n");
+				} else {
+					printf("ERROR: cannot get next fram from camera\n");
+				}
+				exit(0);
+			  }
+			  image_origin = img->origin;
+			  image_height = img->height;
+
+			  if (firstFrame){
+				ipcv_initial_roi(&selection, cvGetSize(img));
+				firstFrame = false;
+			  }
+
+			  if (img_copy){
+				cvReleaseImage( &img_copy);
+			  }
+			  img_copy = cvCloneImage(img);
+
+		  // *** Template Matching Code
+
+		    // if we have a selection then mark it on the image as
+		    // we make it with the mouse
+
+        	if( select_object && (selection.width > 0) && (selection.height > 0) )
+       		{
+                // first checking it is valid (>0) and within the image bounds
+
+				selection.width = min( selection.width, img->width );
+        		selection.height = min( selection.height, img->height );
+
+            	cvSetImageROI( img, selection );
+            	cvXorS( img, cvScalarAll(255), img, 0 );
+            	cvResetImageROI( img );
+        	}
+
+			// if we have selected a new template within the image add a copy
+			// of it (from the copy, not marked) to the bank
+
+			if ( (!(select_object)) && (selection.width > 0) && (selection.height > 0))
+			{
+				cvSetImageROI( img_copy, selection );
+				int t = add_bank_template(bank, img_copy);
+				cvResetImageROI( img_copy );
+
+				printf("Template %i added (%i x %i)\n", t, selection.width,
+						selection.height);
+
+				selection.width = 0;
+				selection.height = 0;
+			}
+
+			// match all of the templates and draw the best matches of each
+
+			if (bank_template_count(bank) > 0){
+
+				match_template_bank(bank, img, top, minScore, &detections);
+
+				for (size_t i = 0; i < detections.size(); i++)
+				{
+					TemplateDetection& d = detections[i];
+					CvScalar colour = colours[d.templ %
+											  (sizeof(colours) / sizeof(colours[0]))];
+					char label[16];
+
+					cvRectangle(img, d.location,
+								cvPoint(d.location.x + d.size.width,
+										d.location.y + d.size.height),
+								colour, 1, 8, 0);
+					sprintf(label, "%i", d.templ);
+					cvPutText(img, label, cvPoint(d.location.x + 2, d.location.y + 12),
+							  &font, colour);
+				}
+			}
+
+		  // ***
+
+		  // display image in window
+
+		  ipcv_show_image( windowName, img );
+
+		  // start event processing loop (very important,in fact essential for GUI)
+	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
+
+		  // here we take account of processing time for the loop by subtracting the time
+          // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
+          // we get a +ve wait time
+
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
+                        (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
+
+		  if (key == 'x'){
+
+	   		// if user presses "x" then exit
+
+	   			printf("Keyboard exit requested : exiting now - bye!\n");
+	   			keepProcessing = false;
+		  } else if (key == 'c'){
+
+	   		// if user presses "c" then clear all of the templates
+
+				printf("Templates cleared by user request\n");
+
+				clear_template_bank(bank);
+
+				selection.width = 0;
+				selection.height = 0;
+		  }
+	  }
+
+      // destroy window objects
+      // (triggered by event loop *only* window is closed)
+
+      ipcv_destroy_all_windows();
+
+      // destroy image objects (if it does not originate from a capture object)
+
+	  cvReleaseImage ( &img_copy);
+
+	  release_template_bank( &bank );
+
+	  // release frame source (and capture device)
+
+	  release_frame_source(&source);
+
+      // all OK : main returns 0
+
+      return 0;
+    }
+
+    // not OK : main returns -1
+
+    return -1;
+}
+/******************************************************************************/
@@ -9,6 +9,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -30,6 +33,10 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img;  			 		// input image object
   IplImage* openImage = NULL;  		// open image object
   IplImage* closeImage = NULL;      // close image object
@@ -59,18 +66,18 @@ int main( int argc, char** argv )
     {
       // create window objects
 
-      cvNamedWindow(windowName1, 0 );
-      cvNamedWindow(windowName2, 0 );
-	  cvNamedWindow("controls", 0 );
+      ipcv_named_window(windowName1, 0 );
+      ipcv_named_window(windowName2, 0 );
+	  ipcv_named_window("controls", 0 );
 
 	  // init. user controls
 
 	  rows = 1;
 	  columns = 1;
 	  iterations = 1;
-	  cvCreateTrackbar("Element rows", "controls", &rows, 15, NULL);
-	  cvCreateTrackbar("Element columns", "controls", &columns, 15, NULL);
-	  cvCreateTrackbar("iterations", "controls", &iterations, 25, NULL);
+	  ipcv_create_trackbar("Element rows", "controls", &rows, 15, NULL);
+	  ipcv_create_trackbar("Element columns", "controls", &columns, 15, NULL);
+	  ipcv_create_trackbar("iterations", "controls", &iterations, 25, NULL);
 
 
 	  // if capture object in use (i.e. video/camera)
@@ -78,10 +85,10 @@ int main( int argc, char** argv )
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -113,10 +120,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -134,6 +141,8 @@ int main( int argc, char** argv )
 		  if (rows < 1){rows++;}
 		  if (columns < 1) {columns++;}
 		  if (iterations < 1) {iterations++;}
+		  int64 processStart = ipcv_timing_start(); // (timing of morphology)
+
 		  structuringElement = cvCreateStructuringElementEx(rows, columns,
 		  		cvFloor(rows / 2), cvFloor(columns / 2), CV_SHAPE_RECT, NULL);
 
@@ -146,10 +155,12 @@ int main( int argc, char** argv )
 
 		  cvReleaseStructuringElement(&structuringElement);
 
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 		  // display images in window
 
-		  cvShowImage( windowName1, openImage );
-		  cvShowImage( windowName2, closeImage );
+		  ipcv_show_image( windowName1, openImage );
+		  ipcv_show_image( windowName2, closeImage );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 4 ms roughly equates to 100ms/25fps = 4ms per frame
@@ -158,7 +169,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -173,7 +184,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
@@ -9,6 +9,10 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+#include "ipcv_histogram.h" // shared histogram functions
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -27,42 +31,13 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 
 /******************************************************************************/
 
-// function that takes a gray scale image and draws a histogram
-// image for it in a pre-allocated image
-
-void create_histogram_image(IplImage* grayImg, IplImage* histogramImage){
-
-  CvHistogram *hist = NULL;	    // pointer to histogram object
-  float max_value = 0;			// max value in histogram
-  int hist_size = 256;			// size of histogram (number of bins)
-  int bin_w = 0;				// initial width to draw bars
-  float range_0[]={0,256};
-  float* ranges[] = { range_0 };
-
-  hist = cvCreateHist(1, &hist_size, CV_HIST_ARRAY, ranges, 1);
-
-  cvCalcHist( &grayImg, hist, 0, NULL );
-  cvGetMinMaxHistValue( hist, 0, &max_value, 0, 0 );
-  cvScale( hist->bins, hist->bins, ((double)histogramImage->height)/max_value, 0 );
-  cvSet( histogramImage, cvScalarAll(255), 0 );
-  bin_w = cvRound((double)histogramImage->width/hist_size);
-
-  for(int i = 0; i < hist_size; i++ )
-  {
-     cvRectangle( histogramImage, cvPoint(i*bin_w, histogramImage->height),
-                  cvPoint((i+1)*bin_w, histogramImage->height
-	  								- cvRound(cvGetReal1D(hist->bins,i))),
-                   					cvScalarAll(0), -1, 8, 0 );
-  }
-
-  cvReleaseHist (&hist);
-}
-
-/******************************************************************************/
-
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
   CvCapture* capture = NULL; // capture object
 
@@ -87,18 +62,18 @@ int main( int argc, char** argv )
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
-	  cvCreateTrackbar("grad. NxN", windowName, &gneighbourhoodSize, 7, NULL);
-	  cvCreateTrackbar("smooth NxN", windowName, &sneighbourhoodSize, 15, NULL);
+      ipcv_named_window(windowName, 0);
+	  ipcv_create_trackbar("grad. NxN", windowName, &gneighbourhoodSize, 7, NULL);
+	  ipcv_create_trackbar("smooth NxN", windowName, &sneighbourhoodSize, 15, NULL);
 
 	 // (if using a capture object we need to get a frame first to get the size)
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -131,10 +106,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame is just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -163,6 +138,8 @@ int main( int argc, char** argv )
 
 		  // smooth the image
 
+		  int64 processStart = ipcv_timing_start(); // (timing of gradient orientation)
+
 		  cvSmooth(img, imgSmooth, CV_GAUSSIAN, sneighbourhoodSize);
 
 
@@ -182,9 +159,11 @@ int main( int argc, char** argv )
 
 		  cvConvertScale(grad_orientation,  grad_orientation, 10, 0);
 
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 		  // display image in window
 
-		  cvShowImage( windowName, grad_orientation );
+		  ipcv_show_image( windowName, grad_orientation );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
@@ -193,7 +172,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -208,7 +187,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
@@ -0,0 +1,141 @@
+// Example : chain of processing stages applied to image / video / camera
+// usage: prog <stage>[,<stage> ...] {<image_name> | <video_name>}
+// e.g.   prog gray,gaussian:5,canny:50:200 video.avi
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: the stages are those of the individual examples (see ipcv_stage.h)
+// run one after the other in a single process on each frame
+
+#include "cv.h"       // open cv general include file
+#include "highgui.h"  // open cv GUI include file
+
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_frame_source.h" // threaded prefetching frame source
+#include "ipcv_stage.h" // uniform processing stages
+
+#include <stdio.h>
+#include <algorithm> // contains max() function (amongst others)
+using namespace cv; // use c++ namespace so the timing stuff works consistently
+
+/******************************************************************************/
+// setup the cameras properly based on OS platform
+
+// 0 in linux gives first camera for v4l
+//-1 in windows gives first device or user dialog selection
+
+#ifdef linux
+	#define CAMERA_INDEX 0
+#else
+	#define CAMERA_INDEX -1
+#endif
+
+/******************************************************************************/
+
+int main( int argc, char** argv )
+{
+
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv, IPCV_REPLAY_INPUT);
+
+  IplImage* img = NULL;      // image object
+  IplImage* output = NULL;   // output of processing chain
+  FrameSource* source = NULL; // frame source (image, video or camera)
+  StageChain* chain = NULL;  // processing stages
+
+  char const * windowName = "Processing Chain"; // window name
+  char const * windowNameInput = "Input"; // window name
+
+  bool keepProcessing = true;	// loop control flag
+  char key;						// user input
+  int  EVENT_LOOP_DELAY = 40;	// delay for GUI window
+                                // 40 ms equates to 1000ms/25fps = 40ms per frame
+
+  // first argument is the list of stages, then (optionally) the input
+
+  if ((argc < 2) || !(chain = create_stage_chain(argv[1]))){
+	  printf("usage: %s <stage>[,<stage> ...] {<image_name> | <video_name>}\n", argv[0]);
+	  return -1;
+  }
+
+  // if command line arguments are provided try to read image/video_name
+  // otherwise default to capture from attached H/W camera
+
+  if ((source = create_input_frame_source(argc - 1, argv + 1, CAMERA_INDEX)) != 0)
+    {
+      // create window objects (use flag=0 to allow resize, 1 to auto fix size)
+
+      ipcv_named_window(windowName, 0);
+      ipcv_named_window(windowNameInput, 0);
+
+	  // start main loop
+
+	  while (keepProcessing) {
+
+          int64 timeStart = getTickCount(); // get time at start of loop
+
+		  // get next image from frame source
+
+		  img = query_frame_source(source);
+		  if(!img){
+			printf("End of video file reached\n");
+			break;
+		  }
+
+		  if (frame_source_is_image(source)){
+
+			  // if not a video / camera set event delay to zero so it waits
+			  // indefinitely (as single image file, no need to loop)
+
+			  EVENT_LOOP_DELAY = 0;
+		  }
+
+		  // run the chain of stages
+
+		  output = chain->process(img);
+
+		  // display image in window
+
+		  ipcv_show_image( windowName, output );
+		  ipcv_show_image( windowNameInput, img );
+
+		  // start event processing loop (very important,in fact essential for GUI)
+	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
+
+		  // here we take account of processing time for the loop by subtracting the time
+          // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
+          // we get a +ve wait time
+
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
+                        (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
+
+		  if (key == 'x'){
+
+	   		// if user presses "x" then exit
+
+	   			printf("Keyboard exit requested : exiting now - bye!\n");
+	   			keepProcessing = false;
+		  }
+	  }
+
+      // destroy window objects
+
+      ipcv_destroy_all_windows();
+
+      // release frame source and processing stages
+
+      release_frame_source(&source);
+      delete chain;
+
+      // all OK : main returns 0
+
+      return 0;
+    }
+
+    // not OK : main returns -1
+
+    delete chain;
+    return -1;
+}
+/******************************************************************************/
@@ -0,0 +1,115 @@
+// Example : convert a video (or camera input) to a raw frame file
+// usage: prog [--planar] [--max-frames <N>] <output_name> {<video_name>}
+
+// License : LGPL - http://www.gnu.org/licenses/lgpl.html
+
+// Notes: the raw frame file (see ipcv_raw_frames.h) can then be given to the
+// examples in place of the video - each frame is memory mapped rather than
+// decoded, so repeated runs over the same footage run at memory speed
+
+#include "cv.h"       // open cv general include file
+#include "highgui.h"  // open cv GUI include file
+
+#include "ipcv_interface.h" // shared command line options
+#include "ipcv_frame_source.h" // threaded prefetching frame source
+#include "ipcv_raw_frames.h" // raw frame file container
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/******************************************************************************/
+// setup the cameras properly based on OS platform
+
+// 0 in linux gives first camera for v4l
+//-1 in windows gives first device or user dialog selection
+
+#ifdef linux
+	#define CAMERA_INDEX 0
+#else
+	#define CAMERA_INDEX -1
+#endif
+
+/******************************************************************************/
+
+int main( int argc, char** argv )
+{
+
+  // process any shared command line options
+
+  ipcv_parse_options(&argc, argv, IPCV_REPLAY_INPUT);
+
+  IplImage* img = NULL;			// image object
+  FrameSource* source = NULL;	// frame source (video or camera)
+  RawFrameWriter* writer = NULL;	// raw frame file
+  int layout = IPCV_RAW_INTERLEAVED;	// layout of frames in the file
+  long maxFrames = 0;			// maximum frames to convert (0 = all)
+  long frames = 0;				// frames converted so far
+
+  // conversion options (the remaining arguments are output and input)
+
+  int kept = 1;
+  for (int i = 1; i < argc; i++)
+  {
+	  if (!strcmp(argv[i], "--planar")) {
+		  layout = IPCV_RAW_PLANAR;
+	  } else if ((!strcmp(argv[i], "--max-frames")) && (i + 1 < argc)) {
+		  maxFrames = atol(argv[++i]);
+	  } else {
+		  argv[kept++] = argv[i];
+	  }
+  }
+  argc = kept;
+
+  if ((argc < 2) || (argc > 3)){
+	  printf("usage: %s [--planar] [--max-frames <N>] <output_name> {<video_name>}\n",
+			 argv[0]);
+	  return -1;
+  }
+
+  // input is the video named after the output (or the camera)
+
+  if ((source = create_input_frame_source(argc - 1, argv + 1, CAMERA_INDEX)) == 0){
+	  printf("ERROR: cannot open input\n");
+	  return -1;
+  }
+
+  while (((maxFrames == 0) || (frames < maxFrames)) &&
+		 ((img = query_frame_source(source)) != NULL))
+  {
+	  // create the file from the first frame
+
+	  if (!writer){
+		  writer = create_raw_frame_writer(argv[1], cvGetSize(img), img->depth,
+										   img->nChannels, img->origin, layout);
+		  if (!writer){
+			  printf("ERROR: cannot create raw frame file %s\n", argv[1]);
+			  release_frame_source(&source);
+			  return -1;
+		  }
+	  }
+
+	  if (!write_raw_frame(writer, img)){
+		  printf("ERROR: cannot write frame %li (disk full or size changed?)\n",
+				 frames);
+		  break;
+	  }
+	  frames++;
+
+	  // a single image is returned on every query - so only write it once
+
+	  if (frame_source_is_image(source)){
+		  break;
+	  }
+  }
+
+  release_raw_frame_writer(&writer);
+  release_frame_source(&source);
+
+  printf("%li frames written to %s\n", frames, argv[1]);
+
+  // all OK : main returns 0
+
+  return 0;
+}
+/******************************************************************************/
@@ -9,6 +9,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -30,6 +33,10 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
   IplImage* zoomed = NULL;      // image object
   IplImage* imgOutput = NULL;      // image object
@@ -63,13 +70,13 @@ int main( int argc, char** argv )
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
-	  cvCreateTrackbar("angle", windowName, &angle, 360, NULL);
-	  cvCreateTrackbar("zoom", windowName, &zoom, 10, NULL);
+      ipcv_named_window(windowName, 0);
+	  ipcv_create_trackbar("angle", windowName, &angle, 360, NULL);
+	  ipcv_create_trackbar("zoom", windowName, &zoom, 10, NULL);
 
 	  // capture an initial image to get dimensions
 
-	  img = cvQueryFrame(capture);
+	  img = ipcv_query_frame(capture);
 	  if(!img){
 		if (argc == 2){
 				printf("End of video file reached\n");
@@ -93,10 +100,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame is just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -116,6 +123,8 @@ int main( int argc, char** argv )
 
 		  // *** ZOOM the image if zoom > 1
 
+		  int64 processStart = ipcv_timing_start(); // (timing of zoom and rotation)
+
 		  if (zoom > 1){
 
             // calculate a zoom sub-region (in the centre of the image)
@@ -162,11 +171,13 @@ int main( int argc, char** argv )
 			cvCopy(zoomed, imgOutput, NULL);
 		  }
 
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 		  // ***
 
 		  // display image in window
 
-		  cvShowImage( windowName, imgOutput );
+		  ipcv_show_image( windowName, imgOutput );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
@@ -175,7 +186,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -199,7 +210,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
@@ -1,5 +1,5 @@
 // Example : template matching for video / camera
-// usage: prog {<video_name>}
+// usage: prog [--roi <x,y,w,h>] {<video_name>}
 
 // Author : Toby Breckon, toby.breckon@cranfield.ac.uk
 
@@ -9,6 +9,10 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_frame_source.h" // threaded prefetching frame source
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_template.h" // coarse to fine template matching
+
 #include <stdio.h>
 using namespace std;
 #include <algorithm> // contains max() function (amongst others)
@@ -89,12 +93,18 @@ void set_selected_roi( int event, int x, int y, int flags, void* param )
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv, IPCV_REPLAY_INPUT);
+
   IplImage* img = NULL;      // image object (main)
   IplImage* img_copy = NULL;      // image object (copy)
   IplImage* templateImg = NULL;      // image object (template)
-  IplImage* response = NULL;      // image object (template)
+  IplImage responseHeader;      // image header (correlation response)
+  IplImage* response = NULL;      // image object (correlation response)
+  TemplateMatcher* matcher = NULL; // template matcher (template pyramid)
 
-  CvCapture* capture = NULL; // capture object
+  FrameSource* source = NULL; // frame source (video, camera or replay)
 
   char const * windowName = "Correlation Based Template Matching"; // window name
   char const * windowName2 = "Correlation Response"; // window name
@@ -104,34 +114,33 @@ int main( int argc, char** argv )
   int  EVENT_LOOP_DELAY = 40;	// delay for GUI window
                                 // 40 ms equates to 1000ms/25fps = 40ms per frame
 
-  double min_val; double max_val;	// min/max response values for correlation
-  CvPoint min_loc; CvPoint max_loc; // min/max response locations for correlation
+  double max_val;	// max response value for correlation
+  CvPoint max_loc; // max response location for correlation
 
   CvPoint detectionU; CvPoint detectionL; // Upper and Lower co-ordinates of template match
 
   // if command line arguments are provided try to read image/video_name
   // otherwise default to capture from attached H/W camera
 
-    if(
-	  ( argc == 2 && (capture = cvCreateFileCapture( argv[1] )) != 0 ) ||
-	  ( argc != 2 && (capture = cvCreateCameraCapture( CAMERA_INDEX )) != 0 )
-	  )
+    if ((source = create_input_frame_source(argc, argv, CAMERA_INDEX)) != 0)
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
-	  cvNamedWindow(windowName2, 0);
+      ipcv_named_window(windowName, 0);
+	  ipcv_named_window(windowName2, 0);
 
 	  printf("\nPress 'c' to reset template\n\n");
 
 	  // setup mouse callback
 
-	  cvSetMouseCallback(windowName, set_selected_roi, 0 );
+	  ipcv_set_mouse_callback(windowName, set_selected_roi, 0 );
 
-	  // set initial selection to zero
+	  // set initial selection to zero (or to that given on the command line,
+	  // clipped to the first frame)
 
 	  selection.width = 0;
 	  selection.height = 0;
+	  bool firstFrame = true;
 
 	  // start main loop
 
@@ -142,7 +151,7 @@ int main( int argc, char** argv )
 		  // capture object in use (i.e. video/camera)
 		  // get image from capture object
 
-			  img = cvQueryFrame(capture);
+			  img = query_frame_source(source);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -154,6 +163,11 @@ int main( int argc, char** argv )
 			  image_origin = img->origin;
 			  image_height = img->height;
 
+			  if (firstFrame){
+				ipcv_initial_roi(&selection, cvGetSize(img));
+				firstFrame = false;
+			  }
+
 			  if (img_copy){
 				cvReleaseImage( &img_copy);
 			  }
@@ -198,16 +212,23 @@ int main( int argc, char** argv )
 				cvCopy(img_copy, templateImg, NULL);
 				cvResetImageROI( img_copy );
 
-				// we can also now create the output space for the cross correlation
-				// (N.B. the difference in dimensions indicates how the image borders will
-				// be handled!)
+				// and build its image pyramid (--pyramid <levels>) for matching
+				// (re-using the matcher buffers if the template has been reset)
 
-				if (response){
-					cvReleaseImage( &response);
+				if (matcher){
+					set_matcher_template(matcher, templateImg, ipcv_template_levels());
+				} else {
+					matcher = create_template_matcher(templateImg, ipcv_template_levels());
 				}
-				response = cvCreateImage(cvSize(img->width - selection.width + 1, img->height - selection.height + 1),
-									   IPL_DEPTH_32F, 1);
-				response->origin = img->origin;
+
+				// optionally only search around the previous match (--track <margin>)
+
+				set_template_tracking(matcher, ipcv_track_margin(),
+									  ipcv_template_track_threshold());
+
+				// and correlate spatially, by FFT or either (--match-engine)
+
+				set_template_engine(matcher, ipcv_template_engine());
 
 			}
 
@@ -215,13 +236,16 @@ int main( int argc, char** argv )
 
 			if (templateImg){
 
-				// use match template function with normalised cross correlation specified
+				// match the template (normalised cross correlation) coarse to fine
+				// and find the maximal response
 
-				cvMatchTemplate(img, templateImg, response, CV_TM_CCORR_NORMED);
+				max_val = match_template(matcher, img, &max_loc);
 
-				// find the maximal response
+				// the response displayed is that of the (coarsest level) search
+				// of the whole frame or of the tracking window
 
-				cvMinMaxLoc(response, &min_val, &max_val, &min_loc, &max_loc, NULL);
+				response = cvGetImage(matcher->response, &responseHeader);
+				response->origin = img->origin;
 
 				// draw the detected result
 
@@ -231,14 +255,23 @@ int main( int argc, char** argv )
 				detectionL.y = detectionU.y + templateImg->height;
 				cvRectangle(img, detectionU, detectionL, CV_RGB(255, 0, 0), 1, 8, 0);
 
+				// and the tracking window searched (if the whole frame was not)
+
+				if (!(matcher->global)){
+					cvRectangle(img, cvPoint(matcher->window.x, matcher->window.y),
+								cvPoint(matcher->window.x + matcher->window.width - 1,
+										matcher->window.y + matcher->window.height - 1),
+								CV_RGB(0, 0, 255), 1, 8, 0);
+				}
+
 			}
 
 		  // ***
 
 		  // display image in window
 
-		  cvShowImage( windowName, img );
-		  cvShowImage( windowName2, response );
+		  ipcv_show_image( windowName, img );
+		  ipcv_show_image( windowName2, response );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
@@ -247,7 +280,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -276,7 +309,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image objects (if it does not originate from a capture object)
 
@@ -286,9 +319,11 @@ int main( int argc, char** argv )
 
 	  cvReleaseImage ( &img_copy);
 
-	  if (!response){
-		cvReleaseImage ( & response );
-	  }
+	  release_template_matcher( &matcher );
+
+	  // release frame source (and capture device)
+
+	  release_frame_source(&source);
 
       // all OK : main returns 0
 
@@ -9,6 +9,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -30,6 +33,10 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img;  			 // input image object
   IplImage* redImg = NULL;  // red image channel
   IplImage* greenImg = NULL; // green image channel
@@ -66,28 +73,28 @@ int main( int argc, char** argv )
 
       // create window objects
 
-      cvNamedWindow(windowName1B, 1 );
-	  cvNamedWindow(windowName1G, 1 );
-	  cvNamedWindow(windowName1R, 1 );
-      cvNamedWindow(windowName2B, 1 );
-	  cvNamedWindow(windowName2G, 1 );
-	  cvNamedWindow(windowName2R, 1 );
+      ipcv_named_window(windowName1B, 1 );
+	  ipcv_named_window(windowName1G, 1 );
+	  ipcv_named_window(windowName1R, 1 );
+      ipcv_named_window(windowName2B, 1 );
+	  ipcv_named_window(windowName2G, 1 );
+	  ipcv_named_window(windowName2R, 1 );
 
 	  // add adjustable trackbar for threshold parameters
 
-      cvCreateTrackbar("Threshold", windowName1B, &thresholdB, 255, NULL);
-	  cvCreateTrackbar("Threshold", windowName1G, &thresholdG, 255, NULL);
-	  cvCreateTrackbar("Threshold", windowName1R, &thresholdR, 255, NULL);
+      ipcv_create_trackbar("Threshold", windowName1B, &thresholdB, 255, NULL);
+	  ipcv_create_trackbar("Threshold", windowName1G, &thresholdG, 255, NULL);
+	  ipcv_create_trackbar("Threshold", windowName1R, &thresholdR, 255, NULL);
 
 	  // if capture object in use (i.e. video/camera)
 	  // get initial image from capture object
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -124,10 +131,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -141,6 +148,8 @@ int main( int argc, char** argv )
 
 		  // if input is not already single channel, extract channels
 
+	      int64 convertStart = ipcv_timing_start(); // (timing of channel split)
+
 	      if (img->nChannels > 1){
 			cvSplit(img, blueImg, greenImg, redImg, NULL); // remember BGR ordering!
 
@@ -148,20 +157,30 @@ int main( int argc, char** argv )
 			redImg = greenImg = blueImg = img;
 	     }
 
+	      ipcv_timing_stop(IPCV_TIMING_CONVERT, convertStart);
+
     	 // display images
 
-	     cvShowImage( windowName2B, blueImg );
-	     cvShowImage( windowName2G, greenImg );
-	     cvShowImage( windowName2R, redImg );
+	     ipcv_show_image( windowName2B, blueImg );
+	     ipcv_show_image( windowName2G, greenImg );
+	     ipcv_show_image( windowName2R, redImg );
 
 		 // threshold each and display them
 
+		 int64 processStart = ipcv_timing_start(); // (timing of thresholding)
 		 cvThreshold(blueImg, thresholdedImg, thresholdB, 255, CV_THRESH_BINARY);
-		 cvShowImage( windowName1B, thresholdedImg );
+		 ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+		 ipcv_show_image( windowName1B, thresholdedImg );
+
+		 processStart = ipcv_timing_start();
 		 cvThreshold(greenImg, thresholdedImg, thresholdG, 255, CV_THRESH_BINARY);
-		 cvShowImage( windowName1G, thresholdedImg );
+		 ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+		 ipcv_show_image( windowName1G, thresholdedImg );
+
+		 processStart = ipcv_timing_start();
 		 cvThreshold(redImg, thresholdedImg, thresholdR, 255, CV_THRESH_BINARY);
-		 cvShowImage( windowName1R, thresholdedImg );
+		 ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+		 ipcv_show_image( windowName1R, thresholdedImg );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 4 ms roughly equates to 100ms/25fps = 4ms per frame
@@ -170,7 +189,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -185,7 +204,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image objects (if it does not originate from a capture object)
 
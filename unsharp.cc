@@ -9,6 +9,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_interface.h" // headless aware display interface
+#include "ipcv_timing.h" // per stage timing (--timing)
+
 #include <stdio.h>
 #include <algorithm> // contains max() function (amongst others)
 using namespace cv; // use c++ namespace so the timing stuff works consistently
@@ -30,6 +33,10 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv);
+
   IplImage* img = NULL;      // image object
   CvCapture* capture = NULL; // capture object
 
@@ -57,23 +64,23 @@ int main( int argc, char** argv )
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName1, 0);
-	  cvNamedWindow(windowName2, 0);
+      ipcv_named_window(windowName1, 0);
+	  ipcv_named_window(windowName2, 0);
 
 	  // add adjustable trackbar for parameter
 
-	  cvCreateTrackbar("k (* 0.1)", windowName1, &k_mult, 100, NULL);
-	  cvCreateTrackbar("smooth NxN", windowName1, &windowSize, 10, NULL);
+	  ipcv_create_trackbar("k (* 0.1)", windowName1, &k_mult, 100, NULL);
+	  ipcv_create_trackbar("smooth NxN", windowName1, &windowSize, 10, NULL);
 
 	  // define required images for intermediate processing
       // (if using a capture object we need to get a frame first to get the size)
 
 	  if (capture) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+		  // cvGrabFrame and cvRetrieveFrame in one call.
 
-		  img = cvQueryFrame(capture);
+		  img = ipcv_query_frame(capture);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -114,10 +121,10 @@ int main( int argc, char** argv )
 
 		  if (capture) {
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // ipcv_query_frame (a timed cvQueryFrame) is just a combination of
+			  // cvGrabFrame and cvRetrieveFrame in one call.
 
-			  img = cvQueryFrame(capture);
+			  img = ipcv_query_frame(capture);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -133,6 +140,7 @@ int main( int argc, char** argv )
 		  // if input is not already grayscale, convert to grayscale
 
 			  if (img->nChannels > 1){
+				  IpcvScopedTimer timer(IPCV_TIMING_CONVERT);
 				  cvCvtColor(img, grayImg, CV_BGR2GRAY);
 			  } else {
 				  grayImg = img;
@@ -140,6 +148,8 @@ int main( int argc, char** argv )
 
 		  // check that the window size is always odd and > 3
 
+		  int64 processStart = ipcv_timing_start(); // (timing of unsharp masking)
+
 		  if ((windowSize > 3) && (fmod((double) windowSize, 2) == 0)) {
 				windowSize++;
 		  } else if (windowSize < 3) {
@@ -152,10 +162,12 @@ int main( int argc, char** argv )
           cvSub(grayImg, smooth, subtracted, NULL);
 		  cvAddWeighted(grayImg, 1, subtracted, (k * k_mult), 0, unsharp);
 
+		  ipcv_timing_stop(IPCV_TIMING_PROCESS, processStart);
+
 		  // display images in window
 
-		  cvShowImage( windowName1, unsharp );
-		  cvShowImage( windowName2, grayImg );
+		  ipcv_show_image( windowName1, unsharp );
+		  ipcv_show_image( windowName2, grayImg );
 
 		  // start event processing loop (very important,in fact essential for GUI)
 	      // 40 ms roughly equates to 1000ms/25fps = 4ms per frame
@@ -164,7 +176,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -179,7 +191,7 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image objects (if it does not originate from a capture object)
 
@@ -9,6 +9,9 @@
 #include "cv.h"       // open cv general include file
 #include "highgui.h"  // open cv GUI include file
 
+#include "ipcv_frame_source.h" // threaded prefetching frame source
+#include "ipcv_interface.h" // headless aware display interface
+
 #include <stdio.h>
 #include <limits.h>
 
@@ -33,8 +36,12 @@ using namespace cv; // use c++ namespace so the timing stuff works consistently
 int main( int argc, char** argv )
 {
 
+  // process any shared command line options (e.g. --headless)
+
+  ipcv_parse_options(&argc, argv, IPCV_REPLAY_INPUT);
+
   IplImage* img = NULL;      // image object
-  CvCapture* capture = NULL; // capture object
+  FrameSource* source = NULL; // frame source (video, raw frames or camera)
 
   char const * windowName = "Watershed Segmentation"; // window name
 
@@ -48,31 +55,29 @@ int main( int argc, char** argv )
   int windowSize = 3;		// canny edge window size
 
   // if command line arguments are provided try to read image/video_name
-  // otherwise default to capture from attached H/W camera
+  // (or raw frame file) otherwise default to capture from attached H/W camera
 
     if(
 	  ( argc == 2 && (img = cvLoadImage( argv[1], 1)) != 0 ) ||
-	  ( argc == 2 && (capture = cvCreateFileCapture( argv[1] )) != 0 ) ||
-	  ( argc != 2 && (capture = cvCreateCameraCapture( 0 )) != 0 )
+	  ( (source = create_input_frame_source(argc, argv, 0)) != 0 )
 	  )
     {
       // create window object (use flag=0 to allow resize, 1 to auto fix size)
 
-      cvNamedWindow(windowName, 0);
-  	  cvCreateTrackbar("Lower", windowName, &lowerThreshold, 255, NULL);
-  	  cvCreateTrackbar("Upper", windowName, &upperThreshold, 255, NULL);
-  	  cvCreateTrackbar("Window", windowName, &windowSize, 7, NULL);
+      ipcv_named_window(windowName, 0);
+  	  ipcv_create_trackbar("Lower", windowName, &lowerThreshold, 255, NULL);
+  	  ipcv_create_trackbar("Upper", windowName, &upperThreshold, 255, NULL);
+  	  ipcv_create_trackbar("Window", windowName, &windowSize, 7, NULL);
 
 	  // define working images
 
 	  // (if using a capture object we need to get a frame first to get the size)
 
-	  if (capture) {
+	  if (source) {
 
-		  // cvQueryFrame s just a combination of cvGrabFrame
-		  // and cvRetrieveFrame in one call.
+		  // get the first frame from the frame source (replaces cvQueryFrame)
 
-		  img = cvQueryFrame(capture);
+		  img = query_frame_source(source);
 		  if(!img){
 			if (argc == 2){
 				printf("End of video file reached\n");
@@ -121,12 +126,12 @@ int main( int argc, char** argv )
 		  // if capture object in use (i.e. video/camera)
 		  // get image from capture object
 
-		  if (capture) {
+		  if (source) {
 
-			  // cvQueryFrame s just a combination of cvGrabFrame
-			  // and cvRetrieveFrame in one call.
+			  // get the next frame from the frame source
+			  // (replaces cvQueryFrame - the frame is valid until the next call)
 
-			  img = cvQueryFrame(capture);
+			  img = query_frame_source(source);
 			  if(!img){
 				if (argc == 2){
 					printf("End of video file reached\n");
@@ -213,7 +218,7 @@ int main( int argc, char** argv )
 
 		  // display image in window
 
-		  cvShowImage( windowName, wshed );
+		  ipcv_show_image( windowName, wshed );
 
 
 		  // start event processing loop (very important,in fact essential for GUI)
@@ -223,7 +228,7 @@ int main( int argc, char** argv )
           // taken in ms. from this (1000ms/25fps = 40ms per frame) value whilst ensuring
           // we get a +ve wait time
 
-          key = cvWaitKey((int) std::max(2.0, EVENT_LOOP_DELAY -
+          key = ipcv_wait_key((int) std::max(2.0, EVENT_LOOP_DELAY -
                         (((getTickCount() - timeStart) / getTickFrequency()) * 1000)));
 
 		  if (key == 'x'){
@@ -237,13 +242,16 @@ int main( int argc, char** argv )
       // destroy window objects
       // (triggered by event loop *only* window is closed)
 
-      cvDestroyAllWindows();
+      ipcv_destroy_all_windows();
 
       // destroy image object (if it does not originate from a capture object)
 
-      if (!capture){
+      if (!source){
 		  cvReleaseImage( &img );
-      }
+      }	else {
+		  // release frame source (and capture device)
+		  release_frame_source(&source);
+	  }
 	  cvReleaseImage( &grayImg );
 	  cvReleaseImage( &edges );
 	  cvReleaseImage( &output );